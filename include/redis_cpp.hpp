@@ -12,15 +12,28 @@
 
 #include <redis_cpp/detail/config.hpp>
 #include <redis_cpp/internal/logger_handler.hpp>
+#include <redis_cpp/detail/circuit_breaker.hpp>
 #include <redis_cpp/detail/sentinel/sentinel_client_pool.hpp>
+#include <redis_cpp/detail/sentinel/sentinel_failover_option.hpp>
+#include <redis_cpp/detail/sentinel/sentinel_replica_option.hpp>
 #include <redis_cpp/detail/sync/standalone_sync_client_pool.hpp>
+#include <redis_cpp/detail/sync/replica_read_option.hpp>
+#include <redis_cpp/detail/sync/replica_selector.hpp>
 #include <redis_cpp/detail/sync/cluster_sync_client.hpp>
 #include <redis_cpp/detail/sync/sentinel_sync_client.hpp>
+#include <redis_cpp/detail/sync/multiplexed_sync_client.hpp>
+#include <redis_cpp/detail/sync/near_cache_sync_client.hpp>
+#include <redis_cpp/detail/sync/single_flight_sync_client.hpp>
+#include <redis_cpp/detail/sync/sharded_sync_client.hpp>
 #include <redis_cpp/detail/sync/redis_sync_operator.hpp>
+#include <redis_cpp/detail/sync/redis_transaction.hpp>
 #include <redis_cpp/detail/async/standalone_async_client.hpp>
+#include <redis_cpp/detail/async/standalone_async_client_pool.hpp>
 #include <redis_cpp/detail/async/cluster_async_client.hpp>
 #include <redis_cpp/detail/async/sentinel_async_client.hpp>
+#include <redis_cpp/detail/async/fire_and_forget_async_client.hpp>
 #include <redis_cpp/detail/async/redis_async_operator.hpp>
+#include <redis_cpp/detail/async/redis_coroutine_operator.hpp>
 
 namespace redis_cpp
 {
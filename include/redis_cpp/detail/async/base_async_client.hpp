@@ -12,6 +12,7 @@
 #define __ydk_rediscpp_detail_base_async_client_hpp__
 
 #include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/redis_command.hpp>
 #include <redis_cpp/redis_reply.hpp>
 #include <functional>
 #include <memory>
@@ -64,6 +65,27 @@ public:
     virtual void publish(const std::string& channel_name, 
         const std::string& message, 
         const reply_handler& reply_handler) = 0;
+
+    /**
+     * @brief do command
+     * @param cmd - the command
+     * @param hash_slot - the hash slot of the command key, -1 if no key related
+     * @param handler - the reply handler, the reply is null if the command failed
+     */
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        const reply_handler& handler) = 0;
+
+    /**
+     * @brief do command, the handler could be moved into the request
+     * instead of copied
+     */
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        reply_handler&& handler){
+        do_command(cmd, hash_slot, static_cast<const reply_handler&>(handler));
+    }
+
+    /** is cluster mode */
+    virtual bool cluster_mode() = 0;
 };
 }
 }
@@ -12,39 +12,84 @@
 #define __ydk_rediscpp_detail_cluster_async_client_hpp__
 
 #include <redis_cpp/detail/config.hpp>
-#include <redis_cpp/detail/async/standalone_async_client.hpp>
+#include <redis_cpp/detail/async/standalone_async_client_pool.hpp>
 #include <redis_cpp/detail/sync/redis_sync_operator.hpp>
 #include <redis_cpp/detail/redis_cluster_slots.hpp>
+#include <redis_cpp/detail/redis_reply_util.hpp>
 #include <utility/asio_base/thread_pool.hpp>
+#include <utility/asio_base/io_service_pool.hpp>
 #include <utility/str.hpp>
+#include <set>
 
 namespace redis_cpp
 {
 namespace detail
 {
+/** the request of cluster async client, kept for redirect */
+struct cluster_async_request
+{
+    redis_command   cmd;
+    int32_t         hash_slot;
+    reply_handler   handler;
+    int32_t         redirect_times;
+
+    cluster_async_request(const redis_command& c, int32_t slot, const reply_handler& h)
+        : cmd(c)
+        , hash_slot(slot)
+        , handler(h)
+        , redirect_times(0){
+    }
+};
+typedef std::shared_ptr<cluster_async_request> cluster_async_request_ptr;
+
 class cluster_async_client : 
     public base_async_client
 {
 protected:
-    std::map<std::string, standalone_async_client*> async_client_map_;
+    std::map<std::string, standalone_async_client_pool_ptr> async_client_map_;
     std::mutex                                      client_map_mtx_;
     utility::asio_base::thread_pool                 async_con_thread_pool_;
+    utility::asio_base::io_service_pool             async_con_loops_;
+    bool                                            exclusive_io_loops_;
     utility::asio_base::thread_pool                 other_thread_pool_;
     channel_message_handler_map_type                subscribe_msg_handlers_;
+    std::map<std::string, std::string>              subscribe_addresses_;   // channel -> the node subscribed at
     std::mutex                                      msg_handlers_mtx_;
     redis_cluster_slots*                            cluster_slots_;
+    int32_t                                         connections_per_node_;
+    async_dispatch_policy                           dispatch_policy_;
+    std::atomic<asio::io_service*>                  completion_executor_;
 
 public:
     /* 
      * @param uri - redis address list(seperate by ';'), 
      * like redis://foobared@127.0.0.1:7000;redis://foobared@127.0.0.1:7001;redis://foobared@127.0.0.1:7002;
+     * @param connections_per_node - the connection count of each node
+     * @param policy - how to dispatch the commands to the connections of a node
+     * @param io_thread_count - the io thread count of the connections
+     * @param exclusive_io_loops - one io_service per io thread, and each connection
+     * is bound to one of them for life( 0 io_thread_count means the cpu core count)
+     * @param pin_cpu - bind the io threads to the cpu cores, only for exclusive_io_loops
      */
-    cluster_async_client(const char* uri)
-        : async_con_thread_pool_(2)
+    cluster_async_client(const char* uri,
+        int32_t connections_per_node = 1,
+        async_dispatch_policy policy = async_dispatch_least_pending,
+        int32_t io_thread_count = 2,
+        bool exclusive_io_loops = false,
+        bool pin_cpu = false)
+        : async_con_thread_pool_(exclusive_io_loops ? 0 : io_thread_count)
+        , async_con_loops_(exclusive_io_loops ? io_thread_count : 1, pin_cpu)
+        , exclusive_io_loops_(exclusive_io_loops)
         , other_thread_pool_(2)
         , cluster_slots_(nullptr)
+        , connections_per_node_(connections_per_node)
+        , dispatch_policy_(policy)
     {
+        completion_executor_ = nullptr;
         async_con_thread_pool_.start();
+        if (exclusive_io_loops_){
+            async_con_loops_.start();
+        }
         other_thread_pool_.start();
 
         std::vector<std::string> uri_list;
@@ -81,6 +126,7 @@ public:
 
     ~cluster_async_client(){
         async_con_thread_pool_.stop();
+        async_con_loops_.stop();
         other_thread_pool_.stop();
 
         if (cluster_slots_){
@@ -89,7 +135,11 @@ public:
         }
 
         async_con_thread_pool_.wait_for_stop();
+        async_con_loops_.wait_for_stop();
         other_thread_pool_.wait_for_stop();
+
+        // the connections should be freed before the io services
+        async_client_map_.clear();
     }
 
 public:
@@ -119,13 +169,20 @@ public:
                 std::make_pair(channel_name,
                 channel_message_handler_ptr(new channel_message_handler(message_handler))));
         }
-        standalone_async_client* client = get_async_client(channel_name);
+        std::string address;
+        standalone_async_client_pool_ptr client = get_async_client(channel_name, &address);
         if (!client){
             rds_log_error("cluster_async_client[%p] can't find available client, subscribe channel[%s] failed.",
                 this, channel_name.c_str());
             return;
         }
 
+        {
+            // the channel is resubscribed only if the node removed
+            std::lock_guard<std::mutex> locker(msg_handlers_mtx_);
+            subscribe_addresses_[channel_name] = address;
+        }
+
         client->subscribe(channel_name, message_handler, reply_handler);
     }
 
@@ -136,12 +193,27 @@ public:
         const reply_handler& reply_handler) override{
         // remove the channel msg handler first, whether the connection is 
         // connected or not
+        std::string address;
         {
             std::lock_guard<std::mutex> locker(msg_handlers_mtx_);
             subscribe_msg_handlers_.erase(channel_name);
+
+            auto iter = subscribe_addresses_.find(channel_name);
+            if (iter != subscribe_addresses_.end()){
+                address = iter->second;
+                subscribe_addresses_.erase(iter);
+            }
         }
 
-        standalone_async_client* client = get_async_client(channel_name);
+        // the node subscribed at, the slot may be migrated since then
+        standalone_async_client_pool_ptr client;
+        if (!address.empty()){
+            std::lock_guard<std::mutex> locker(client_map_mtx_);
+            client = get_client_by_address(address);
+        }
+        if (!client){
+            client = get_async_client(channel_name);
+        }
         if (!client){
             rds_log_error("cluster_async_client[%p] can't find available client, usubscribe channel[%s] failed.",
                 this, channel_name.c_str());
@@ -158,7 +230,7 @@ public:
         const std::string& message,
         const reply_handler& reply_handler) override{
         // find a client to to the publish
-        standalone_async_client* client = get_async_client(channel_name);
+        standalone_async_client_pool_ptr client = get_async_client(channel_name);
         if (!client){
             rds_log_error("cluster_async_client[%p] can't find available client, publish msg to channel[%s] failed.",
                 this, channel_name.c_str());
@@ -168,18 +240,69 @@ public:
         client->publish(channel_name, message, reply_handler);
     }
 
+    using base_async_client::do_command;
+
     /**
-    * @brief get client by channel name
+    * @brief do command on the client which the hash slot located at
+    * if hash slot is -1, then choose a random client
+    * the MOVED/ASK redirect is followed in the io thread, the node which not
+    * connected yet will be connected in other thread
     */
-    standalone_async_client*   get_async_client(const std::string& channel_name){
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        const reply_handler& handler) override{
+        standalone_async_client_pool_ptr client;
+        {
+            std::lock_guard<std::mutex> locker(client_map_mtx_);
+            client = hash_slot < 0 ? random_client() : get_client_by_slot(hash_slot);
+        }
+
+        if (!client){
+            rds_log_error("cluster_async_client[%p] get client of slot[%d] failed, cmd failed.",
+                this, hash_slot);
+
+            if (handler){
+                handler(nullptr);
+            }
+            return;
+        }
+
+        cluster_async_request_ptr request =
+            std::make_shared<cluster_async_request>(cmd, hash_slot, handler);
+        send_request(client, request, false);
+    }
+
+    /** is cluster mode */
+    virtual bool cluster_mode() override{
+        return true;
+    }
+
+    /**
+    * @brief run the handlers in the executor instead of the io threads, the
+    * handlers of each connection keep their order. could only be set once
+    */
+    void    set_completion_executor(asio::io_service* executor){
+        std::lock_guard<std::mutex> locker(client_map_mtx_);
+        completion_executor_ = executor;
+        for (auto& iter : async_client_map_){
+            iter.second->set_completion_executor(executor);
+        }
+    }
+
+    /**
+    * @brief get client by channel name, the pool is kept alive by the returned
+    * pointer even if the node removed meanwhile
+    * @param address - the address of the node if not null
+    */
+    standalone_async_client_pool_ptr get_async_client(const std::string& channel_name,
+        std::string* address = nullptr){
         int32_t slot_id = redis_slot::slot(channel_name.c_str(), (int32_t)channel_name.size());
 
         std::lock_guard<std::mutex> locker(client_map_mtx_);
-        return get_client_by_slot(slot_id);
+        return get_client_by_slot(slot_id, address);
     }
 
 protected:
-    standalone_async_client* get_client_by_address(const std::string& address){
+    standalone_async_client_pool_ptr get_client_by_address(const std::string& address){
         auto iter = async_client_map_.find(address);
         if (iter != async_client_map_.end()){
             return iter->second;
@@ -191,21 +314,41 @@ protected:
     /** 
      * @brief get client by slot
      */
-    standalone_async_client* get_client_by_slot(int32_t slot){
-        std::string* address = cluster_slots_->get_address_by_slot(slot);
-        if (!address)
+    standalone_async_client_pool_ptr get_client_by_slot(int32_t slot,
+        std::string* address = nullptr){
+        std::string slot_address;
+        if (!cluster_slots_->get_address_by_slot(slot, slot_address))
+            return nullptr;
+
+        if (address){
+            *address = slot_address;
+        }
+        return get_client_by_address(slot_address);
+    }
+
+    /**
+     * @brief get a random client, used by the commands without key
+     */
+    standalone_async_client_pool_ptr random_client(){
+        if (async_client_map_.empty())
             return nullptr;
 
-        return get_client_by_address(*address);
+        auto iter = async_client_map_.begin();
+        std::advance(iter, rand() % async_client_map_.size());
+        return iter->second;
     }
 
     /**
     * @brief add async_client by uri
     */
-    standalone_async_client* add_async_client(const std::string& uri){
-
-        standalone_async_client* client =
-            new standalone_async_client(async_con_thread_pool_.io_service(), uri.c_str());
+    standalone_async_client_pool_ptr add_async_client(const std::string& uri){
+
+        standalone_async_client_pool_ptr client(exclusive_io_loops_ ?
+            new standalone_async_client_pool(async_con_loops_, uri.c_str(),
+            connections_per_node_, dispatch_policy_) :
+            new standalone_async_client_pool(async_con_thread_pool_.io_service(), uri.c_str(),
+            connections_per_node_, dispatch_policy_));
+        client->set_completion_executor(completion_executor_);
         redis_uri r_uri(uri.c_str());
         std::stringstream ss;
         ss << r_uri.get_ip() << ":" << r_uri.get_port();
@@ -221,7 +364,7 @@ protected:
     /**
     * @brief add pool by ip and port
     */
-    standalone_async_client* add_async_client(const std::string& ip, int32_t port){
+    standalone_async_client_pool_ptr add_async_client(const std::string& ip, int32_t port){
         redis_uri uri;
         uri.set_passwd(cluster_slots_->get_redis_passwd());
         uri.set_ip(ip.c_str());
@@ -244,10 +387,20 @@ protected:
         }
     }
 
-    /** try recover subscribe channels */
-    void    try_resubscribe_channels(){
-        channel_message_handler_map_type subcribe_list = subscribe_msg_handlers_;
-        subscribe_msg_handlers_.clear();
+    /** try recover the subscribe channels of the removed nodes */
+    void    try_resubscribe_channels(const std::set<std::string>& removed_addresses){
+        channel_message_handler_map_type subcribe_list;
+        {
+            std::lock_guard<std::mutex> locker(msg_handlers_mtx_);
+            for (auto& kv : subscribe_msg_handlers_){
+                // not subscribed on any node if not found
+                auto iter = subscribe_addresses_.find(kv.first);
+                if (iter == subscribe_addresses_.end() ||
+                    removed_addresses.count(iter->second) > 0){
+                    subcribe_list.insert(kv);
+                }
+            }
+        }
 
         // resubscribe the subscribe
         for (auto iter = subcribe_list.begin();
@@ -261,29 +414,59 @@ protected:
         }
     }
 
+    /**
+    * @brief only the nodes added or removed are changed, the connections of the
+    * other nodes are kept( like the slots migrated between the nodes). the
+    * removed pools are freed once the requests in flight released them
+    */
     void   reset_client_list(const slot_range_map_type& map){
-        // remove the old client
+        std::vector<standalone_async_client_pool_ptr> added_clients;
+        std::vector<standalone_async_client_pool_ptr> removed_clients;
+        std::set<std::string> removed_addresses;
         {
             std::lock_guard<std::mutex> locker(client_map_mtx_);
 
-            for (auto& c_kv : async_client_map_){
-                c_kv.second->shutdown();
-                delete c_kv.second;
+            cluster_slots_->reset(map);
+
+            std::set<std::string> addresses;
+            for (auto& node : map){
+                std::stringstream ss;
+                ss << node.second.master.ip << ":" << node.second.master.port;
+                std::string address(std::move(ss.str()));
+                addresses.insert(address);
+
+                if (!get_client_by_address(address)){
+                    added_clients.push_back(
+                        add_async_client(node.second.master.ip, node.second.master.port));
+                }
             }
 
-            async_client_map_.clear();
+            for (auto iter = async_client_map_.begin(); iter != async_client_map_.end();){
+                if (addresses.count(iter->first) > 0){
+                    ++iter;
+                    continue;
+                }
 
-            rds_log_info("[%p] reset_client_list, cur_list_size[%d]",
-                this, async_client_map_.size());
+                removed_clients.push_back(iter->second);
+                removed_addresses.insert(iter->first);
+                iter = async_client_map_.erase(iter);
+            }
 
-            initialize(map);
+            rds_log_info("[%p] reset_client_list, added[%d] removed[%d] cur_list_size[%d]",
+                this, added_clients.size(), removed_clients.size(), async_client_map_.size());
+        }
+
+        for (auto& client : removed_clients){
+            client->shutdown();
         }
 
         // try connect
-        connect();
+        for (auto& client : added_clients){
+            client->try_connect();
+        }
 
-        // resubscribe the old channels
-        try_resubscribe_channels();
+        // resubscribe the channels of the removed nodes
+        try_resubscribe_channels(removed_addresses);
     }
 
     void    process_cluster_slot_change(const slot_range_map_type& map){
@@ -295,6 +478,131 @@ protected:
     void default_reply_handler(redis_reply_ptr reply){
 
     }
+
+    /** complete the request */
+    static void complete_request(const cluster_async_request_ptr& request,
+        redis_reply_ptr reply){
+        if (request->handler){
+            request->handler(reply);
+        }
+    }
+
+    /**
+    * @brief send the request to the client
+    * @param asking - send 'asking' before the command( ask redirect)
+    */
+    void    send_request(const standalone_async_client_pool_ptr& pool,
+        const cluster_async_request_ptr& request, bool asking){
+        standalone_async_client* client = pool->select_client();
+
+        reply_handler handler = std::bind(&cluster_async_client::process_request_reply,
+            this, request, std::placeholders::_1);
+
+        if (!asking){
+            client->do_command(request->cmd, request->hash_slot, handler);
+            return;
+        }
+
+        if (!client->do_asking_command(request->cmd, handler)){
+            rds_log_error("cluster_async_client[%p] send asking command to[%s] failed.",
+                this, client->uri_string().c_str());
+            complete_request(request, nullptr);
+        }
+    }
+
+    /** process the reply, follow the redirect if needed */
+    void    process_request_reply(cluster_async_request_ptr request,
+        redis_reply_ptr reply){
+        if (!reply || !reply->is_error()){
+            complete_request(request, reply);
+            return;
+        }
+
+        error_reply& err = reply->to_error();
+#define EQ(x, y) !strnicmp((x), (y), sizeof(y) -1)
+        bool moved = EQ(err.msg.c_str(), "moved");
+        bool ask = !moved && EQ(err.msg.c_str(), "ask");
+#undef EQ
+        if (!moved && !ask){
+            complete_request(request, reply);
+            return;
+        }
+
+        if (++request->redirect_times > max_redirect_times){
+            rds_log_warn("cluster_async_client[%p] too many redirect: %d, max: %d, for slot[%d].",
+                this, request->redirect_times, max_redirect_times, request->hash_slot);
+            complete_request(request, nullptr);
+            return;
+        }
+
+        int32_t redirect_slot = -10000;
+        const char* address =
+            reply_util::get_addr_from_redirect_error(err.msg, redirect_slot);
+        if (!address){
+            rds_log_error("cluster_async_client[%p] redirect invalid, error_desc:%s",
+                this, err.msg.c_str());
+            complete_request(request, reply);
+            return;
+        }
+
+        std::string address_str(address);
+        if (moved){
+            // the slot migrated, update the slot address and refresh the topology
+            cluster_slots_->update_slot_address(redirect_slot, address_str);
+            cluster_slots_->refresh();
+        }
+
+        rds_log_info("cluster_async_client[%p] %s redirect to slot[%d(%d)] located at %s.",
+            this, moved ? "moved" : "ask", redirect_slot, request->hash_slot, address);
+
+        redirect_request(address_str, request, ask);
+    }
+
+    /** redirect the request to the address */
+    void    redirect_request(const std::string& address,
+        const cluster_async_request_ptr& request, bool asking){
+        standalone_async_client_pool_ptr client;
+        {
+            std::lock_guard<std::mutex> locker(client_map_mtx_);
+            client = get_client_by_address(address);
+        }
+
+        if (client){
+            send_request(client, request, asking);
+            return;
+        }
+
+        // the node is new, connect it in other thread, don't block the io thread
+        other_thread_pool_.io_service().post([this, address, request, asking](){
+            standalone_async_client_pool_ptr client;
+            bool new_client = false;
+            {
+                std::lock_guard<std::mutex> locker(client_map_mtx_);
+                client = get_client_by_address(address);
+                if (!client){
+                    std::string ip;
+                    int32_t port = 0;
+                    if (reply_util::split_address(address, ip, port)){
+                        client = add_async_client(ip, port);
+                        new_client = true;
+                    }
+                }
+            }
+
+            if (!client){
+                rds_log_error("cluster_async_client[%p] redirect failed, address: %s",
+                    this, address.c_str());
+                complete_request(request, nullptr);
+                return;
+            }
+
+            if (new_client){
+                client->try_connect(true);
+            }
+
+            send_request(client, request, asking);
+        });
+    }
 };
 }
 }
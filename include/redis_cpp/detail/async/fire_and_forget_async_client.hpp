@@ -0,0 +1,485 @@
+﻿/**
+ *
+ * fire_and_forget_async_client.hpp
+ *
+ * the write only client on a dedicated connection, the server replies turned
+ * off by "client reply off", the commands are streamed without waiting for
+ * reply, a barrier( "client reply on" and ping) is sent periodically to check
+ * the connection
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-20
+ */
+
+#ifndef __ydk_rediscpp_detail_fire_and_forget_async_client_hpp__
+#define __ydk_rediscpp_detail_fire_and_forget_async_client_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/standalone_async_client.hpp>
+#include <redis_cpp/detail/tcp_channel.hpp>
+#include <redis_cpp/detail/redis_parser.hpp>
+#include <redis_cpp/detail/redis_buffer.hpp>
+#include <redis_cpp/detail/redis_command.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <redis_cpp/redis_uri.hpp>
+#include <utility/asio_base/timer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** default barrier interval in millisecond */
+static const int32_t default_barrier_interval = 1000;
+
+/** the connection is closed if the barrier not replied and no write progress in these intervals */
+static const int32_t max_barrier_miss_times = 3;
+
+/** max bytes of the commands not written to the socket, the commands more are dropped */
+static const int64_t max_fire_and_forget_pending_bytes = 0x4000000;
+
+/**
+ * called in the io thread when the barrier replied( true), or not replied
+ * in time( false, the connection is closed and reconnected)
+ */
+typedef std::function<void(bool healthy)> barrier_handler;
+
+/**
+ * the commands are sent in order, but there is no reply( even the error reply)
+ * for them, the barrier only tells all the commands before it are processed.
+ * the commands sent when not connected, or lost with the broken connection
+ * are not resent
+ */
+class fire_and_forget_async_client :
+    public tcp_channel_event
+{
+protected:
+    tcp_async_channel_ptr            connection_;
+    asio::ip::tcp::endpoint          endpoint_;
+    redis_parser                     parser_;
+    redis_uri                        redis_uri_;
+    int32_t                          barrier_interval_;
+    barrier_handler                  barrier_handler_;
+    std::mutex                       mtx_;
+    std::string                      pending_data_;          // the encoded commands not drained yet
+    int64_t                          pending_offset_;        // the stream offset of the first pending byte
+    std::deque<int64_t>              pending_command_ends_;  // the stream offset after each pending command
+    std::atomic_bool                 drain_scheduled_;
+    std::atomic_bool                 barrier_waiting_;
+    std::atomic_bool                 write_progress_;        // some bytes written since the last barrier check
+    std::atomic<int32_t>             barrier_miss_times_;
+    int32_t                          setup_replies_;         // the replies of auth and select not received, only in the connection strand
+    std::atomic<int64_t>             sent_count_;
+    std::atomic<int64_t>             dropped_count_;
+    std::atomic<int64_t>             barrier_count_;
+    utility::asio_base::timer::ptr   reconnect_timer_;
+    std::atomic<int32_t>             reconnect_times_;      // reconnected in a row without open
+    utility::asio_base::timer::ptr   barrier_timer_;
+
+public:
+    /**
+    * @param uri like "redis://foobared@localhost:6380/2"
+    * @param barrier_interval - the interval of the barrier, in milliseconds
+    * @param exclusive_loop - the io_service is run by only one thread
+    */
+    fire_and_forget_async_client(asio::io_service& io_service, const char* uri,
+        int32_t barrier_interval = default_barrier_interval,
+        bool exclusive_loop = false)
+        : redis_uri_(uri)
+        , barrier_interval_(barrier_interval)
+        , pending_offset_(0)
+        , setup_replies_(0){
+        drain_scheduled_ = false;
+        barrier_waiting_ = false;
+        write_progress_ = false;
+        barrier_miss_times_ = 0;
+        reconnect_times_ = 0;
+        sent_count_ = 0;
+        dropped_count_ = 0;
+        barrier_count_ = 0;
+        endpoint_ = asio::ip::tcp::endpoint(
+            asio::ip::address::from_string(redis_uri_.get_ip()),
+            redis_uri_.get_port());
+        connection_ = tcp_async_channel::create(io_service, exclusive_loop);
+        connection_->set_event_handler(this);
+
+        reconnect_timer_ = utility::asio_base::timer::create(io_service);
+        reconnect_timer_->register_handler(std::bind(
+            &fire_and_forget_async_client::reconnect_timer_handler,
+            this,
+            std::placeholders::_1,
+            std::placeholders::_2));
+
+        barrier_timer_ = utility::asio_base::timer::create(io_service);
+        barrier_timer_->register_handler(std::bind(
+            &fire_and_forget_async_client::barrier_timer_handler,
+            this,
+            std::placeholders::_1,
+            std::placeholders::_2));
+    }
+
+    virtual ~fire_and_forget_async_client(){
+        shutdown();
+
+        reconnect_timer_->cancel();
+        barrier_timer_->cancel();
+    }
+
+    void    shutdown(){
+        connection_->shutdown();
+    }
+
+    bool    is_connected(){
+        return connection_->is_connected();
+    }
+
+    void    try_connect(bool use_promise = false){
+        connection_->connect(endpoint_, use_promise);
+    }
+
+    std::string uri_string(){
+        return std::move(redis_uri_.to_string());
+    }
+
+    /** should be set before connect */
+    void    set_barrier_handler(const barrier_handler& handler){
+        barrier_handler_ = handler;
+    }
+
+    /**
+    * @brief send the command without reply, the commands sent together are
+    * written in one buffer
+    * @return false if not connected or too many bytes not written
+    */
+    bool    send(const redis_command& cmd){
+        if (!connection_->is_connected()){
+            ++dropped_count_;
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            if ((int64_t)pending_data_.size() + connection_->pending_write_bytes() >
+                max_fire_and_forget_pending_bytes){
+                ++dropped_count_;
+                return false;
+            }
+
+            cmd.encode(pending_data_);
+            pending_command_ends_.push_back(pending_offset_ + (int64_t)pending_data_.size());
+        }
+
+        ++sent_count_;
+        schedule_drain();
+
+        return true;
+    }
+
+    /** the count of the commands sent */
+    int64_t sent_count(){
+        return sent_count_;
+    }
+
+    /** the count of the commands dropped when not connected or too many pending */
+    int64_t dropped_count(){
+        return dropped_count_;
+    }
+
+    /** the count of the barriers replied */
+    int64_t barrier_count(){
+        return barrier_count_;
+    }
+
+public:
+    /** implement of interface of tcp_channel_event */
+    /**
+    * connection to remote address opened
+    */
+    virtual void channel_open(const char* ip, int32_t port) override{
+        rds_log_info("[%p] fire_and_forget_client to server[%s:%d] channel opend.",
+            this, ip, port);
+
+        parser_.reset();
+        reconnect_times_ = 0;
+        barrier_waiting_ = false;
+        barrier_miss_times_ = 0;
+        setup_replies_ = 0;
+
+        // the tail of the command half written to the old connection would be
+        // parsed as a command, the setup should be the first
+        clear_pending_data();
+
+        // the commands before "client reply off" are replied
+        std::string setup;
+        if (redis_uri_.get_passwd() != ""){
+            redis_command cmd("auth");
+            cmd.add_param(redis_uri_.get_passwd());
+            cmd.encode(setup);
+            ++setup_replies_;
+        }
+
+        if (redis_uri_.get_dbnum() != 0){
+            redis_command cmd("select");
+            cmd.add_param(redis_uri_.get_dbnum());
+            cmd.encode(setup);
+            ++setup_replies_;
+        }
+
+        reply_off_command().encode(setup);
+
+        redis_buffer_ptr buffer = connection_->acquire_send_buffer();
+        buffer->write_bytes(setup.data(), (int32_t)setup.length());
+        connection_->send_in_strand(buffer);
+
+        barrier_timer_->start(barrier_interval_);
+    }
+
+    /*
+    * connection to remote address closed
+    */
+    virtual void channel_closed(const char* ip, int32_t port) override{
+        rds_log_error("[%p] fire_and_forget_client to server[%s:%d] channel closed.",
+            this, ip, port);
+
+        barrier_timer_->cancel();
+
+        // the commands not written are lost with the connection
+        clear_pending_data();
+
+        reconnect_timer_->start(backoff_delay(reconnect_min_interval, reconnect_interval, reconnect_times_++));
+    }
+
+    /**
+    * connection to remote address exception
+    */
+    virtual void channel_exception(const char* ip, int32_t port,
+        const std::error_code& err) override{
+        rds_log_error("[%p] fire_and_forget_client to server[%s:%d] channel exception[%s:%d].",
+            this, ip, port, err.message().c_str(), err.value());
+    }
+
+    /**
+    * received msg from the connection, only the replies of the setup and the barrier
+    */
+    virtual void message_received(const char* ip, int32_t port,
+        const char* message, int32_t size) override{
+
+        parser_.push_bytes((char*)message, size);
+        for (;;){
+            parse_result result = parser_.parse();
+            if (result == redis_ok){
+                process_reply(parser_.transfer_reply());
+            }
+            else if (result == redis_incomplete){
+                break;
+            }
+            else if (result == redis_error){
+                rds_log_error("[%p] uri[%s] parser redis content failed.",
+                    this, redis_uri_.to_string().c_str());
+
+                parser_.reset();
+                connection_->close();
+
+                break;
+            }
+        }
+    }
+
+    /**
+    * msg written to the connection
+    */
+    virtual void message_sent(const char* ip, int32_t port, int32_t size) override{
+        write_progress_ = true;
+
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (!pending_data_.empty()){
+            schedule_drain();
+        }
+    }
+
+protected:
+    static const redis_command& reply_off_command(){
+        static const redis_command cmd = make_client_reply_command("off");
+        return cmd;
+    }
+
+    static redis_command make_client_reply_command(const char* mode){
+        redis_command cmd("client");
+        cmd.add_param("reply");
+        cmd.add_param(mode);
+        return cmd;
+    }
+
+    static std::string make_barrier_data(){
+        std::string data;
+        make_client_reply_command("on").encode(data);
+        redis_command("ping").encode(data);
+        reply_off_command().encode(data);
+        return data;
+    }
+
+    void    process_reply(redis_reply_ptr reply){
+        if (!reply){
+            return;
+        }
+
+        if (setup_replies_ > 0){
+            --setup_replies_;
+            if (reply->is_error()){
+                rds_log_error("fire_and_forget_client[%p] uri[%s] setup failed, error[%s].",
+                    this, redis_uri_.to_string().c_str(), reply->to_error().msg.c_str());
+            }
+            return;
+        }
+
+        if (reply->is_error()){
+            rds_log_error("fire_and_forget_client[%p] uri[%s] barrier error[%s].",
+                this, redis_uri_.to_string().c_str(), reply->to_error().msg.c_str());
+            return;
+        }
+
+        // the reply of "client reply on" is ok, the barrier passed when the ping replied
+        if (reply->is_string() && reply->to_string() == "PONG"){
+            barrier_waiting_ = false;
+            barrier_miss_times_ = 0;
+            ++barrier_count_;
+
+            if (barrier_handler_){
+                barrier_handler_(true);
+            }
+        }
+    }
+
+    /** only one drain is scheduled at the same time */
+    void    schedule_drain(){
+        if (!drain_scheduled_.exchange(true)){
+            connection_->post(std::bind(
+                &fire_and_forget_async_client::drain_pending_data,
+                this));
+        }
+    }
+
+    /** send the pending commands in one buffer, only in the connection strand */
+    void    drain_pending_data(){
+        drain_scheduled_ = false;
+
+        // the send queue too long, drain again after the write completed
+        if (connection_->send_queue_full()){
+            return;
+        }
+
+        redis_buffer_ptr buffer;
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            if (pending_data_.empty()){
+                return;
+            }
+
+            if (!connection_->is_connected()){
+                rds_log_error("fire_and_forget_client[%p] uri[%s] connection not connected, give up [%d] bytes.",
+                    this, redis_uri_.to_string().c_str(), (int32_t)pending_data_.size());
+                clear_pending_data_locked();
+                return;
+            }
+
+            int32_t len = (int32_t)std::min<std::size_t>(pending_data_.size(), max_request_batch_size);
+            buffer = connection_->acquire_send_buffer();
+            buffer->write_bytes(pending_data_.data(), len);
+            pending_data_.erase(0, len);
+
+            pending_offset_ += len;
+            while (!pending_command_ends_.empty() && pending_command_ends_.front() <= pending_offset_){
+                pending_command_ends_.pop_front();
+            }
+        }
+
+        connection_->send_in_strand(buffer);
+    }
+
+    /** drop the pending data, the commands not drained( even partly) are counted as dropped */
+    void    clear_pending_data(){
+        std::lock_guard<std::mutex> locker(mtx_);
+        clear_pending_data_locked();
+    }
+
+    void    clear_pending_data_locked(){
+        dropped_count_ += (int64_t)pending_command_ends_.size();
+        pending_command_ends_.clear();
+        pending_offset_ += (int64_t)pending_data_.size();
+        pending_data_.clear();
+    }
+
+    /** the barrier is queued after the commands sent before */
+    void    send_barrier(){
+        static const std::string barrier_data = make_barrier_data();
+
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            pending_data_.append(barrier_data);
+        }
+
+        barrier_waiting_ = true;
+        schedule_drain();
+    }
+
+    /**
+    * @brief connection reconnect timer handler
+    */
+    void    reconnect_timer_handler(utility::asio_base::timer::ptr timer_ptr,
+        const asio::error_code& error){
+        if (!error){
+            try_connect();
+        }
+        else{
+            rds_log_error("fire_and_forget_client[%p] reconnect timer error, %s:%d.",
+                this, error.message().c_str(), error.value());
+        }
+    }
+
+    /**
+    * @brief the barrier may be queued after lots of commands, it is waited while
+    * the commands still being written, the connection is closed if not replied
+    * and no write progress in max_barrier_miss_times intervals
+    */
+    void    barrier_timer_handler(utility::asio_base::timer::ptr timer_ptr,
+        const asio::error_code& error){
+        if (error){
+            return;
+        }
+
+        bool progress = write_progress_.exchange(false);
+        if (barrier_waiting_){
+            if (progress){
+                barrier_miss_times_ = 0;
+            }
+            else if (++barrier_miss_times_ >= max_barrier_miss_times){
+                rds_log_error("fire_and_forget_client[%p] uri[%s] barrier not replied in [%d] ms, reconnect.",
+                    this, redis_uri_.to_string().c_str(), barrier_interval_ * max_barrier_miss_times);
+
+                if (barrier_handler_){
+                    barrier_handler_(false);
+                }
+
+                connection_->close();
+                return;
+            }
+
+            timer_ptr->start(barrier_interval_);
+            return;
+        }
+
+        send_barrier();
+
+        timer_ptr->start(barrier_interval_);
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,367 @@
+﻿/**
+ *
+ * redis_async_command_executor.hpp
+ *
+ * the async command executor
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_command_executor_hpp__
+#define __ydk_rediscpp_detail_redis_async_command_executor_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/base_async_client.hpp>
+#include <redis_cpp/detail/redis_slot.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+/** typed result handlers, the first param 'success' is false if the command failed */
+typedef std::function<void(bool success)> status_result_handler;
+typedef std::function<void(bool success, bool value)> boolean_result_handler;
+typedef std::function<void(bool success, int64_t value)> integer_result_handler;
+typedef std::function<void(bool success, double value)> float_result_handler;
+typedef std::function<void(bool success, const std::string& value)> string_result_handler;
+typedef std::function<void(bool success,
+    const std::vector<std::string>& values)> array_result_handler;
+typedef std::function<void(bool success,
+    const std::unordered_map<std::string, std::string>& table)> map_result_handler;
+typedef std::function<void(bool success,
+    const std::vector<std::pair<std::string, double>>& values)> score_result_handler;
+typedef std::function<void(bool success, uint64_t next_cursor,
+    const std::vector<std::string>& values)> scan_result_handler;
+
+/**
+ * the hash slot is passed with each command( not recorded in member like
+ * the sync executor), cause the reply may be handled in another thread
+ * while the next command is building
+ */
+class redis_async_command_executor
+{
+protected:
+    base_async_client*  async_client_;
+
+public:
+    redis_async_command_executor()
+        : async_client_(nullptr)
+    {
+    }
+
+    virtual ~redis_async_command_executor(){
+
+    }
+
+public:
+    void    set_async_client(base_async_client* client){
+        async_client_ = client;
+    }
+
+    base_async_client* get_async_client(){
+        return async_client_;
+    }
+
+    /**
+     * @brief execute cmd
+     * @param cmd - the command
+     * @param hash_slot - the hash slot, -1 if no key related
+     * @param handler - the reply handler, the reply is null if the command failed
+     */
+    void    do_command(const redis_command& cmd, int32_t hash_slot,
+        reply_handler handler){
+        if (!async_client_){
+            if (handler){
+                handler(nullptr);
+            }
+            return;
+        }
+
+        async_client_->do_command(cmd, hash_slot, std::move(handler));
+    }
+
+public:
+    /** slot related */
+    /** get the hash slot of the key, -1 if not in cluster mode */
+    int32_t key_slot(const char* key){
+        if (async_client_ && async_client_->cluster_mode()){
+            return redis_slot::slot(key);
+        }
+        return -1;
+    }
+
+    int32_t key_slot(const char* key, int32_t len){
+        if (async_client_ && async_client_->cluster_mode()){
+            return redis_slot::slot(key, len);
+        }
+        return -1;
+    }
+
+protected:
+    /** some get reply result util */
+
+    /**
+     * @brief get array result
+     * @param cmd - the command
+     * @param hash_slot - the hash slot
+     * @param param_list - in param list
+     * @param handler - the result handler
+     */
+    void    get_array_result(redis_command& cmd, int32_t hash_slot,
+        const std::vector<std::string>& param_list,
+        const array_result_handler& handler){
+        // append params
+        for (auto& param : param_list){
+            cmd.add_param(param);
+        }
+
+        get_array_result(cmd, hash_slot, handler);
+    }
+
+    /**
+     * @brief get array result
+     */
+    void    get_array_result(const redis_command& cmd, int32_t hash_slot,
+        const array_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            std::vector<std::string> array_result;
+            if (!reply || !reply->is_array()){
+                handler(false, array_result);
+                return;
+            }
+
+            redis_reply_arr& arr = reply->to_array();
+            for (auto& r : arr){
+                if (r.is_string()){
+                    array_result.push_back(r.to_string());
+                }
+            }
+
+            handler(true, array_result);
+        });
+    }
+
+    /**
+     * @brief get integer result
+     */
+    void    get_integer_result(redis_command& cmd, int32_t hash_slot,
+        const std::vector<std::string>& param_list,
+        const integer_result_handler& handler){
+        // append params
+        for (auto& param : param_list){
+            cmd.add_param(param);
+        }
+
+        get_integer_result(cmd, hash_slot, handler);
+    }
+
+    /**
+     * @brief get integer result
+     */
+    void    get_integer_result(const redis_command& cmd, int32_t hash_slot,
+        const integer_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            if (!reply || !reply->is_integer()){
+                handler(false, 0);
+                return;
+            }
+
+            handler(true, reply->to_integer());
+        });
+    }
+
+    /**
+     * @brief get float result
+     */
+    void    get_float_result(const redis_command& cmd, int32_t hash_slot,
+        const float_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            if (!reply || !reply->is_string()){
+                handler(false, 0.0);
+                return;
+            }
+
+            handler(true, atof(reply->to_string().c_str()));
+        });
+    }
+
+    /**
+     * @brief get string result
+     */
+    void    get_string_result(const redis_command& cmd, int32_t hash_slot,
+        const string_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            if (!reply || !reply->is_string()){
+                handler(false, "");
+                return;
+            }
+
+            handler(true, reply->to_string());
+        });
+    }
+
+    /**
+     * @brief get bool result
+     */
+    void    get_boolean_result(const redis_command& cmd, int32_t hash_slot,
+        const boolean_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            if (!reply || !reply->is_integer()){
+                handler(false, false);
+                return;
+            }
+
+            handler(true, !!reply->to_integer());
+        });
+    }
+
+    /**
+     * @brief check status ok
+     */
+    void    check_status_ok(const redis_command& cmd, int32_t hash_slot,
+        const status_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            if (!reply || !reply->is_string()){
+                handler(false);
+                return;
+            }
+
+            handler(reply->check_status_ok());
+        });
+    }
+
+    /**
+     * @brief get map result( field value pairs)
+     */
+    void    get_map_result(const redis_command& cmd, int32_t hash_slot,
+        const map_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            std::unordered_map<std::string, std::string> table;
+            if (!reply || !reply->is_array() || reply->to_array().size() % 2 != 0){
+                handler(false, table);
+                return;
+            }
+
+            redis_reply_arr& arr = reply->to_array();
+            for (std::size_t i = 0; i + 1 < arr.size(); i += 2){
+                table.insert(std::make_pair(arr[i].to_string(), arr[i + 1].to_string()));
+            }
+
+            handler(true, table);
+        });
+    }
+
+    /**
+     * @brief get result with score( member score pairs)
+     */
+    void    get_score_result(const redis_command& cmd, int32_t hash_slot,
+        const score_result_handler& handler){
+        do_command(cmd, hash_slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            std::vector<std::pair<std::string, double>> out_result;
+            if (!reply || !reply->is_array() || reply->to_array().size() % 2 != 0){
+                handler(false, out_result);
+                return;
+            }
+
+            redis_reply_arr& arr = reply->to_array();
+            for (std::size_t i = 0; i < arr.size(); i += 2){
+                out_result.push_back(std::make_pair(
+                    arr[i].to_string(), atof(arr[i + 1].to_string().c_str())));
+            }
+
+            handler(true, out_result);
+        });
+    }
+
+    /**
+     * @brief scan key
+     * @param scmd( scan, hscan and so on)
+     * @param key - the key, null if scan
+     * @param cursor - start cursor
+     * @param pattern - the match pattern
+     * @param count - the limit count
+     * @param handler - the result handler with the next cursor
+     */
+    void    scan_key(const char* scmd, const char* key, uint64_t cursor,
+        const char* pattern, const int32_t* count,
+        const scan_result_handler& handler){
+
+        redis_command cmd(scmd);
+
+        if (key){
+            cmd.add_param(key);
+        }
+
+        cmd.add_param(cursor);
+
+        if (pattern){
+            cmd.add_param("match");
+            cmd.add_param(pattern);
+        }
+
+        if (count && *count){
+            cmd.add_param("count");
+            cmd.add_param(*count);
+        }
+
+        int32_t slot = key ? key_slot(key) : -1;
+
+        do_command(cmd, slot, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            std::vector<std::string> out_elements;
+            if (!reply || !reply->is_array()){
+                handler(false, 0, out_elements);
+                return;
+            }
+
+            redis_reply_arr& arr = reply->to_array();
+            if (arr.size() != 2 || !arr[0].is_string() || !arr[1].is_array()){
+                handler(false, 0, out_elements);
+                return;
+            }
+
+            uint64_t next_cursor = strtoull(arr[0].to_string().c_str(), nullptr, 10);
+            redis_reply_arr& elements = arr[1].to_array();
+            for (auto& r : elements){
+                if (r.is_string()){
+                    out_elements.push_back(r.to_string());
+                }
+            }
+
+            handler(true, next_cursor, out_elements);
+        });
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,255 @@
+﻿/**
+ *
+ * redis_async_hash.hpp
+ *
+ * async redis command of hash
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_hash_hpp__
+#define __ydk_rediscpp_detail_redis_async_hash_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+class redis_async_hash : virtual public redis_async_command_executor
+{
+public:
+    redis_async_hash(){
+    }
+
+public:
+    /**
+    * @brief delete field from the hash table
+    * @param handler - the count of the field been deleted
+    */
+    void hdel(const char* key, const char* field, const integer_result_handler& handler)
+    {
+        redis_command cmd("hdel");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief delete fields from the hash table
+    * @param handler - the count of the field been deleted
+    */
+    void hdel(const char* key, const std::vector<std::string>& fields,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("hdel");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), fields, handler);
+    }
+
+    /**
+    * @brief check the field exists in the hash table
+    */
+    void hexists(const char* key, const char* field, const boolean_result_handler& handler)
+    {
+        redis_command cmd("hexists");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the value of the field
+    * @param handler - success is false if the field not exist
+    */
+    void hget(const char* key, const char* field, const string_result_handler& handler)
+    {
+        redis_command cmd("hget");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value of the field
+    * @param handler - 1 if the field is new, 0 if the field been overwrited
+    */
+    void hset(const char* key, const char* field, const char* value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("hset");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value( binary) of the field
+    */
+    void hset(const char* key, const char* field, const char* value, int32_t size,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("hset");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(value, size);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value of the field only if the field not exist
+    */
+    void hsetnx(const char* key, const char* field, const char* value,
+        const boolean_result_handler& handler)
+    {
+        redis_command cmd("hsetnx");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(value);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the values of the fields
+    * @param handler - the values, the value of the field not exist is skipped
+    */
+    void hmget(const char* key, const std::vector<std::string>& fields,
+        const array_result_handler& handler)
+    {
+        redis_command cmd("hmget");
+
+        cmd.add_param(key);
+
+        get_array_result(cmd, key_slot(key), fields, handler);
+    }
+
+    /**
+    * @brief set the values of the fields
+    */
+    void hmset(const char* key,
+        const std::unordered_map<std::string, std::string>& fields,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("hmset");
+
+        cmd.add_param(key);
+
+        for (auto& kv : fields){
+            cmd.add_param(kv.first);
+            cmd.add_param(kv.second);
+        }
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get all the field and value of the hash table
+    */
+    void hgetall(const char* key, const map_result_handler& handler)
+    {
+        redis_command cmd("hgetall");
+
+        cmd.add_param(key);
+
+        get_map_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get all the field of the hash table
+    */
+    void hkeys(const char* key, const array_result_handler& handler)
+    {
+        redis_command cmd("hkeys");
+
+        cmd.add_param(key);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get all the value of the hash table
+    */
+    void hvals(const char* key, const array_result_handler& handler)
+    {
+        redis_command cmd("hvals");
+
+        cmd.add_param(key);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the field count of the hash table
+    */
+    void hlen(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("hlen");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief increase the value of the field by increment
+    * @param handler - the new value after increase
+    */
+    void hincrby(const char* key, const char* field, int64_t increment,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("hincrby");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(increment);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief increase the value of the field by float increment
+    * @param handler - the new value after increase
+    */
+    void hincrbyfloat(const char* key, const char* field, double increment,
+        const float_result_handler& handler)
+    {
+        redis_command cmd("hincrbyfloat");
+
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(increment);
+
+        get_float_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief incrementally iterate the hash table
+    * @param handler - the field value list with next cursor
+    */
+    void hscan(const char* key, uint64_t cursor, const scan_result_handler& handler,
+        const char* pattern = nullptr, const int32_t* count = nullptr)
+    {
+        scan_key("hscan", key, cursor, pattern, count, handler);
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,272 @@
+﻿/**
+ *
+ * redis_async_key.hpp
+ *
+ * async redis command of key
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_key_hpp__
+#define __ydk_rediscpp_detail_redis_async_key_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+#include <redis_cpp/detail/sync/redis_key.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+typedef std::function<void(bool success, redis_key_type type)> key_type_result_handler;
+
+class redis_async_key : virtual public redis_async_command_executor
+{
+public:
+    redis_async_key(){
+    }
+
+public:
+    /**
+    * @brief
+    * @param key - the key to been delete
+    * @param handler - the count of the key which been deleted
+    */
+    void del(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("del");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief del key list
+    * @param keys - key list( must in the same slot in cluster mode)
+    * @param handler - the count of the key which been deleted
+    */
+    void del(const std::vector<std::string>& keys, const integer_result_handler& handler)
+    {
+        redis_command cmd("del");
+
+        int32_t slot = keys.empty() ? -1 : key_slot(keys[0].c_str());
+
+        get_integer_result(cmd, slot, keys, handler);
+    }
+
+    /**
+    * @brief if key exists
+    */
+    void exist(const char* key, const boolean_result_handler& handler)
+    {
+        redis_command cmd("exists");
+
+        cmd.add_param(key);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set a key's lifetime in seconds
+    * @param key
+    * @param t - lifetime(in seconds)
+    * @param handler - value is false if the key not exist
+    */
+    void expire(const char* key, int32_t t, const boolean_result_handler& handler)
+    {
+        redis_command cmd("expire");
+
+        cmd.add_param(key);
+        cmd.add_param(t);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set key will expire at specific time( unix timestamp in seconds)
+    */
+    void expireat(const char* key, time_t stamp, const boolean_result_handler& handler)
+    {
+        redis_command cmd("expireat");
+
+        cmd.add_param(key);
+        cmd.add_param((uint32_t)stamp);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief find all the keys which fit the pattern
+    */
+    void keys_pattern(const char* pattern, const array_result_handler& handler)
+    {
+        redis_command cmd("keys");
+
+        cmd.add_param(pattern);
+
+        get_array_result(cmd, -1, handler);
+    }
+
+    /**
+    * @brief persist a key
+    */
+    void persist(const char* key, const boolean_result_handler& handler)
+    {
+        redis_command cmd("persist");
+
+        cmd.add_param(key);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the key's lifetime in millseconds
+    */
+    void pexpire(const char* key, uint32_t t, const boolean_result_handler& handler)
+    {
+        redis_command cmd("pexpire");
+
+        cmd.add_param(key);
+        cmd.add_param(t);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set key will expire at specific time( unix timestamp in milliseconds)
+    */
+    void pexpireat(const char* key, int64_t stamp, const boolean_result_handler& handler)
+    {
+        redis_command cmd("pexpireat");
+
+        cmd.add_param(key);
+        cmd.add_param(stamp);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief return the remain lifetime of the key in milliseconds
+    * @param handler - value is -2 if the key not exist,
+    *         -1 if the key exist but not set lifetime
+    */
+    void pttl(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("pttl");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief random return a key from the db
+    */
+    void randomkey(const string_result_handler& handler)
+    {
+        redis_command cmd("randomkey");
+
+        get_string_result(cmd, -1, handler);
+    }
+
+    /**
+    * @brief rename the key the new key
+    */
+    void rename(const char* key, const char* new_key, const status_result_handler& handler)
+    {
+        redis_command cmd("rename");
+
+        cmd.add_param(key);
+        cmd.add_param(new_key);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief rename the key to newkey only if the newkey not exist
+    */
+    void renamenx(const char* key, const char* new_key, const boolean_result_handler& handler)
+    {
+        redis_command cmd("renamenx");
+
+        cmd.add_param(key);
+        cmd.add_param(new_key);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief simple sort
+    */
+    void sort(const char* key, const array_result_handler& handler)
+    {
+        redis_command cmd("sort");
+
+        cmd.add_param(key);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief sort desc
+    */
+    void sortDesc(const char* key, const array_result_handler& handler)
+    {
+        redis_command cmd("sort");
+
+        cmd.add_param(key);
+        cmd.add_param("desc");
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief return the key's remain lifetime in seconds
+    * @param handler - value is -2 if key not exist,
+    *         -1 if key exist, but not set lifetime
+    */
+    void ttl(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("ttl");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief return the type of the value which the key store
+    */
+    void type(const char* key, const key_type_result_handler& handler)
+    {
+        redis_command cmd("type");
+
+        cmd.add_param(key);
+
+        get_string_result(cmd, key_slot(key),
+            [handler](bool success, const std::string& value){
+            if (handler){
+                handler(success, get_key_type_from_string(value));
+            }
+        });
+    }
+
+    /**
+    * @brief incrementally iterate the keys space in the specified database
+    * @param cursor
+    * @param handler - the result with next cursor
+    * @param pattern - match pattern
+    * @param count - limit the max number of the reslts stored in array
+    */
+    void scan(uint64_t cursor, const scan_result_handler& handler,
+        const char* pattern = nullptr, const int32_t* count = nullptr)
+    {
+        scan_key("scan", nullptr, cursor, pattern, count, handler);
+    }
+};
+}
+}
+
+#endif
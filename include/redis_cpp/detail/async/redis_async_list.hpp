@@ -0,0 +1,300 @@
+﻿/**
+ *
+ * redis_async_list.hpp
+ *
+ * async redis command of list
+ * the blocking commands( blpop, brpop, brpoplpush) are not provided,
+ * cause they will block the shared connection
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_list_hpp__
+#define __ydk_rediscpp_detail_redis_async_list_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+class redis_async_list : virtual public redis_async_command_executor
+{
+public:
+    redis_async_list(){
+    }
+
+public:
+    /**
+    * @brief get the element of the index
+    */
+    void lindex(const char* key, int32_t index, const string_result_handler& handler)
+    {
+        redis_command cmd("lindex");
+
+        cmd.add_param(key);
+        cmd.add_param(index);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief insert value before the pivot
+    * @param handler - the list length after insert, -1 if pivot not exist
+    */
+    void insert_before(const char* key, const char* pivot, const char* value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("linsert");
+
+        cmd.add_param(key);
+        cmd.add_param("before");
+        cmd.add_param(pivot);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief insert value after the pivot
+    * @param handler - the list length after insert, -1 if pivot not exist
+    */
+    void insert_after(const char* key, const char* pivot, const char* value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("linsert");
+
+        cmd.add_param(key);
+        cmd.add_param("after");
+        cmd.add_param(pivot);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the length of the list
+    */
+    void llen(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("llen");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief pop the head element of the list
+    */
+    void lpop(const char* key, const string_result_handler& handler)
+    {
+        redis_command cmd("lpop");
+
+        cmd.add_param(key);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief push value to the head of the list
+    * @param handler - the list length after push
+    */
+    void lpush(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("lpush");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief push value( binary) to the head of the list
+    */
+    void lpush(const char* key, const char* value, int32_t value_len,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("lpush");
+
+        cmd.add_param(key);
+        cmd.add_param(value, value_len);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief push values to the head of the list
+    */
+    void lpush(const char* key, const std::vector<std::string>& values,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("lpush");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), values, handler);
+    }
+
+    /**
+    * @brief push value to the head of the list only if the list exist
+    */
+    void lpushx(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("lpushx");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the elements in range [start, end]
+    */
+    void lrange(const char* key, int32_t start, int32_t end,
+        const array_result_handler& handler)
+    {
+        redis_command cmd("lrange");
+
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove the elements equal to value
+    * @param handler - the count of the removed elements
+    */
+    void lrem(const char* key, int32_t count, const char* value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("lrem");
+
+        cmd.add_param(key);
+        cmd.add_param(count);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the element of the index
+    */
+    void lset(const char* key, int32_t index, const char* value,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("lset");
+
+        cmd.add_param(key);
+        cmd.add_param(index);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief only keep the elements in range [start, end]
+    */
+    void ltrim(const char* key, int32_t start, int32_t end,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("ltrim");
+
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief pop the tail element of the list
+    */
+    void rpop(const char* key, const string_result_handler& handler)
+    {
+        redis_command cmd("rpop");
+
+        cmd.add_param(key);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief pop the tail element of the source list and push to the dest list
+    * ( must in the same slot in cluster mode)
+    */
+    void rpoplpush(const char* source_list, const char* dest_list,
+        const string_result_handler& handler)
+    {
+        redis_command cmd("rpoplpush");
+
+        cmd.add_param(source_list);
+        cmd.add_param(dest_list);
+
+        get_string_result(cmd, key_slot(source_list), handler);
+    }
+
+    /**
+    * @brief push value to the tail of the list
+    * @param handler - the list length after push
+    */
+    void rpush(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("rpush");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief push value( binary) to the tail of the list
+    */
+    void rpush(const char* key, const char* value, int32_t value_size,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("rpush");
+
+        cmd.add_param(key);
+        cmd.add_param(value, value_size);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief push values to the tail of the list
+    */
+    void rpush(const char* key, const std::vector<std::string>& values,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("rpush");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), values, handler);
+    }
+
+    /**
+    * @brief push value to the tail of the list only if the list exist
+    */
+    void rpushx(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("rpushx");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+};
+}
+}
+
+#endif
@@ -12,12 +12,70 @@
 #define __ydk_rediscpp_detail_redis_async_operator_hpp__
 
 #include <redis_cpp/detail/async/base_async_client.hpp>
+#include <redis_cpp/detail/async/redis_async_key.hpp>
+#include <redis_cpp/detail/async/redis_async_string.hpp>
+#include <redis_cpp/detail/async/redis_async_list.hpp>
+#include <redis_cpp/detail/async/redis_async_hash.hpp>
+#include <redis_cpp/detail/async/redis_async_set.hpp>
+#include <redis_cpp/detail/async/redis_async_zset.hpp>
+#include <redis_cpp/detail/async/redis_async_script.hpp>
 
 namespace redis_cpp
 {
 namespace detail
 {
-    typedef base_async_client redis_async_operator;
+class redis_async_operator :
+    public redis_async_key,
+    public redis_async_string,
+    public redis_async_list,
+    public redis_async_hash,
+    public redis_async_set,
+    public redis_async_zset,
+    public redis_async_script
+{
+public:
+    redis_async_operator(base_async_client* client){
+        set_async_client(client);
+    }
+
+    ~redis_async_operator(){
+    }
+
+public:
+    /** pubsub, forward to the async client */
+
+    /**
+    * @brief subscribe specific channel with specific message handler
+    */
+    void subscribe(const std::string& channel_name,
+        const channel_message_handler& message_handler,
+        const reply_handler& reply_handler){
+        if (async_client_){
+            async_client_->subscribe(channel_name, message_handler, reply_handler);
+        }
+    }
+
+    /**
+    * @brief unsubscribe specific channel
+    */
+    void unsubscribe(const std::string& channel_name,
+        const reply_handler& reply_handler){
+        if (async_client_){
+            async_client_->unsubscribe(channel_name, reply_handler);
+        }
+    }
+
+    /**
+    * @brief publish message to specific channel
+    */
+    void publish(const std::string& channel_name,
+        const std::string& message,
+        const reply_handler& reply_handler){
+        if (async_client_){
+            async_client_->publish(channel_name, message, reply_handler);
+        }
+    }
+};
 }
 }
 
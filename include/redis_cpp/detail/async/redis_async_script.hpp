@@ -0,0 +1,204 @@
+﻿/**
+ *
+ * redis_async_script.hpp
+ *
+ * async redis command of script
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_script_hpp__
+#define __ydk_rediscpp_detail_redis_async_script_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+#include <redis_cpp/detail/redis_cached_script.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+typedef std::function<void(bool success,
+    const std::vector<bool>& exists_list)> exists_list_result_handler;
+
+class redis_async_script : virtual public redis_async_command_executor
+{
+public:
+    redis_async_script(){
+    }
+
+public:
+    /**
+    * @brief exculate lua script
+    * @param script: the lua script
+    * @param keys:   the keys( must in the same slot in cluster mode)
+    * @param args:   the args
+    * @param handler: the raw reply handler
+    */
+    void eval(const char* script, const std::vector<std::string>& keys,
+        const std::vector<std::string>& args, const reply_handler& handler)
+    {
+        script_command("eval", script, keys, args, handler);
+    }
+
+    /**
+    * @brief evalsha command
+    * @param sha1:   the sha1 code generate by "script load"
+    */
+    void evalsha(const char* sha1, const std::vector<std::string>& keys,
+        const std::vector<std::string>& args, const reply_handler& handler)
+    {
+        script_command("evalsha", sha1, keys, args, handler);
+    }
+
+    /**
+    * @brief exculate the cached lua script by evalsha, load the script to the
+    * node and retry if the node reply NOSCRIPT
+    * @param script: the cached lua script
+    */
+    void eval(const redis_cached_script& script, const std::vector<std::string>& keys,
+        const std::vector<std::string>& args, const reply_handler& handler)
+    {
+        base_async_client* client = async_client_;
+        if (!client){
+            if (handler){
+                handler(nullptr);
+            }
+            return;
+        }
+
+        redis_command cmd;
+        build_script_command(cmd, "evalsha", script.sha1().c_str(), keys, args);
+        int32_t slot = keys.empty() ? -1 : key_slot(keys[0].c_str());
+        std::string script_text = script.script();
+
+        client->do_command(cmd, slot, [client, cmd, slot, script_text, handler](redis_reply_ptr reply){
+            if (!reply || !reply->is_error() ||
+                !redis_cached_script::is_noscript_error(reply->to_error().msg)){
+                if (handler){
+                    handler(reply);
+                }
+                return;
+            }
+
+            // load to the node of the slot, then retry
+            redis_command load_cmd("script");
+            load_cmd.add_param("load");
+            load_cmd.add_param(script_text);
+
+            client->do_command(load_cmd, slot, [client, cmd, slot, reply, handler](redis_reply_ptr load_reply){
+                if (!load_reply || !load_reply->is_string()){
+                    rds_log_error("redis_async_script load script failed.");
+                    if (handler){
+                        handler(reply);
+                    }
+                    return;
+                }
+
+                client->do_command(cmd, slot, handler);
+            });
+        });
+    }
+
+    /**
+    * @brief load the script to the cache
+    * @param handler - the script sha1 code
+    */
+    void script_load(const char* script, const string_result_handler& handler)
+    {
+        redis_command cmd("script");
+        cmd.add_param("load");
+        cmd.add_param(script);
+
+        get_string_result(cmd, -1, handler);
+    }
+
+    /**
+    * @brief check the scripts exist in the cache
+    */
+    void script_exists(const std::vector<std::string>& sha1_list,
+        const exists_list_result_handler& handler)
+    {
+        redis_command cmd("script");
+        cmd.add_param("exists");
+
+        for (auto& sha1 : sha1_list){
+            cmd.add_param(sha1);
+        }
+
+        do_command(cmd, -1, [handler](redis_reply_ptr reply){
+            if (!handler)
+                return;
+
+            std::vector<bool> exists_list;
+            if (!reply || !reply->is_array()){
+                handler(false, exists_list);
+                return;
+            }
+
+            redis_reply_arr& arr = reply->to_array();
+            for (auto& r : arr){
+                exists_list.push_back(!!r.to_integer_32());
+            }
+
+            handler(true, exists_list);
+        });
+    }
+
+    /**
+    * @brief kill the scripts that is running
+    */
+    void script_kill(const status_result_handler& handler)
+    {
+        redis_command cmd("script");
+        cmd.add_param("kill");
+
+        check_status_ok(cmd, -1, handler);
+    }
+
+    /**
+    * @brief clean all the script from the cache
+    */
+    void script_flush(const status_result_handler& handler)
+    {
+        redis_command cmd("script");
+        cmd.add_param("flush");
+
+        check_status_ok(cmd, -1, handler);
+    }
+
+protected:
+    void script_command(const char* script_cmd, const char* script,
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& args, const reply_handler& handler)
+    {
+        redis_command cmd;
+        build_script_command(cmd, script_cmd, script, keys, args);
+
+        int32_t slot = keys.empty() ? -1 : key_slot(keys[0].c_str());
+
+        do_command(cmd, slot, handler);
+    }
+
+    void build_script_command(redis_command& cmd, const char* script_cmd,
+        const char* script, const std::vector<std::string>& keys,
+        const std::vector<std::string>& args)
+    {
+        cmd.add_param(script_cmd);
+        cmd.add_param(script);
+        cmd.add_param((uint32_t)keys.size());
+
+        for (auto& param : keys){
+            cmd.add_param(param);
+        }
+
+        for (auto& param : args){
+            cmd.add_param(param);
+        }
+    }
+};
+}
+}
+
+#endif
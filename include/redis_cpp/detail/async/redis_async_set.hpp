@@ -0,0 +1,279 @@
+﻿/**
+ *
+ * redis_async_set.hpp
+ *
+ * async redis command of set
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_set_hpp__
+#define __ydk_rediscpp_detail_redis_async_set_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+class redis_async_set : virtual public redis_async_command_executor
+{
+public:
+    redis_async_set(){
+    }
+
+public:
+    /**
+    * @brief add member to the set
+    * @param handler - the count of the new member
+    */
+    void sadd(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("sadd");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief add member( binary) to the set
+    */
+    void sadd(const char* key, const char* value, int32_t size,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("sadd");
+
+        cmd.add_param(key);
+        cmd.add_param(value, size);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief add members to the set
+    */
+    void sadd(const char* key, const std::vector<std::string>& values,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("sadd");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), values, handler);
+    }
+
+    /**
+    * @brief get the member count of the set
+    */
+    void scard(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("scard");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove and return a random member
+    */
+    void spop(const char* key, const string_result_handler& handler)
+    {
+        redis_command cmd("spop");
+
+        cmd.add_param(key);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief return a random member
+    */
+    void srandmember(const char* key, const string_result_handler& handler)
+    {
+        redis_command cmd("srandmember");
+
+        cmd.add_param(key);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief return random members
+    * @param count - positive for distinct members, negative allow repeated members
+    */
+    void srandmember(const char* key, int32_t count, const array_result_handler& handler)
+    {
+        redis_command cmd("srandmember");
+
+        cmd.add_param(key);
+        cmd.add_param(count);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get all the members of the set
+    */
+    void smembers(const char* key, const array_result_handler& handler)
+    {
+        redis_command cmd("smembers");
+
+        cmd.add_param(key);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief check the value is member of the set
+    */
+    void sismember(const char* key, const char* value, const boolean_result_handler& handler)
+    {
+        redis_command cmd("sismember");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove member from the set
+    * @param handler - the count of the removed member
+    */
+    void srem(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("srem");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove members from the set
+    */
+    void srem(const char* key, const std::vector<std::string>& values_to_remove,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("srem");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), values_to_remove, handler);
+    }
+
+    /**
+    * @brief move member from source set to dest set
+    * ( must in the same slot in cluster mode)
+    */
+    void smove(const char* source_set, const char* dest_set, const char* value,
+        const boolean_result_handler& handler)
+    {
+        redis_command cmd("smove");
+
+        cmd.add_param(source_set);
+        cmd.add_param(dest_set);
+        cmd.add_param(value);
+
+        get_boolean_result(cmd, key_slot(source_set), handler);
+    }
+
+    /**
+    * @brief the difference of the sets
+    */
+    void sdiff(const std::vector<std::string>& set_list, const array_result_handler& handler)
+    {
+        set_operate("sdiff", set_list, handler);
+    }
+
+    /**
+    * @brief store the difference of the sets to the dest set
+    * @param handler - the member count of the dest set
+    */
+    void sdiffstore(const char* dest_set, const std::vector<std::string>& set_list,
+        const integer_result_handler& handler)
+    {
+        set_store("sdiffstore", dest_set, set_list, handler);
+    }
+
+    /**
+    * @brief the intersection of the sets
+    */
+    void sinter(const std::vector<std::string>& set_list, const array_result_handler& handler)
+    {
+        set_operate("sinter", set_list, handler);
+    }
+
+    /**
+    * @brief store the intersection of the sets to the dest set
+    */
+    void sinterstore(const char* dest_set, const std::vector<std::string>& set_list,
+        const integer_result_handler& handler)
+    {
+        set_store("sinterstore", dest_set, set_list, handler);
+    }
+
+    /**
+    * @brief the union of the sets
+    */
+    void sunion(const std::vector<std::string>& set_list, const array_result_handler& handler)
+    {
+        set_operate("sunion", set_list, handler);
+    }
+
+    /**
+    * @brief store the union of the sets to the dest set
+    */
+    void sunionstore(const char* dest_set, const std::vector<std::string>& set_list,
+        const integer_result_handler& handler)
+    {
+        set_store("sunionstore", dest_set, set_list, handler);
+    }
+
+    /**
+    * @brief incrementally iterate the set
+    */
+    void sscan(const char* key, uint64_t cursor, const scan_result_handler& handler,
+        const char* pattern = nullptr, const int32_t* count = nullptr)
+    {
+        scan_key("sscan", key, cursor, pattern, count, handler);
+    }
+
+protected:
+    /**
+    * @brief sdiff, sinter, sunion( the sets must in the same slot in cluster mode)
+    */
+    void set_operate(const char* set_cmd, const std::vector<std::string>& set_list,
+        const array_result_handler& handler)
+    {
+        redis_command cmd(set_cmd);
+
+        int32_t slot = set_list.empty() ? -1 : key_slot(set_list[0].c_str());
+
+        get_array_result(cmd, slot, set_list, handler);
+    }
+
+    /**
+    * @brief sdiffstore, sinterstore, sunionstore
+    */
+    void set_store(const char* store_cmd, const char* dest_set,
+        const std::vector<std::string>& set_list,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd(store_cmd);
+
+        cmd.add_param(dest_set);
+
+        get_integer_result(cmd, key_slot(dest_set), set_list, handler);
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,437 @@
+﻿/**
+ *
+ * redis_async_string.hpp
+ *
+ * async redis command of string
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_string_hpp__
+#define __ydk_rediscpp_detail_redis_async_string_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+class redis_async_string : virtual public redis_async_command_executor
+{
+public:
+    redis_async_string(){
+    }
+
+public:
+    /**
+    * @brief append value to the key
+    * @param handler - the string length after append
+    */
+    void append(const char* key, const char* append_value, int32_t size,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("append");
+
+        cmd.add_param(key);
+        cmd.add_param(append_value, size);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief count the bit which been set to 1
+    */
+    void bitcount(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("bitcount");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief bit operatation
+    * @param operate - AND, OR, XOR, NOT
+    * @param destkey - the key to save the result
+    * @param keys - the keys to do bit operatation
+    * @param handler - the result string length
+    */
+    void bitop(const char* operate, const char* destkey,
+        const std::vector<std::string>& keys,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("bitop");
+
+        cmd.add_param(operate);
+        cmd.add_param(destkey);
+
+        get_integer_result(cmd, key_slot(destkey), keys, handler);
+    }
+
+    /**
+    * @brief decrease 1 of the value
+    * @param handler - the new value after decrease
+    */
+    void decr(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("decr");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief decrease the value by decrement
+    * @param handler - the new value after decrease
+    */
+    void decrby(const char* key, int32_t decrement, const integer_result_handler& handler)
+    {
+        redis_command cmd("decrby");
+
+        cmd.add_param(key);
+        cmd.add_param(decrement);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the value of the key
+    * @param handler - success is false if the key not exist
+    */
+    void get(const char* key, const string_result_handler& handler)
+    {
+        redis_command cmd("get");
+
+        cmd.add_param(key);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the bit value of the specific offset
+    */
+    void getbit(const char* key, int32_t offset, const integer_result_handler& handler)
+    {
+        redis_command cmd("getbit");
+
+        cmd.add_param(key);
+        cmd.add_param(offset);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the sub string of the value
+    */
+    void getrange(const char* key, int32_t start, int32_t end,
+        const string_result_handler& handler)
+    {
+        redis_command cmd("getrange");
+
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set new value and get the old value
+    */
+    void getset(const char* key, const char* value, const string_result_handler& handler)
+    {
+        redis_command cmd("getset");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_string_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief increase 1 of the value
+    * @param handler - the new value after increase
+    */
+    void incr(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("incr");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief increase the value by increment
+    * @param handler - the new value after increase
+    */
+    void incrby(const char* key, int64_t increment, const integer_result_handler& handler)
+    {
+        redis_command cmd("incrby");
+
+        cmd.add_param(key);
+        cmd.add_param(increment);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief increase the value by float increment
+    * @param handler - the new value after increase
+    */
+    void incrbyfloat(const char* key, double increment, const float_result_handler& handler)
+    {
+        redis_command cmd("incrbyfloat");
+
+        cmd.add_param(key);
+        cmd.add_param(increment);
+
+        get_float_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the values of the keys( must in the same slot in cluster mode)
+    * @param handler - the values, the value of the key not exist is skipped
+    */
+    void mget(const std::vector<std::string>& keys, const array_result_handler& handler)
+    {
+        redis_command cmd("mget");
+
+        int32_t slot = keys.empty() ? -1 : key_slot(keys[0].c_str());
+
+        get_array_result(cmd, slot, keys, handler);
+    }
+
+    /**
+    * @brief set the key value pairs( must in the same slot in cluster mode)
+    */
+    void mset(const std::unordered_map<std::string, std::string>& kv_pairs,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("mset");
+
+        for (auto& kv : kv_pairs){
+            cmd.add_param(kv.first);
+            cmd.add_param(kv.second);
+        }
+
+        int32_t slot = kv_pairs.empty() ? -1 : key_slot(kv_pairs.begin()->first.c_str());
+
+        check_status_ok(cmd, slot, handler);
+    }
+
+    /**
+    * @brief set the key value pairs only if all the key not exist
+    */
+    void msetnx(const std::unordered_map<std::string, std::string>& kv_pairs,
+        const boolean_result_handler& handler)
+    {
+        redis_command cmd("msetnx");
+
+        for (auto& kv : kv_pairs){
+            cmd.add_param(kv.first);
+            cmd.add_param(kv.second);
+        }
+
+        int32_t slot = kv_pairs.empty() ? -1 : key_slot(kv_pairs.begin()->first.c_str());
+
+        get_boolean_result(cmd, slot, handler);
+    }
+
+    /**
+    * @brief set the value with lifetime( in seconds)
+    */
+    void setex(const char* key, const char* value, int32_t lifetime,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("setex");
+
+        cmd.add_param(key);
+        cmd.add_param(lifetime);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value with lifetime( in milliseconds)
+    */
+    void psetex(const char* key, const char* value, int32_t lifetime,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("psetex");
+
+        cmd.add_param(key);
+        cmd.add_param(lifetime);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value only if the key not exist
+    */
+    void setnx(const char* key, const char* value, const boolean_result_handler& handler)
+    {
+        redis_command cmd("setnx");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_boolean_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set 'key' 'value' ex lifetime nx
+    * @param life_time - (in seconds)
+    */
+    void setnxex(const char* key, const std::string& value, int32_t lifetime,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+        cmd.add_param("ex");
+        cmd.add_param(lifetime);
+        cmd.add_param("nx");
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set 'key' 'value' px lifetime nx
+    * @param life_time - (in milliseconds)
+    */
+    void setnxpx(const char* key, const std::string& value, int32_t lifetime,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+        cmd.add_param("px");
+        cmd.add_param(lifetime);
+        cmd.add_param("nx");
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value of the key
+    */
+    void set(const char* key, const char* value, const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the value( binary) of the key
+    */
+    void set(const char* key, const char* value, int32_t value_len,
+        const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value, value_len);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the integer value of the key
+    */
+    void set(const char* key, int32_t value, const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the integer value of the key
+    */
+    void set(const char* key, int64_t value, const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the float value of the key
+    */
+    void set(const char* key, double value, const status_result_handler& handler)
+    {
+        redis_command cmd("set");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        check_status_ok(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief set the bit of the specific offset
+    * @param handler - the old bit value
+    */
+    void setbit(const char* key, int32_t offset, bool bit,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("setbit");
+
+        cmd.add_param(key);
+        cmd.add_param(offset);
+        cmd.add_param(bit ? 1 : 0);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief overwrite the value from the offset
+    * @param handler - the string length after modify
+    */
+    void setrange(const char* key, int32_t offset, const char* new_value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("setrange");
+
+        cmd.add_param(key);
+        cmd.add_param(offset);
+        cmd.add_param(new_value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the length of the value
+    */
+    void strlen(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("strlen");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,456 @@
+﻿/**
+ *
+ * redis_async_zset.hpp
+ *
+ * async redis command of sorted set
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-05
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_async_zset_hpp__
+#define __ydk_rediscpp_detail_redis_async_zset_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+
+namespace redis_cpp
+{
+namespace detail
+{
+class redis_async_zset : virtual public redis_async_command_executor
+{
+public:
+    redis_async_zset(){
+    }
+
+public:
+    /**
+    * @brief add member with score to the sorted set
+    * @param handler - the added count
+    */
+    void zadd(const char* key, double score, const char* value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zadd");
+
+        cmd.add_param(key);
+        cmd.add_param(score);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief add members with score to the sorted set
+    * @param sv_pairs - score value pairs
+    */
+    void zadd(const char* key,
+        const std::vector<std::pair<double, std::string>>& sv_pairs,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zadd");
+
+        cmd.add_param(key);
+
+        for (auto& sv : sv_pairs){
+            cmd.add_param(sv.first);
+            cmd.add_param(sv.second);
+        }
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the member count of the sorted set
+    */
+    void zcard(const char* key, const integer_result_handler& handler)
+    {
+        redis_command cmd("zcard");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the member count which score in [min, max]
+    */
+    void zcount(const char* key, double min, double max,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zcount");
+
+        cmd.add_param(key);
+        cmd.add_param(min);
+        cmd.add_param(max);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the members in index section [start, end], sort by score
+    */
+    void zrange(const char* key, int32_t start, int32_t end,
+        const array_result_handler& handler)
+    {
+        z_range("zrange", key, start, end, handler);
+    }
+
+    /**
+    * @brief get the members with score in index section [start, end]
+    */
+    void zrangewithscores(const char* key, int32_t start, int32_t end,
+        const score_result_handler& handler)
+    {
+        z_rangewithscores("zrange", key, start, end, handler);
+    }
+
+    /**
+    * @brief get the members by score section
+    */
+    void zrangebyscore(const char* key, double min_score, double max_score,
+        const array_result_handler& handler,
+        const int32_t* offset = nullptr, const int32_t* count = nullptr)
+    {
+        redis_command cmd("zrangebyscore");
+        z_score_range_param(cmd, key, min_score, max_score, false, offset, count);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the members with score by score section
+    */
+    void zrangebyscorewithscore(const char* key, double min_score, double max_score,
+        const score_result_handler& handler,
+        const int32_t* offset = nullptr, const int32_t* count = nullptr)
+    {
+        redis_command cmd("zrangebyscore");
+        z_score_range_param(cmd, key, min_score, max_score, true, offset, count);
+
+        get_score_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the rank of the member
+    */
+    void zrank(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        z_rank("zrank", key, value, handler);
+    }
+
+    /**
+    * @brief get the members in index section [start, end], sort by score desc
+    */
+    void zrevrange(const char* key, int32_t start, int32_t end,
+        const array_result_handler& handler)
+    {
+        z_range("zrevrange", key, start, end, handler);
+    }
+
+    /**
+    * @brief get the members with score in index section [start, end], sort by score desc
+    */
+    void zrevrangewithscores(const char* key, int32_t start, int32_t end,
+        const score_result_handler& handler)
+    {
+        z_rangewithscores("zrevrange", key, start, end, handler);
+    }
+
+    /**
+    * @brief get the members by score section, sort by score desc
+    */
+    void zrevrangebyscore(const char* key, double max_score, double min_score,
+        const array_result_handler& handler,
+        const int32_t* offset = nullptr, const int32_t* count = nullptr)
+    {
+        redis_command cmd("zrevrangebyscore");
+        z_score_range_param(cmd, key, max_score, min_score, false, offset, count);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the members with score by score section, sort by score desc
+    */
+    void zrevrangebyscorewithscore(const char* key, double max_score, double min_score,
+        const score_result_handler& handler,
+        const int32_t* offset = nullptr, const int32_t* count = nullptr)
+    {
+        redis_command cmd("zrevrangebyscore");
+        z_score_range_param(cmd, key, max_score, min_score, true, offset, count);
+
+        get_score_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the rank of the member, sort by score desc
+    */
+    void zrevrank(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        z_rank("zrevrank", key, value, handler);
+    }
+
+    /**
+    * @brief get the score of the member
+    */
+    void zscore(const char* key, const char* value, const float_result_handler& handler)
+    {
+        redis_command cmd("zscore");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_float_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief increase the member's score by increment
+    * @param handler - the new score
+    */
+    void zincrby(const char* key, double increment, const char* value,
+        const float_result_handler& handler)
+    {
+        redis_command cmd("zincrby");
+
+        cmd.add_param(key);
+        cmd.add_param(increment);
+        cmd.add_param(value);
+
+        get_float_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove member from the sorted set
+    * @param handler - the removed count
+    */
+    void zrem(const char* key, const char* value, const integer_result_handler& handler)
+    {
+        redis_command cmd("zrem");
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove members from the sorted set
+    */
+    void zrem(const char* key, const std::vector<std::string>& values,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zrem");
+
+        cmd.add_param(key);
+
+        get_integer_result(cmd, key_slot(key), values, handler);
+    }
+
+    /**
+    * @brief remove the members in rank section [start_rank, end_rank]
+    */
+    void zremrangebyrank(const char* key, int32_t start_rank, int32_t end_rank,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zremrangebyrank");
+
+        cmd.add_param(key);
+        cmd.add_param(start_rank);
+        cmd.add_param(end_rank);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove the members in score section [min, max]
+    */
+    void zremrangebyscore(const char* key, double min, double max,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zremrangebyscore");
+
+        cmd.add_param(key);
+        cmd.add_param(min);
+        cmd.add_param(max);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief remove the members in lex section
+    * @param min_member - start with '(' or '['
+    * @param max_member - start with '(' or '['
+    */
+    void zremrangebylex(const char* key, const char* min_member, const char* max_member,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zremrangebylex");
+
+        cmd.add_param(key);
+        cmd.add_param(min_member);
+        cmd.add_param(max_member);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief count the members in lex section
+    */
+    void zlexcount(const char* key, const char* min_member, const char* max_member,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd("zlexcount");
+
+        cmd.add_param(key);
+        cmd.add_param(min_member);
+        cmd.add_param(max_member);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief get the members in lex section
+    */
+    void zrangebylex(const char* key, const char* min_member, const char* max_member,
+        const array_result_handler& handler,
+        const int32_t* offset = nullptr, const int32_t* count = nullptr)
+    {
+        redis_command cmd("zrangebylex");
+
+        cmd.add_param(key);
+        cmd.add_param(min_member);
+        cmd.add_param(max_member);
+
+        if (offset && count){
+            cmd.add_param("limit");
+            cmd.add_param(*offset);
+            cmd.add_param(*count);
+        }
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    /**
+    * @brief save the union of muti set to the dest_set
+    * @param weights - could be null
+    * @param aggregate [ SUM|MIN|MAX ]
+    * @param handler - the result set size
+    */
+    void zunionstore(const char* dest_set, const std::vector<std::string>& keys,
+        const std::vector<double>* weights, const char* aggregate,
+        const integer_result_handler& handler)
+    {
+        z_store("zunionstore", dest_set, keys, weights, aggregate, handler);
+    }
+
+    /**
+    * @brief save the intersecion of muti set to the dest_set
+    */
+    void zinterstore(const char* dest_set, const std::vector<std::string>& keys,
+        const std::vector<double>* weights, const char* aggregate,
+        const integer_result_handler& handler)
+    {
+        z_store("zinterstore", dest_set, keys, weights, aggregate, handler);
+    }
+
+    /**
+    * @brief incrementally iterate the sorted set
+    * @param handler - the member score list( member, score, member, score ...)
+    */
+    void zscan(const char* key, uint64_t cursor, const scan_result_handler& handler,
+        const char* pattern = nullptr, const int32_t* count = nullptr)
+    {
+        scan_key("zscan", key, cursor, pattern, count, handler);
+    }
+
+protected:
+    void z_range(const char* range_cmd, const char* key, int32_t start, int32_t end,
+        const array_result_handler& handler)
+    {
+        redis_command cmd(range_cmd);
+
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+
+        get_array_result(cmd, key_slot(key), handler);
+    }
+
+    void z_rangewithscores(const char* range_cmd, const char* key, int32_t start, int32_t end,
+        const score_result_handler& handler)
+    {
+        redis_command cmd(range_cmd);
+
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+        cmd.add_param("withscores");
+
+        get_score_result(cmd, key_slot(key), handler);
+    }
+
+    void z_score_range_param(redis_command& cmd, const char* key,
+        double start_score, double end_score, bool withscores,
+        const int32_t* offset, const int32_t* count)
+    {
+        cmd.add_param(key);
+        cmd.add_param(start_score);
+        cmd.add_param(end_score);
+
+        if (withscores){
+            cmd.add_param("withscores");
+        }
+
+        if (offset && count){
+            cmd.add_param("limit");
+            cmd.add_param(*offset);
+            cmd.add_param(*count);
+        }
+    }
+
+    void z_rank(const char* rank_cmd, const char* key, const char* value,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd(rank_cmd);
+
+        cmd.add_param(key);
+        cmd.add_param(value);
+
+        get_integer_result(cmd, key_slot(key), handler);
+    }
+
+    void z_store(const char* zstore_cmd, const char* dest_set,
+        const std::vector<std::string>& keys,
+        const std::vector<double>* weights, const char* aggregate,
+        const integer_result_handler& handler)
+    {
+        redis_command cmd(zstore_cmd);
+
+        cmd.add_param(dest_set);
+        cmd.add_param((uint32_t)keys.size());
+
+        for (auto& key : keys){
+            cmd.add_param(key);
+        }
+
+        if (weights && weights->size() > 0){
+            cmd.add_param("weights");
+            for (auto w : *weights){
+                cmd.add_param(w);
+            }
+        }
+
+        if (aggregate){
+            cmd.add_param("aggregate");
+            cmd.add_param(aggregate);
+        }
+
+        get_integer_result(cmd, key_slot(dest_set), handler);
+    }
+};
+}
+}
+
+#endif
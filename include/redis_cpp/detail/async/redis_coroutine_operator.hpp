@@ -0,0 +1,520 @@
+﻿/**
+ *
+ * redis_coroutine_operator.hpp
+ *
+ * c++20 coroutine awaitable redis commands, only available while
+ * REDIS_CPP_HAS_COROUTINE defined
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-10
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_coroutine_operator_hpp__
+#define __ydk_rediscpp_detail_redis_coroutine_operator_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+
+#if defined(REDIS_CPP_HAS_COROUTINE)
+
+#include <redis_cpp/detail/async/redis_async_command_executor.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <utility/asio_base/asio_standalone.hpp>
+#include <asio/io_service.hpp>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+
+namespace redis_cpp
+{
+namespace detail
+{
+/** the result of the awaitable command, success is false if the command failed */
+template<typename T>
+struct redis_await_result
+{
+    bool    success = false;
+    T       value{};
+
+    explicit operator bool() const{
+        return success;
+    }
+};
+
+/** reply converters, return false if the reply type not match */
+namespace reply_convert
+{
+    static bool to_reply(redis_reply_ptr reply, redis_reply_ptr& out){
+        out = reply;
+        return !!reply;
+    }
+
+    static bool to_status(redis_reply_ptr reply, bool& out){
+        out = reply && reply->is_string() && reply->check_status_ok();
+        return out;
+    }
+
+    static bool to_boolean(redis_reply_ptr reply, bool& out){
+        if (!reply || !reply->is_integer())
+            return false;
+        out = !!reply->to_integer();
+        return true;
+    }
+
+    static bool to_integer(redis_reply_ptr reply, int64_t& out){
+        if (!reply || !reply->is_integer())
+            return false;
+        out = reply->to_integer();
+        return true;
+    }
+
+    static bool to_float(redis_reply_ptr reply, double& out){
+        if (!reply || !reply->is_string())
+            return false;
+        out = atof(reply->to_string().c_str());
+        return true;
+    }
+
+    static bool to_string(redis_reply_ptr reply, std::string& out){
+        if (!reply || !reply->is_string())
+            return false;
+        out = std::move(reply->to_string());
+        return true;
+    }
+
+    static bool to_array(redis_reply_ptr reply, std::vector<std::string>& out){
+        if (!reply || !reply->is_array())
+            return false;
+        for (auto& r : reply->to_array()){
+            if (r.is_string()){
+                out.push_back(std::move(r.to_string()));
+            }
+        }
+        return true;
+    }
+
+    static bool to_map(redis_reply_ptr reply, std::unordered_map<std::string, std::string>& out){
+        if (!reply || !reply->is_array() || reply->to_array().size() % 2 != 0)
+            return false;
+        redis_reply_arr& arr = reply->to_array();
+        for (std::size_t i = 0; i + 1 < arr.size(); i += 2){
+            out[arr[i].to_string()] = std::move(arr[i + 1].to_string());
+        }
+        return true;
+    }
+
+    static bool to_scores(redis_reply_ptr reply, std::vector<std::pair<std::string, double>>& out){
+        if (!reply || !reply->is_array() || reply->to_array().size() % 2 != 0)
+            return false;
+        redis_reply_arr& arr = reply->to_array();
+        for (std::size_t i = 0; i + 1 < arr.size(); i += 2){
+            out.push_back(std::make_pair(std::move(arr[i].to_string()),
+                atof(arr[i + 1].to_string().c_str())));
+        }
+        return true;
+    }
+}
+
+/**
+ * awaitable of a single redis command
+ * the command is sent in await_suspend, the result is stored in the awaitable
+ * itself( which lives in the coroutine frame), so no promise/future needed.
+ * the coroutine resumes on the io thread which received the reply, or is posted
+ * to the executor if it is set.
+ */
+template<typename T>
+class redis_awaitable
+{
+public:
+    typedef bool(*reply_converter)(redis_reply_ptr, T&);
+
+protected:
+    base_async_client*          client_;
+    asio::io_service*           executor_;
+    redis_command               cmd_;
+    int32_t                     hash_slot_;
+    reply_converter             converter_;
+    redis_await_result<T>       result_;
+    std::atomic<bool>           arrived_;   // set by the first of the handler and await_suspend
+
+public:
+    redis_awaitable(base_async_client* client, asio::io_service* executor,
+        redis_command&& cmd, int32_t hash_slot, reply_converter converter)
+        : client_(client)
+        , executor_(executor)
+        , cmd_(std::move(cmd))
+        , hash_slot_(hash_slot)
+        , converter_(converter)
+        , arrived_(false)
+    {
+    }
+
+public:
+    bool await_ready() const noexcept{
+        return false;
+    }
+
+    /**
+     * @return false to resume at once if the handler was called before return( like
+     * the client not connected), not resume inline on the caller's stack
+     */
+    bool await_suspend(std::coroutine_handle<> h){
+        if (!client_){
+            return false;
+        }
+
+        // the later one resumes, the frame may be destroyed once resumed
+        redis_awaitable* self = this;
+        client_->do_command(cmd_, hash_slot_, [self, h](redis_reply_ptr reply){
+            self->result_.success = self->converter_(reply, self->result_.value);
+            if (self->arrived_.exchange(true)){
+                self->resume(h);
+            }
+        });
+
+        return !arrived_.exchange(true);
+    }
+
+    redis_await_result<T> await_resume(){
+        return std::move(result_);
+    }
+
+protected:
+    void resume(std::coroutine_handle<> h){
+        if (executor_){
+            executor_->post([h](){ h.resume(); });
+        }
+        else{
+            h.resume();
+        }
+    }
+};
+
+/**
+ * a detached coroutine task, starts eagerly and frees its frame when finished
+ * like: redis_task run(redis_coroutine_operator& op){ auto r = co_await op.get("key"); ... }
+ */
+struct redis_task
+{
+    struct promise_type
+    {
+        redis_task get_return_object() noexcept{
+            return redis_task();
+        }
+
+        std::suspend_never initial_suspend() noexcept{
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend() noexcept{
+            return std::suspend_never();
+        }
+
+        void return_void() noexcept{
+        }
+
+        void unhandled_exception() noexcept{
+            rds_log_error("redis_task unhandled exception, terminate.");
+            std::terminate();
+        }
+    };
+};
+
+class redis_coroutine_operator : public redis_async_command_executor
+{
+protected:
+    asio::io_service*   executor_;
+
+public:
+    /**
+     * @param client - the async client
+     * @param executor - resume the coroutine on this io_service, null if
+     * resume inline on the io thread which received the reply
+     */
+    redis_coroutine_operator(base_async_client* client, asio::io_service* executor = nullptr)
+        : executor_(executor)
+    {
+        set_async_client(client);
+    }
+
+    void    set_executor(asio::io_service* executor){
+        executor_ = executor;
+    }
+
+public:
+    /** generic command */
+    redis_awaitable<redis_reply_ptr> command(redis_command cmd, int32_t hash_slot = -1){
+        return make_awaitable(std::move(cmd), hash_slot, &reply_convert::to_reply);
+    }
+
+    /** key */
+    redis_awaitable<int64_t> del(const char* key){
+        redis_command cmd("del");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<bool> exist(const char* key){
+        redis_command cmd("exists");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_boolean);
+    }
+
+    redis_awaitable<bool> expire(const char* key, int32_t t){
+        redis_command cmd("expire");
+        cmd.add_param(key);
+        cmd.add_param(t);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_boolean);
+    }
+
+    redis_awaitable<bool> pexpire(const char* key, uint32_t t){
+        redis_command cmd("pexpire");
+        cmd.add_param(key);
+        cmd.add_param(t);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_boolean);
+    }
+
+    redis_awaitable<int64_t> ttl(const char* key){
+        redis_command cmd("ttl");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    /** string */
+    redis_awaitable<std::string> get(const char* key){
+        redis_command cmd("get");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_string);
+    }
+
+    redis_awaitable<bool> set(const char* key, const std::string& value){
+        redis_command cmd("set");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_status);
+    }
+
+    redis_awaitable<bool> setex(const char* key, const std::string& value, int32_t lifetime){
+        redis_command cmd("setex");
+        cmd.add_param(key);
+        cmd.add_param(lifetime);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_status);
+    }
+
+    redis_awaitable<bool> setnx(const char* key, const std::string& value){
+        redis_command cmd("setnx");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_boolean);
+    }
+
+    redis_awaitable<int64_t> incr(const char* key){
+        redis_command cmd("incr");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<int64_t> incrby(const char* key, int64_t increment){
+        redis_command cmd("incrby");
+        cmd.add_param(key);
+        cmd.add_param(increment);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<std::vector<std::string>> mget(const std::vector<std::string>& keys){
+        redis_command cmd("mget");
+        for (auto& key : keys){
+            cmd.add_param(key);
+        }
+        int32_t slot = keys.empty() ? -1 : key_slot(keys[0].c_str());
+        return make_awaitable(std::move(cmd), slot, &reply_convert::to_array);
+    }
+
+    /** hash */
+    redis_awaitable<std::string> hget(const char* key, const char* field){
+        redis_command cmd("hget");
+        cmd.add_param(key);
+        cmd.add_param(field);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_string);
+    }
+
+    redis_awaitable<int64_t> hset(const char* key, const char* field, const std::string& value){
+        redis_command cmd("hset");
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<int64_t> hdel(const char* key, const char* field){
+        redis_command cmd("hdel");
+        cmd.add_param(key);
+        cmd.add_param(field);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<int64_t> hincrby(const char* key, const char* field, int64_t increment){
+        redis_command cmd("hincrby");
+        cmd.add_param(key);
+        cmd.add_param(field);
+        cmd.add_param(increment);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<std::unordered_map<std::string, std::string>> hgetall(const char* key){
+        redis_command cmd("hgetall");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_map);
+    }
+
+    /** list */
+    redis_awaitable<int64_t> lpush(const char* key, const std::string& value){
+        redis_command cmd("lpush");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<int64_t> rpush(const char* key, const std::string& value){
+        redis_command cmd("rpush");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<std::string> lpop(const char* key){
+        redis_command cmd("lpop");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_string);
+    }
+
+    redis_awaitable<std::string> rpop(const char* key){
+        redis_command cmd("rpop");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_string);
+    }
+
+    redis_awaitable<std::vector<std::string>> lrange(const char* key, int32_t start, int32_t end){
+        redis_command cmd("lrange");
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_array);
+    }
+
+    /** set */
+    redis_awaitable<int64_t> sadd(const char* key, const std::string& value){
+        redis_command cmd("sadd");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<int64_t> srem(const char* key, const std::string& value){
+        redis_command cmd("srem");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<bool> sismember(const char* key, const std::string& value){
+        redis_command cmd("sismember");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_boolean);
+    }
+
+    redis_awaitable<std::vector<std::string>> smembers(const char* key){
+        redis_command cmd("smembers");
+        cmd.add_param(key);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_array);
+    }
+
+    /** sorted set */
+    redis_awaitable<int64_t> zadd(const char* key, double score, const std::string& value){
+        redis_command cmd("zadd");
+        cmd.add_param(key);
+        cmd.add_param(score);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<double> zscore(const char* key, const std::string& value){
+        redis_command cmd("zscore");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_float);
+    }
+
+    redis_awaitable<double> zincrby(const char* key, double increment, const std::string& value){
+        redis_command cmd("zincrby");
+        cmd.add_param(key);
+        cmd.add_param(increment);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_float);
+    }
+
+    redis_awaitable<int64_t> zrem(const char* key, const std::string& value){
+        redis_command cmd("zrem");
+        cmd.add_param(key);
+        cmd.add_param(value);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_integer);
+    }
+
+    redis_awaitable<std::vector<std::string>> zrange(const char* key, int32_t start, int32_t end){
+        redis_command cmd("zrange");
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_array);
+    }
+
+    redis_awaitable<std::vector<std::pair<std::string, double>>> zrangewithscores(
+        const char* key, int32_t start, int32_t end){
+        redis_command cmd("zrange");
+        cmd.add_param(key);
+        cmd.add_param(start);
+        cmd.add_param(end);
+        cmd.add_param("withscores");
+        return make_awaitable(std::move(cmd), key_slot(key), &reply_convert::to_scores);
+    }
+
+    /** script */
+    redis_awaitable<redis_reply_ptr> eval(const char* script,
+        const std::vector<std::string>& keys, const std::vector<std::string>& args){
+        return script_command("eval", script, keys, args);
+    }
+
+    redis_awaitable<redis_reply_ptr> evalsha(const char* sha1,
+        const std::vector<std::string>& keys, const std::vector<std::string>& args){
+        return script_command("evalsha", sha1, keys, args);
+    }
+
+protected:
+    template<typename T>
+    redis_awaitable<T> make_awaitable(redis_command&& cmd, int32_t hash_slot,
+        bool(*converter)(redis_reply_ptr, T&)){
+        return redis_awaitable<T>(async_client_, executor_, std::move(cmd), hash_slot, converter);
+    }
+
+    redis_awaitable<redis_reply_ptr> script_command(const char* script_cmd, const char* script,
+        const std::vector<std::string>& keys, const std::vector<std::string>& args){
+        redis_command cmd(script_cmd);
+        cmd.add_param(script);
+        cmd.add_param((uint32_t)keys.size());
+        for (auto& param : keys){
+            cmd.add_param(param);
+        }
+        for (auto& param : args){
+            cmd.add_param(param);
+        }
+        int32_t slot = keys.empty() ? -1 : key_slot(keys[0].c_str());
+        return make_awaitable(std::move(cmd), slot, &reply_convert::to_reply);
+    }
+};
+}
+}
+
+#endif
+
+#endif
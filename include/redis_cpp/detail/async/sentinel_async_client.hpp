@@ -13,7 +13,21 @@
 
 #include <redis_cpp/detail/config.hpp>
 #include <redis_cpp/detail/async/standalone_async_client.hpp>
+#include <redis_cpp/detail/async/standalone_async_client_pool.hpp>
 #include <redis_cpp/detail/sentinel/sentinel_client_pool.hpp>
+#include <redis_cpp/detail/sentinel/sentinel_failover_option.hpp>
+#include <redis_cpp/detail/sentinel/sentinel_replica_option.hpp>
+#include <redis_cpp/detail/sync/replica_selector.hpp>
+#include <utility/asio_base/timer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
 
 namespace redis_cpp
 {
@@ -23,20 +37,114 @@ class sentinel_async_client :
     public standalone_async_client,
     public event_subscriber
 {
+protected:
+    /** the command buffered while switching */
+    struct buffered_request
+    {
+        redis_command   cmd;
+        int32_t         hash_slot;
+        reply_handler   handler;
+    };
+
+    /** the replica discovered by the sentinels, read only after its offset checked */
+    struct replica_node : public replica_state
+    {
+        standalone_async_client_pool_ptr    pool;
+        std::atomic_bool                    readable;
+
+        replica_node(){
+            readable = false;
+        }
+    };
+    typedef std::shared_ptr<replica_node> replica_node_ptr;
+
+    /** the offsets of one check, the lag judged after all the replicas replied */
+    struct offset_check
+    {
+        std::mutex                      mtx;
+        int32_t                         remaining;
+        bool                            master_replied;
+        int64_t                         master_offset;
+        std::vector<std::pair<replica_node_ptr, int64_t>> offsets;
+
+        offset_check() : remaining(0), master_replied(false), master_offset(0){
+        }
+    };
+    typedef std::shared_ptr<offset_check> offset_check_ptr;
+
 protected:
     sentinel_client_pool_ptr    sentinel_client_pool_;
     std::string                 master_name_;
+    sentinel_failover_option    failover_option_;
+    std::mutex                  switch_mtx_;
+    bool                        switching_;
+    std::deque<buffered_request> buffered_requests_;
+    int64_t                     buffered_bytes_;
+    std::atomic<uint32_t>       switch_seq_;
+    utility::asio_base::timer::ptr switch_timer_;
+    asio::io_service&           io_service_;
+    sentinel_replica_option     replica_option_;
+    utility::asio_base::timer::ptr refresh_replicas_timer_;
+    std::mutex                  replica_mtx_;
+    std::map<std::string, replica_node_ptr> replica_node_map_;  // address -> the linked replica
+    replica_selector            replica_selector_;
+    completion_guard_ptr        replica_guard_;     // the sentinel and offset replies may come after destroyed
 
 public:
-    sentinel_async_client(const char* master_name, asio::io_service& io_service, const char* uri)
+    /**
+     * @param replica_option - read from the replicas discovered by the sentinels, disabled by default
+     */
+    sentinel_async_client(const char* master_name, asio::io_service& io_service, const char* uri,
+        const sentinel_replica_option& replica_option = sentinel_replica_option())
         : master_name_(master_name)
         , standalone_async_client(io_service, uri)
+        , switching_(false)
+        , buffered_bytes_(0)
+        , io_service_(io_service)
+        , replica_option_(replica_option)
+        , replica_selector_(replica_option)
     {
+        switch_seq_ = 0;
+        replica_guard_ = std::make_shared<completion_guard>();
+
+        switch_timer_ = utility::asio_base::timer::create(io_service);
+        switch_timer_->register_handler(std::bind(
+            &sentinel_async_client::switch_timer_handler,
+            this,
+            std::placeholders::_1,
+            std::placeholders::_2));
+
+        if (replica_option_.policy != replica_read_none){
+            refresh_replicas_timer_ = utility::asio_base::timer::create(io_service);
+            refresh_replicas_timer_->register_handler(std::bind(
+                &sentinel_async_client::refresh_replicas_timer_handler,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2));
+            refresh_replicas_timer_->start(replica_option_.refresh_interval);
+        }
     }
 
     ~sentinel_async_client()
     {
+        // wait for the replica callback running
+        {
+            std::lock_guard<std::recursive_mutex> locker(replica_guard_->mtx);
+            replica_guard_->alive = false;
+        }
+
         set_sentinel_client_pool(nullptr);
+        switch_timer_->cancel();
+
+        if (refresh_replicas_timer_){
+            refresh_replicas_timer_->cancel();
+        }
+
+        std::lock_guard<std::mutex> locker(replica_mtx_);
+        for (auto& iter : replica_node_map_){
+            iter.second->pool->shutdown();
+        }
+        replica_node_map_.clear();
     }
 
 public:
@@ -44,12 +152,18 @@ public:
     {
         if (sentinel_client_pool_){
             sentinel_client_pool_->remove_event_subscriber(event_master_address_change, this);
+            sentinel_client_pool_->remove_event_subscriber(event_replica_state_change, this);
         }
 
         sentinel_client_pool_ = sentinel;
 
         if (sentinel_client_pool_){
             sentinel_client_pool_->add_event_subscriber(event_master_address_change, this);
+
+            if (replica_option_.policy != replica_read_none){
+                sentinel_client_pool_->add_event_subscriber(event_replica_state_change, this);
+                refresh_replicas();
+            }
         }
     }
 
@@ -58,6 +172,85 @@ public:
         return sentinel_client_pool_;
     }
 
+    /**
+    * @brief set the failover option, should be set before any command
+    */
+    void    set_failover_option(const sentinel_failover_option& option)
+    {
+        failover_option_ = option;
+    }
+
+    /** is switching to the new master */
+    bool    is_switching()
+    {
+        std::lock_guard<std::mutex> locker(switch_mtx_);
+        return switching_;
+    }
+
+    /** the addresses of the replicas which the read commands done on */
+    std::vector<std::string> available_replicas()
+    {
+        std::vector<std::string> addresses;
+
+        std::lock_guard<std::mutex> locker(replica_mtx_);
+        for (auto& iter : replica_node_map_){
+            if (iter.second->readable && iter.second->pool->is_connected()){
+                addresses.push_back(iter.first);
+            }
+        }
+
+        return addresses;
+    }
+
+public:
+    /** implement of base_async_client */
+    /**
+    * @brief do command, the read commands on the replicas if enabled
+    */
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        reply_handler&& handler) override
+    {
+        if (replica_option_.policy != replica_read_none && handler && replica_option_.is_read_command(cmd)){
+            replica_node_ptr replica = choose_replica();
+            if (replica){
+                do_replica_command(replica, cmd, hash_slot, std::move(handler));
+                return;
+            }
+        }
+
+        do_master_command(cmd, hash_slot, std::move(handler));
+    }
+
+    using standalone_async_client::do_command;
+
+    /** implement of interface of tcp_channel_event */
+    /**
+    * connection to the new master opened, send the buffered commands
+    */
+    virtual void channel_open(const char* ip, int32_t port) override
+    {
+        standalone_async_client::channel_open(ip, port);
+
+        end_switch(false);
+    }
+
+    /*
+    * connection closed, reconnect to the new master soon while switching
+    */
+    virtual void channel_closed(const char* ip, int32_t port) override
+    {
+        if (!is_switching()){
+            standalone_async_client::channel_closed(ip, port);
+            return;
+        }
+
+        rds_log_info("sentinel_async_client[%p] master[%s] connection to [%s:%d] closed while switching.",
+            this, master_name_.c_str(), ip, port);
+
+        check_client_available_timer_->cancel();
+        reconnect_timer_->start(failover_reconnect_interval);
+    }
+
 public:
     /** implements of event_subscriber */
     virtual void on_event(event_num e, void* content) override
@@ -71,8 +264,45 @@ public:
             if (event->master_name != master_name_)
                 return;
 
+            redis_uri old_uri(uri_string().c_str());
+            if (old_uri.get_ip() != event->new_ip || old_uri.get_port() != event->new_port){
+                begin_switch();
+            }
             reset_uri_string(event->new_ip, event->new_port);
 
+            // closed already( like the old master down), not wait the reconnect interval
+            if (is_switching() && !is_connected()){
+                reconnect_timer_->start(failover_reconnect_interval);
+            }
+
+            // the old master may be the replica now
+            if (replica_option_.policy != replica_read_none){
+                refresh_replicas();
+            }
+
+            break;
+        }
+        case redis_cpp::detail::event_replica_state_change:
+        {
+            replica_state_change_event_t* event = (replica_state_change_event_t*)content;
+
+            if (event->master_name != master_name_)
+                return;
+
+            // stop reading the replica at once, do not wait the refresh
+            if (event->event_name == "+sdown"){
+                std::stringstream ss;
+                ss << event->ip << ":" << event->port;
+
+                std::lock_guard<std::mutex> locker(replica_mtx_);
+                auto iter = replica_node_map_.find(ss.str());
+                if (iter != replica_node_map_.end()){
+                    iter->second->readable = false;
+                }
+            }
+
+            refresh_replicas();
+
             break;
         }
         default:
@@ -86,6 +316,421 @@ public:
         }
     }
 
+protected:
+    /**
+    * @brief do command on the master, buffered while switching to the new master,
+    * the replay commands failed by the switch are done again once
+    */
+    void    do_master_command(const redis_command& cmd, int32_t hash_slot,
+        reply_handler&& handler)
+    {
+        if (buffer_request(cmd, hash_slot, handler)){
+            return;
+        }
+
+        if (failover_option_.buffer_time > 0 && handler &&
+            failover_option_.is_replay_command(cmd)){
+            uint32_t seq = switch_seq_;
+            std::shared_ptr<reply_handler> handler_ptr = std::make_shared<reply_handler>(std::move(handler));
+            standalone_async_client::do_command(cmd, hash_slot,
+                [this, cmd, hash_slot, seq, handler_ptr](redis_reply_ptr reply){
+                if (sentinel_failover_option::is_switch_failure(reply) &&
+                    (seq != switch_seq_ || is_switching())){
+                    rds_log_warn("sentinel_async_client[%p] master[%s] command[%s] failed by the master switch, replay it.",
+                        this, master_name_.c_str(), cmd.params()[0].c_str());
+
+                    reply_handler h(std::move(*handler_ptr));
+                    if (!buffer_request(cmd, hash_slot, h)){
+                        standalone_async_client::do_command(cmd, hash_slot, std::move(h));
+                    }
+                    return;
+                }
+
+                (*handler_ptr)(reply);
+            });
+            return;
+        }
+
+        standalone_async_client::do_command(cmd, hash_slot, std::move(handler));
+    }
+
+    /** the new commands buffered from now */
+    void    begin_switch()
+    {
+        if (failover_option_.buffer_time <= 0){
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> locker(switch_mtx_);
+            switching_ = true;
+            ++switch_seq_;
+        }
+
+        switch_timer_->start(failover_option_.buffer_time);
+    }
+
+    /**
+    * @brief send the buffered commands, or fail them if time out
+    */
+    void    end_switch(bool time_out)
+    {
+        std::deque<buffered_request> requests;
+        {
+            std::lock_guard<std::mutex> locker(switch_mtx_);
+            if (!switching_){
+                return;
+            }
+
+            switching_ = false;
+            requests.swap(buffered_requests_);
+            buffered_bytes_ = 0;
+        }
+
+        if (!time_out){
+            switch_timer_->cancel();
+        }
+
+        rds_log_info("sentinel_async_client[%p] master[%s] switch finished, time_out[%d] buffered[%d].",
+            this, master_name_.c_str(), time_out, (int32_t)requests.size());
+
+        for (auto& request : requests){
+            if (time_out){
+                request.handler(nullptr);
+            }
+            else{
+                standalone_async_client::do_command(request.cmd, request.hash_slot, std::move(request.handler));
+            }
+        }
+    }
+
+    /**
+    * @brief buffer the command while switching
+    * @return false if not switching, the handler is called with nullptr if the buffer full
+    */
+    bool    buffer_request(const redis_command& cmd, int32_t hash_slot, reply_handler& handler)
+    {
+        std::unique_lock<std::mutex> locker(switch_mtx_);
+        if (!switching_){
+            return false;
+        }
+
+        int64_t bytes = sentinel_failover_option::command_bytes(cmd);
+        if (buffered_bytes_ + bytes > failover_option_.buffer_bytes){
+            locker.unlock();
+
+            rds_log_error("sentinel_async_client[%p] master[%s] switching, buffer full, command failed.",
+                this, master_name_.c_str());
+            if (handler){
+                handler(nullptr);
+            }
+            return true;
+        }
+
+        buffered_request request;
+        request.cmd = cmd;
+        request.hash_slot = hash_slot;
+        request.handler = std::move(handler);
+        buffered_requests_.push_back(std::move(request));
+        buffered_bytes_ += bytes;
+        return true;
+    }
+
+    void    switch_timer_handler(utility::asio_base::timer::ptr timer_ptr,
+        const asio::error_code& error)
+    {
+        if (!error){
+            rds_log_error("sentinel_async_client[%p] master[%s] wait for the new master time out.",
+                this, master_name_.c_str());
+            end_switch(true);
+        }
+    }
+
+    void    refresh_replicas_timer_handler(utility::asio_base::timer::ptr timer_ptr,
+        const asio::error_code& error)
+    {
+        if (!error){
+            refresh_replicas();
+
+            timer_ptr->start(replica_option_.refresh_interval);
+        }
+        else{
+            rds_log_error("sentinel_async_client[%p] refresh_replicas_timer error, %s:%d.",
+                this, error.message().c_str(), error.value());
+        }
+    }
+
+    /**
+    * @brief query the replicas from the sentinels, the reply handled in the
+    * thread of the sentinel client
+    */
+    void    refresh_replicas()
+    {
+        sentinel_client_pool_ptr sentinel = sentinel_client_pool_;
+        if (!sentinel){
+            return;
+        }
+
+        completion_guard_ptr guard = replica_guard_;
+        sentinel->async_get_replicas_by_name(master_name_.c_str(),
+            [this, guard](bool success, const std::vector<sentinel_replica_info>& replicas){
+            std::lock_guard<std::recursive_mutex> locker(guard->mtx);
+            if (!guard->alive){
+                return;
+            }
+
+            if (!success){
+                rds_log_error("sentinel_async_client[%p] master[%s] get replicas failed.",
+                    this, master_name_.c_str());
+                return;
+            }
+
+            reset_replicas(replicas);
+        });
+    }
+
+    /**
+    * @brief keep the pools of the linked replicas, the lag of the connected ones
+    * checked now, the new ones checked when connected
+    */
+    void    reset_replicas(const std::vector<sentinel_replica_info>& replicas)
+    {
+        std::vector<replica_node_ptr> linked_nodes;
+        std::vector<replica_node_ptr> added_nodes;
+        std::vector<replica_node_ptr> removed_nodes;
+        {
+            std::lock_guard<std::mutex> locker(replica_mtx_);
+
+            std::map<std::string, replica_node_ptr> node_map;
+            for (auto& replica : replicas){
+                std::stringstream ss;
+                ss << replica.ip << ":" << replica.port;
+                std::string address(std::move(ss.str()));
+
+                if (!replica_option_.is_linked(replica)){
+                    rds_log_warn("sentinel_async_client[%p] master[%s] replica[%s] excluded, flags[%s] link_down_time[%lld].",
+                        this, master_name_.c_str(), address.c_str(), replica.flags.c_str(),
+                        (long long)replica.master_link_down_time);
+                    continue;
+                }
+
+                auto iter = replica_node_map_.find(address);
+                if (iter != replica_node_map_.end()){
+                    node_map[address] = iter->second;
+                    linked_nodes.push_back(iter->second);
+                    continue;
+                }
+
+                replica_node_ptr node = create_replica_node(replica, address);
+                node_map[address] = node;
+                added_nodes.push_back(node);
+            }
+
+            for (auto& iter : replica_node_map_){
+                if (node_map.find(iter.first) == node_map.end()){
+                    removed_nodes.push_back(iter.second);
+                }
+            }
+
+            replica_node_map_.swap(node_map);
+        }
+
+        // the commands on the removed ones completed with nullptr and done by the master,
+        // the node kept until then
+        for (auto& node : removed_nodes){
+            rds_log_info("sentinel_async_client[%p] master[%s] remove replica pool of address[%s].",
+                this, master_name_.c_str(), node->address.c_str());
+            node->readable = false;
+            node->pool->close([node](){});
+        }
+
+        for (auto& node : added_nodes){
+            node->pool->try_connect();
+        }
+
+        check_replica_offsets(linked_nodes);
+    }
+
+    replica_node_ptr create_replica_node(const sentinel_replica_info& replica, const std::string& address)
+    {
+        // the same password and db as the master
+        redis_uri uri(uri_string().c_str());
+        uri.set_ip(replica.ip.c_str());
+        uri.set_port(replica.port);
+
+        replica_node_ptr node = std::make_shared<replica_node>();
+        node->address = address;
+        node->pool = std::make_shared<standalone_async_client_pool>(io_service_, uri.to_string().c_str());
+
+        auto zone = replica_option_.node_zones.find(address);
+        if (zone != replica_option_.node_zones.end()){
+            node->zone = zone->second;
+        }
+
+        // checked again whenever reconnected
+        completion_guard_ptr guard = replica_guard_;
+        std::weak_ptr<replica_node> node_weak = node;
+        node->pool->set_open_handler([this, guard, node_weak](){
+            std::lock_guard<std::recursive_mutex> locker(guard->mtx);
+            replica_node_ptr node = node_weak.lock();
+            if (!guard->alive || !node){
+                return;
+            }
+
+            check_replica_offsets(std::vector<replica_node_ptr>(1, node));
+        });
+
+        rds_log_info("sentinel_async_client[%p] master[%s] add replica pool of address[%s] zone[%s].",
+            this, master_name_.c_str(), address.c_str(), node->zone.c_str());
+
+        return node;
+    }
+
+    /**
+    * @brief read the offset of the master by "info replication", then the offsets
+    * of the connected replicas, so the lag is never larger than the real one
+    */
+    void    check_replica_offsets(const std::vector<replica_node_ptr>& nodes)
+    {
+        std::vector<replica_node_ptr> connected_nodes;
+        for (auto& node : nodes){
+            if (node->pool->is_connected()){
+                connected_nodes.push_back(node);
+            }
+        }
+
+        if (connected_nodes.empty()){
+            return;
+        }
+
+        offset_check_ptr check = std::make_shared<offset_check>();
+        check->remaining = (int32_t)connected_nodes.size();
+
+        redis_command cmd("info");
+        cmd.add_param("replication");
+
+        completion_guard_ptr guard = replica_guard_;
+        standalone_async_client::do_command(cmd, -1,
+            [this, guard, check, connected_nodes, cmd](redis_reply_ptr reply){
+            std::lock_guard<std::recursive_mutex> locker(guard->mtx);
+            if (!guard->alive){
+                return;
+            }
+
+            check->master_replied = reply && reply->is_string() &&
+                sentinel_replica_option::parse_repl_offset(reply->to_string(), "master_repl_offset", check->master_offset);
+
+            for (auto& node : connected_nodes){
+                replica_node_ptr replica = node;
+                replica->pool->do_command(cmd, -1, [this, guard, check, replica](redis_reply_ptr reply){
+                    std::lock_guard<std::recursive_mutex> locker(guard->mtx);
+                    if (!guard->alive){
+                        return;
+                    }
+
+                    int64_t offset = 0;
+                    bool replied = reply && reply->is_string() &&
+                        sentinel_replica_option::parse_repl_offset(reply->to_string(), "slave_repl_offset", offset);
+                    {
+                        std::lock_guard<std::mutex> check_locker(check->mtx);
+                        if (replied){
+                            check->offsets.push_back(std::make_pair(replica, offset));
+                        }
+                        else{
+                            rds_log_warn("sentinel_async_client[%p] master[%s] replica[%s] excluded, read the offset failed.",
+                                this, master_name_.c_str(), replica->address.c_str());
+                            replica->readable = false;
+                        }
+
+                        if (--check->remaining > 0){
+                            return;
+                        }
+                    }
+
+                    judge_replica_lags(check);
+                });
+            }
+        });
+    }
+
+    /** the max offset of the replicas if the master not replied */
+    void    judge_replica_lags(const offset_check_ptr& check)
+    {
+        int64_t master_offset = check->master_offset;
+        if (!check->master_replied){
+            for (auto& item : check->offsets){
+                master_offset = std::max(master_offset, item.second);
+            }
+        }
+
+        for (auto& item : check->offsets){
+            replica_node_ptr& node = item.first;
+            bool readable = replica_option_.is_lag_acceptable(master_offset, item.second);
+            if (node->readable.exchange(readable) != readable){
+                rds_log_info("sentinel_async_client[%p] master[%s] replica[%s] readable[%d] lag[%lld].",
+                    this, master_name_.c_str(), node->address.c_str(), readable,
+                    (long long)(master_offset - item.second));
+            }
+        }
+    }
+
+    /** choose from the readable and connected replicas by the policy */
+    replica_node_ptr choose_replica()
+    {
+        std::vector<replica_node_ptr> nodes;
+        {
+            std::lock_guard<std::mutex> locker(replica_mtx_);
+            for (auto& iter : replica_node_map_){
+                replica_node_ptr& node = iter.second;
+                if (node->readable && node->pool->is_connected()){
+                    nodes.push_back(node);
+                }
+            }
+        }
+
+        return replica_selector_.choose(nodes);
+    }
+
+    /**
+    * @brief do the command on the replica, done by the master if failed or
+    * replied error, the handler holds the replica weakly since kept by the pool
+    */
+    void    do_replica_command(const replica_node_ptr& node, const redis_command& cmd,
+        int32_t hash_slot, reply_handler&& handler)
+    {
+        std::shared_ptr<reply_handler> handler_ptr = std::make_shared<reply_handler>(std::move(handler));
+        auto start = std::chrono::steady_clock::now();
+        completion_guard_ptr guard = replica_guard_;
+        std::weak_ptr<replica_node> node_weak = node;
+        node->pool->do_command(cmd, hash_slot,
+            [this, guard, node_weak, cmd, hash_slot, handler_ptr, start](redis_reply_ptr reply){
+            std::lock_guard<std::recursive_mutex> locker(guard->mtx);
+            if (!guard->alive){
+                return;
+            }
+
+            // removed while the command in flight
+            replica_node_ptr replica = node_weak.lock();
+
+            // like loading, the master would reply the command error too
+            if (!reply || reply->is_error()){
+                if (!reply && replica){
+                    replica->on_failed();
+                    rds_log_warn("sentinel_async_client[%p] replica[%s] command failed, fall back to the master.",
+                        this, replica->address.c_str());
+                }
+
+                do_master_command(cmd, hash_slot, std::move(*handler_ptr));
+                return;
+            }
+
+            if (replica){
+                replica->on_replied(start);
+            }
+
+            (*handler_ptr)(reply);
+        });
+    }
 };
 }
 }
@@ -17,10 +17,17 @@
 #include <redis_cpp/detail/redis_parser.hpp>
 #include <redis_cpp/detail/redis_buffer.hpp>
 #include <redis_cpp/detail/redis_command.hpp>
+#include <redis_cpp/detail/circuit_breaker.hpp>
 #include <redis_cpp/internal/logger_handler.hpp>
 #include <redis_cpp/redis_uri.hpp>
 #include <utility/asio_base/timer.hpp>
+#include <utility/sync/mpsc_ring.hpp>
+#include <utility/ring_queue.hpp>
+#include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
 #include <queue>
 
 namespace redis_cpp
@@ -28,16 +35,105 @@ namespace redis_cpp
 namespace detail
 {
 
-/** reconnect interval in millisecond */
+/** the max reconnect interval in millisecond */
 static const int32_t reconnect_interval = 5000;
 
+/** the first reconnect interval in millisecond, doubled after each failure
+ up to reconnect_interval, with jitter */
+static const int32_t reconnect_min_interval = 100;
+
 /** check client available interval */
 static const int32_t check_client_available_interval = 5000;
 
+/** max bytes of the requests sent in one buffer */
+static const int32_t max_request_batch_size = 0x100000;
+
+/** max count of the requests submitted but not sent yet */
+static const int32_t max_request_ring_size = 0x1000;
+
+/** how to deal with the producer when the high watermark reached */
+enum async_backpressure_policy{
+    async_backpressure_block = 0,       // block until the low watermark reached( or timeout)
+    async_backpressure_reject,          // the command failed immediately
+};
+
+/** paused is true when the high watermark reached, false when the low watermark reached */
+typedef std::function<void(bool paused)> backpressure_handler;
+
+/** called in the io thread when the connection opened( or reopened) */
+typedef std::function<void()> connection_open_handler;
+
+/**
+ * the watermarks of the requests waiting for reply( count) and the requests
+ * not written to the socket yet( bytes), 0 means no limit.
+ * the command failed by the backpressure is completed with nullptr reply
+ */
+struct async_backpressure_option
+{
+    int32_t                     high_watermark_count;
+    int32_t                     low_watermark_count;
+    int64_t                     high_watermark_bytes;
+    int64_t                     low_watermark_bytes;
+    async_backpressure_policy   policy;
+    int32_t                     block_timeout;      // in milliseconds
+    backpressure_handler        handler;            // called in the producer thread or io thread
+
+    async_backpressure_option()
+        : high_watermark_count(0)
+        , low_watermark_count(0)
+        , high_watermark_bytes(0)
+        , low_watermark_bytes(0)
+        , policy(async_backpressure_block)
+        , block_timeout(1000){
+    }
+};
+
+/**
+ * the requests are submitted to a lock free ring by the caller threads, and
+ * drained in batch by the connection strand, the reply handlers are queued in
+ * the same order with the commands sent( the handler queue and the send queue
+ * are only accessed in the connection strand).
+ * the ring slots, the handler queue and the send buffers are all reused, and the
+ * handlers are moved instead of copied, so no memory allocated in steady state
+ * except the handler which exceeds the small buffer of std::function
+ */
 class standalone_async_client :
     public base_async_client,
     public tcp_channel_event
 {
+protected:
+    /** the submitted request, not sent yet */
+    struct async_request
+    {
+        std::string         data;       // the encoded command, the capacity is reused
+        reply_handler       handler;
+        bool                asking;     // the 'asking' command is sent before it
+    };
+    typedef utility::sync::mpsc_ring<async_request> request_ring_type;
+
+    /** the reply( or channel message) and its handler */
+    struct async_completion
+    {
+        reply_handler               handler;
+        channel_message_handler_ptr message_handler;
+        redis_reply_ptr             reply;
+        std::string                 channel;    // the message not the string of the reply
+        std::string                 message;
+    };
+    typedef std::vector<async_completion> completion_batch_type;
+    typedef std::shared_ptr<completion_batch_type> completion_batch_ptr;
+
+    /** shared with the batches posted to the executor, which may run after the client destroyed */
+    struct completion_guard
+    {
+        std::recursive_mutex    mtx;        // the handler may destroy the client
+        bool                    alive;
+
+        completion_guard() : alive(true){
+        }
+    };
+    typedef std::shared_ptr<completion_guard> completion_guard_ptr;
+
 protected:
     channel_message_handler_map_type subscribe_msg_handlers_;
     tcp_async_channel_ptr            connection_;
@@ -47,17 +143,52 @@ protected:
     bool                             cluster_enabled_;
     std::mutex                       mtx_;
     std::mutex                       uri_mtx_;
-    std::queue<reply_handler_ptr>    handler_queue_;
+    utility::ring_queue<reply_handler> handler_queue_;
+    std::atomic<int32_t>             pending_count_;
+    request_ring_type                request_ring_;
+    std::atomic_bool                 drain_scheduled_;
+    std::atomic<int64_t>             unsent_bytes_;          // submitted but not drained
+    async_backpressure_option        backpressure_option_;
+    std::atomic_bool                 backpressure_paused_;
+    std::mutex                       backpressure_mtx_;
+    std::condition_variable          backpressure_cv_;
+    std::atomic<uint64_t>            ring_drained_times_;    // the producers wait for it while the ring full
+    std::atomic<int32_t>             ring_waiters_;
+    std::mutex                       ring_mtx_;
+    std::condition_variable          ring_cv_;
+    std::atomic<asio::io_service::strand*> completion_strand_;
+    completion_guard_ptr             completion_guard_;
+    completion_batch_type            completion_batch_;      // collected in one read
+    connection_open_handler          open_handler_;
     utility::asio_base::timer::ptr   reconnect_timer_;
+    std::atomic<int32_t>             reconnect_times_;       // reconnected in a row without open
+    std::atomic<int32_t>             subscribed_count_;      // by the server, the pushes only while subscribed
     utility::asio_base::timer::ptr   check_client_available_timer_;
 public:
-    standalone_async_client(asio::io_service& io_service, const char* uri)
+    /**
+    * @param exclusive_loop - the io_service is run by only one thread( like the
+    * io_service of utility::asio_base::io_service_pool), then no strand and lock
+    * needed by the connection
+    */
+    standalone_async_client(asio::io_service& io_service, const char* uri,
+        bool exclusive_loop = false)
         : redis_uri_(uri)
-        , cluster_enabled_(false){
+        , cluster_enabled_(false)
+        , request_ring_(max_request_ring_size){
+        pending_count_ = 0;
+        reconnect_times_ = 0;
+        subscribed_count_ = 0;
+        drain_scheduled_ = false;
+        unsent_bytes_ = 0;
+        backpressure_paused_ = false;
+        ring_drained_times_ = 0;
+        ring_waiters_ = 0;
+        completion_strand_ = nullptr;
+        completion_guard_ = std::make_shared<completion_guard>();
         endpoint_ = new asio::ip::tcp::endpoint(
             asio::ip::address::from_string(redis_uri_.get_ip()),
             redis_uri_.get_port());
-        connection_ = tcp_async_channel::create(io_service);
+        connection_ = tcp_async_channel::create(io_service, exclusive_loop);
         connection_->set_event_handler(this);
 
         reconnect_timer_ = utility::asio_base::timer::create(io_service);
@@ -77,6 +208,12 @@ public:
     }
 
     virtual ~standalone_async_client(){
+        // wait for the batch running, the batches queued are dropped like the requests not replied
+        {
+            std::lock_guard<std::recursive_mutex> locker(completion_guard_->mtx);
+            completion_guard_->alive = false;
+        }
+
         shutdown();
 
         if (check_client_available_timer_){
@@ -87,16 +224,99 @@ public:
             delete endpoint_;
             endpoint_ = nullptr;
         }
+
+        delete completion_strand_.load();
     }
 
     void    shutdown(){
         connection_->shutdown();
     }
 
+    /**
+    * @brief shutdown, and complete the requests not replied with nullptr( the
+    * shutdown connection never reports channel_closed)
+    * @param closed_handler - called after the completions, the client should be
+    * alive until then
+    */
+    void    close(const std::function<void()>& closed_handler = nullptr){
+        connection_->shutdown();
+        connection_->clear_send_queue_in_strand();
+        connection_->post([this, closed_handler](){
+            clear_handler_queue();
+
+            // the requests not drained given up since not connected
+            drain_request_queue();
+
+            if (!closed_handler){
+                return;
+            }
+
+            if (completion_strand_){
+                completion_strand_.load()->post(closed_handler);
+            }
+            else{
+                closed_handler();
+            }
+        });
+    }
+
     bool    is_connected(){
         return connection_->is_connected();
     }
 
+    /** the count of the requests which waiting for reply */
+    int32_t pending_count(){
+        return pending_count_;
+    }
+
+    /** the bytes of the requests not written to the socket yet */
+    int64_t unsent_bytes(){
+        return unsent_bytes_ + connection_->pending_write_bytes();
+    }
+
+    /**
+    * @brief set the backpressure option, should be set before any command
+    */
+    void    set_backpressure_option(const async_backpressure_option& option){
+        backpressure_option_ = option;
+    }
+
+    /** is the high watermark reached */
+    bool    is_backpressure_paused(){
+        return backpressure_paused_;
+    }
+
+    /**
+    * @brief the handler is called after auth and select when the connection opened,
+    * before the subscribed channels recovered, so the commands could be done
+    * before the connection in subscribe mode( like "client id").
+    * should be set before connect
+    */
+    void    set_open_handler(const connection_open_handler& handler){
+        open_handler_ = handler;
+    }
+
+    /**
+    * @brief run the reply handlers and channel message handlers in the executor
+    * instead of the io thread, the handlers of this connection are still called
+    * in order( by a strand of the executor), the completions parsed from one read
+    * are dispatched together. could only be set once
+    * @param executor - the io service run by other threads
+    */
+    void    set_completion_executor(asio::io_service* executor){
+        if (!executor){
+            return;
+        }
+
+        asio::io_service::strand* strand = new asio::io_service::strand(*executor);
+        asio::io_service::strand* expected = nullptr;
+        if (!completion_strand_.compare_exchange_strong(expected, strand)){
+            rds_log_error("async_client[%p] uri[%s] completion executor already set.",
+                this, uri_string().c_str());
+            delete strand;
+        }
+    }
+
     void try_connect(bool use_promise = false){
         if (endpoint_){
             connection_->connect(*endpoint_, use_promise);
@@ -142,16 +362,40 @@ public:
         }
     }
 
-    /** do command */
-    void    do_command(const redis_command& cmd, const reply_handler& handler){
-        std::string str(cmd.to_string());
-        redis_buffer_ptr buffer = redis_buffer::create((int32_t)str.size(), true);
-        buffer->write_bytes(str.data(), (int32_t)str.length());
+    /**
+    * @brief do command, the command is sent by the connection strand later,
+    * the handler would be called with nullptr if the send failed then
+    * @return false if the connection not connected
+    */
+    bool    do_command(const redis_command& cmd, const reply_handler& handler){
+        reply_handler h(handler);
+        return do_command(cmd, std::move(h));
+    }
+
+    /**
+    * @brief do command, the handler is moved into the request only if success
+    * @return false if the connection not connected or the request ring full
+    */
+    bool    do_command(const redis_command& cmd, reply_handler&& handler){
+        if (!connection_->is_connected()){
+            return false;
+        }
 
-        std::lock_guard<std::mutex> locker(mtx_);
-        if (connection_->send(buffer)){
-            handler_queue_.push(reply_handler_ptr(new reply_handler(handler)));
+        return submit_request(cmd, handler, false);
+    }
+
+    /**
+    * @brief do command after 'asking'( for the ask redirect of cluster),
+    * the two commands are sent in one buffer so no other command between them
+    * @return false if the connection not connected
+    */
+    bool    do_asking_command(const redis_command& cmd, const reply_handler& handler){
+        if (!connection_->is_connected()){
+            return false;
         }
+
+        reply_handler h(handler);
+        return submit_request(cmd, h, true);
     }
 
 public:
@@ -181,11 +425,15 @@ public:
             redis_command cmd("subscribe");
             cmd.add_param(channel_name);
 
-            do_command(cmd, reply_handler);
+            do_command(cmd, -1, reply_handler);
         }
         else{
             rds_log_error("async_client[%p] uri[%s] not connected yet, subscribe channel[%s] failed.",
                 this, uri_string().c_str(), channel_name.c_str());
+
+            if (reply_handler){
+                reply_handler(nullptr);
+            }
         }
     }
 
@@ -205,11 +453,15 @@ public:
             redis_command cmd("unsubscribe");
             cmd.add_param(channel_name);
 
-            do_command(cmd, reply_handler);
+            do_command(cmd, -1, reply_handler);
         }
         else{
             rds_log_error("async_client[%p] uri[%s] not connected yet, unsubscribe channel[%s] failed.",
                 this, uri_string().c_str(), channel_name.c_str());
+
+            if (reply_handler){
+                reply_handler(nullptr);
+            }
         }
     }
 
@@ -224,14 +476,54 @@ public:
             cmd.add_param(channel_name);
             cmd.add_param(message);
 
-            do_command(cmd, reply_handler);
+            do_command(cmd, -1, reply_handler);
         }
         else{
             rds_log_error("async_client[%p] uri[%s] not connected yet, publish msg to channel[%s] failed.",
                 this, uri_string().c_str(), channel_name.c_str());
+
+            if (reply_handler){
+                reply_handler(nullptr);
+            }
+        }
+    }
+
+    /**
+    * @brief do command, the hash slot is ignored in standalone mode
+    */
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        const reply_handler& handler) override{
+        reply_handler h(handler);
+        do_command(cmd, hash_slot, std::move(h));
+    }
+
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        reply_handler&& handler) override{
+        if (!connection_->is_connected()){
+            rds_log_error("async_client[%p] uri[%s] not connected yet, do command failed.",
+                this, uri_string().c_str());
+
+            if (handler){
+                handler(nullptr);
+            }
+            return;
+        }
+
+        if (!do_command(cmd, std::move(handler))){
+            rds_log_error("async_client[%p] uri[%s] send command failed.",
+                this, uri_string().c_str());
+
+            if (handler){
+                handler(nullptr);
+            }
         }
     }
 
+    /** is cluster mode */
+    virtual bool cluster_mode() override{
+        return false;
+    }
+
 public:
     /** implement of interface of tcp_channel_event */
     /**
@@ -241,6 +533,9 @@ public:
         rds_log_info("[%p] async_client to server[%s:%d] channel opend.",
             this, ip, port);
 
+        reconnect_times_ = 0;
+        subscribed_count_ = 0;
+
         // clear old handler queue
         clear_handler_queue();
 
@@ -257,6 +552,10 @@ public:
         // check role
         check_role();
 
+        if (open_handler_){
+            open_handler_();
+        }
+
         // try recover subscribe channels
         recover_subscribe_channels();
 
@@ -274,8 +573,8 @@ public:
         // cancel the check client available timer
         check_client_available_timer_->cancel();
 
-        // start reconnect timer
-        reconnect_timer_->start(reconnect_interval);
+        // start reconnect timer, backoff while the server down
+        reconnect_timer_->start(next_reconnect_delay());
     }
 
     /**
@@ -301,7 +600,7 @@ public:
             }
             else if (result == redis_incomplete){
                 // wait for remain content
-                return;
+                break;
             }
             else if (result == redis_error){
                 // parse error
@@ -311,13 +610,30 @@ public:
                 parser_.reset();
                 connection_->close();
 
-                return;
+                break;
             }
         }
 
+        flush_completions();
+    }
+
+    /**
+    * msg written to the connection
+    */
+    virtual void message_sent(const char* ip, int32_t port, int32_t size) override{
+        if (!request_ring_.empty()){
+            schedule_drain();
+        }
+
+        check_low_watermark();
     }
 
 protected:
+    /** the exponential backoff with jitter, not all the clients reconnect at the same time */
+    int32_t next_reconnect_delay(){
+        return backoff_delay(reconnect_min_interval, reconnect_interval, reconnect_times_++);
+    }
+
     /**
     * @brief connection reconnect timer handler
     */
@@ -356,12 +672,244 @@ protected:
         }
     }
 
-    /** clear old request handler queue */
+    /**
+    * @brief clear old request handler queue, only in the connection strand,
+    * the handlers are called with nullptr since the replies would never come
+    */
     void    clear_handler_queue(){
-
-        std::lock_guard<std::mutex> locker(mtx_);
         while (!handler_queue_.empty()){
+            reply_handler handler(std::move(handler_queue_.front()));
             handler_queue_.pop();
+            --pending_count_;
+
+            complete(handler, nullptr);
+        }
+
+        flush_completions();
+        check_low_watermark();
+    }
+
+    /**
+    * @brief submit request to the request ring, could be called by any thread
+    * @param handler - moved into the ring slot if success
+    * @return false if the ring is full in the connection strand( wait for the
+    * drain in other threads)
+    */
+    bool    submit_request(const redis_command& cmd, reply_handler& handler, bool asking){
+        if (backpressure_paused_ && !wait_for_writable()){
+            rds_log_error("async_client[%p] uri[%s] high watermark reached, pending[%d] unsent bytes[%lld], give up the request.",
+                this, uri_string().c_str(), pending_count(), (long long)unsent_bytes());
+            return false;
+        }
+
+        int64_t bytes = 0;
+        auto fill = [&](async_request& request){
+            request.data.clear();
+            cmd.encode(request.data);
+            request.asking = asking;
+            bytes = request_bytes(request);
+            if (handler){
+                request.handler = std::move(handler);
+            }
+            else{
+                request.handler = [this](redis_reply_ptr reply){
+                    default_reply_handler(reply);
+                };
+            }
+        };
+
+        pending_count_ += asking ? 2 : 1;
+        // the ring full, wait for the drain by the backpressure policy
+        auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(backpressure_option_.block_timeout);
+        for (;;){
+            uint64_t drained_times = ring_drained_times_;
+            if (request_ring_.try_push(fill)){
+                break;
+            }
+
+            // the drain runs in the strand, could not wait for it here
+            if (connection_->running_in_strand() || !connection_->is_connected() ||
+                backpressure_option_.policy == async_backpressure_reject ||
+                std::chrono::steady_clock::now() > deadline){
+                pending_count_ -= asking ? 2 : 1;
+                rds_log_error("async_client[%p] uri[%s] request ring full, give up the request.",
+                    this, uri_string().c_str());
+                return false;
+            }
+
+            schedule_drain();
+            wait_for_ring_drained(drained_times, deadline);
+        }
+
+        unsent_bytes_ += bytes;
+        schedule_drain();
+        check_high_watermark();
+        return true;
+    }
+
+    /** wait until the ring drained after the drained_times read, or the deadline */
+    void    wait_for_ring_drained(uint64_t drained_times,
+        std::chrono::steady_clock::time_point deadline){
+        std::unique_lock<std::mutex> locker(ring_mtx_);
+        ++ring_waiters_;
+        ring_cv_.wait_until(locker, deadline,
+            [this, drained_times](){ return ring_drained_times_ != drained_times; });
+        --ring_waiters_;
+    }
+
+    /** wake up the producers waiting for the ring full, after the requests popped */
+    void    notify_ring_drained(){
+        ++ring_drained_times_;
+        if (ring_waiters_ > 0){
+            {
+                std::lock_guard<std::mutex> locker(ring_mtx_);
+            }
+            ring_cv_.notify_all();
+        }
+    }
+
+    /** the bytes of the request sent to the socket */
+    static int64_t request_bytes(const async_request& request){
+        return (int64_t)request.data.size() +
+            (request.asking ? (int64_t)asking_command().size() : 0);
+    }
+
+    static const std::string& asking_command(){
+        static const std::string asking_cmd = redis_command("asking").to_string();
+        return asking_cmd;
+    }
+
+    /**
+    * @brief wait until the low watermark reached, could not wait in the
+    * connection strand
+    * @return false if the request should be rejected
+    */
+    bool    wait_for_writable(){
+        if (backpressure_option_.policy == async_backpressure_reject ||
+            connection_->running_in_strand()){
+            return false;
+        }
+
+        std::unique_lock<std::mutex> locker(backpressure_mtx_);
+        return backpressure_cv_.wait_for(locker,
+            std::chrono::milliseconds(backpressure_option_.block_timeout),
+            [this](){ return !backpressure_paused_; });
+    }
+
+    void    check_high_watermark(){
+        const async_backpressure_option& option = backpressure_option_;
+        if (backpressure_paused_ ||
+            (option.high_watermark_count <= 0 && option.high_watermark_bytes <= 0)){
+            return;
+        }
+
+        if ((option.high_watermark_count > 0 && pending_count() >= option.high_watermark_count) ||
+            (option.high_watermark_bytes > 0 && unsent_bytes() >= option.high_watermark_bytes)){
+            if (!backpressure_paused_.exchange(true)){
+                rds_log_warn("async_client[%p] uri[%s] high watermark reached, pending[%d] unsent bytes[%lld].",
+                    this, uri_string().c_str(), pending_count(), (long long)unsent_bytes());
+
+                if (option.handler){
+                    option.handler(true);
+                }
+
+                // the replies may all come back before the flag set
+                check_low_watermark();
+            }
+        }
+    }
+
+    void    check_low_watermark(){
+        const async_backpressure_option& option = backpressure_option_;
+        if (!backpressure_paused_){
+            return;
+        }
+
+        if ((option.high_watermark_count <= 0 || pending_count() <= option.low_watermark_count) &&
+            (option.high_watermark_bytes <= 0 || unsent_bytes() <= option.low_watermark_bytes)){
+            if (backpressure_paused_.exchange(false)){
+                {
+                    std::lock_guard<std::mutex> locker(backpressure_mtx_);
+                }
+                backpressure_cv_.notify_all();
+
+                if (option.handler){
+                    option.handler(false);
+                }
+            }
+        }
+    }
+
+    /** only one drain is scheduled at the same time */
+    void    schedule_drain(){
+        if (!drain_scheduled_.exchange(true)){
+            connection_->post(std::bind(
+                &standalone_async_client::drain_request_queue,
+                this));
+        }
+    }
+
+    /**
+    * @brief send all the submitted requests in one buffer, only in the connection strand
+    */
+    void    drain_request_queue(){
+        // reset the flag before pop, so the request pushed after the last pop
+        // would schedule another drain
+        drain_scheduled_ = false;
+
+        if (request_ring_.empty()){
+            return;
+        }
+
+        // the send queue too long, drain again after the write completed
+        if (connection_->send_queue_full()){
+            return;
+        }
+
+        if (!connection_->is_connected()){
+            rds_log_error("async_client[%p] uri[%s] connection not connected, give up the requests.",
+                this, uri_string().c_str());
+
+            while (request_ring_.pop([this](async_request& request){
+                pending_count_ -= request.asking ? 2 : 1;
+                unsent_bytes_ -= request_bytes(request);
+                complete(request.handler, nullptr);
+            })){
+            }
+            notify_ring_drained();
+
+            flush_completions();
+
+            check_low_watermark();
+            return;
+        }
+
+        const std::string& asking_cmd = asking_command();
+        redis_buffer_ptr buffer = connection_->acquire_send_buffer();
+        auto consume = [&](async_request& request){
+            unsent_bytes_ -= request_bytes(request);
+            if (request.asking){
+                buffer->write_bytes(asking_cmd.data(), (int32_t)asking_cmd.length());
+                handler_queue_.push([this](redis_reply_ptr reply){
+                    default_reply_handler(reply);
+                });
+            }
+
+            buffer->write_bytes(request.data.data(), (int32_t)request.data.length());
+            handler_queue_.push(std::move(request.handler));
+        };
+
+        while (buffer->readable_bytes() < max_request_batch_size &&
+            request_ring_.pop(consume)){
+        }
+        notify_ring_drained();
+
+        connection_->send_in_strand(buffer);
+
+        // batch size limit reached, drain the remaining requests later
+        if (!request_ring_.empty()){
+            schedule_drain();
         }
     }
 
@@ -443,18 +991,43 @@ protected:
 
         std::string& cmd = arr[0].to_string();
         std::string& channel_name = arr[1].to_string();
+
+        // the reply of the normal command may look like a message( like the mget
+        // reply ["message", "foo", nil]), but only pushed in subscribe mode
+        if (cmd == "message" && subscribed_count_ <= 0){
+            return false;
+        }
+
         if (cmd == "message" && arr[2].is_string()){
             std::string& msg = arr[2].to_string();
-            process_channel_message(channel_name, msg);
+            process_channel_message(reply, channel_name, msg);
+            return true;
+        }
+        else if (cmd == "message" && (arr[2].is_array() || arr[2].is_nil())){
+            // like the invalidation of the client tracking, one message for each
+            // key, or an empty message if all the keys invalidated( nil)
+            if (arr[2].is_nil()){
+                process_channel_message(nullptr, channel_name, std::string());
+                return true;
+            }
+
+            redis_reply_arr& keys = arr[2].to_array();
+            for (auto& key : keys){
+                if (key.is_string()){
+                    process_channel_message(nullptr, channel_name, key.to_string());
+                }
+            }
             return true;
         }
         else if (cmd == "subscribe" && arr[2].is_integer()){
             int32_t channel_count = arr[2].to_integer_32();
+            subscribed_count_ = channel_count;
             rds_log_info("async_client[%p] cur channel:%d after subscribe[%s].",
                 this, channel_count, channel_name.c_str());
         }
         else if (cmd == "unsubscribe" && arr[2].is_integer()){
             int32_t channel_count = arr[2].to_integer_32();
+            subscribed_count_ = channel_count;
             rds_log_info("async_client[%p] cur channel:%d after usubscribe[%s].",
                 this, channel_count, channel_name.c_str());
         }
@@ -463,14 +1036,15 @@ protected:
     }
 
     /** pop reply handler */
-    reply_handler_ptr pop_reply_handler(){
-        std::lock_guard<std::mutex> locker(mtx_);
+    bool    pop_reply_handler(reply_handler& handler){
         if (!handler_queue_.empty()){
-            reply_handler_ptr ret = handler_queue_.front();
+            handler = std::move(handler_queue_.front());
             handler_queue_.pop();
-            return ret;
+            --pending_count_;
+            check_low_watermark();
+            return true;
         }
-        return reply_handler_ptr();
+        return false;
     }
 
     /** process message */
@@ -488,25 +1062,92 @@ protected:
             return;
         }
 
-        reply_handler_ptr reply_handle = pop_reply_handler();
-        if (!reply_handle){
+        reply_handler reply_handle;
+        if (!pop_reply_handler(reply_handle)){
             std::string message;
             rds_log_error("unexcepted message[%s].", message.c_str());
             return;
         }
 
-        (*reply_handle)(reply);
+        complete(reply_handle, reply);
     }
 
     /** process channel message */
-    void    process_channel_message(const std::string& channel_name,
-        const std::string& msg){
+    void    process_channel_message(redis_reply_ptr reply,
+        const std::string& channel_name, const std::string& msg){
         auto msg_handler = get_message_handler(channel_name);
-        if (msg_handler){
+        if (!msg_handler){
+            return;
+        }
+
+        if (completion_strand_){
+            async_completion completion;
+            completion.message_handler = msg_handler;
+            completion.reply = reply;
+            if (!reply){
+                completion.channel = channel_name;
+                completion.message = msg;
+            }
+            completion_batch_.push_back(std::move(completion));
+        }
+        else{
             (*msg_handler)(channel_name, msg);
         }
     }
 
+    /**
+    * @brief call the handler in the io thread, or collect it to the completion
+    * batch if the completion executor set( only in the connection strand)
+    */
+    void    complete(reply_handler& handler, redis_reply_ptr reply){
+        if (completion_strand_){
+            async_completion completion;
+            completion.handler = std::move(handler);
+            completion.reply = reply;
+            completion_batch_.push_back(std::move(completion));
+        }
+        else{
+            handler(reply);
+        }
+    }
+
+    /** dispatch the collected completions to the executor, only in the connection strand */
+    void    flush_completions(){
+        if (completion_batch_.empty()){
+            return;
+        }
+
+        completion_batch_ptr batch = std::make_shared<completion_batch_type>();
+        batch->swap(completion_batch_);
+        completion_batch_.reserve(batch->size());
+
+        completion_strand_.load()->post(std::bind(
+            &standalone_async_client::run_completions,
+            completion_guard_,
+            batch));
+    }
+
+    /** run the completions in the executor, stop once the client destroyed */
+    static void run_completions(completion_guard_ptr guard, completion_batch_ptr batch){
+        std::lock_guard<std::recursive_mutex> locker(guard->mtx);
+        for (auto& completion : *batch){
+            if (!guard->alive){
+                return;
+            }
+
+            if (completion.handler){
+                completion.handler(completion.reply);
+            }
+            else if (completion.message_handler && completion.reply){
+                redis_reply_arr& arr = completion.reply->to_array();
+                (*completion.message_handler)(arr[1].to_string(), arr[2].to_string());
+            }
+            else if (completion.message_handler){
+                (*completion.message_handler)(completion.channel, completion.message);
+            }
+        }
+    }
+
     /** try recover subscribe channels */
     void    recover_subscribe_channels(){
         channel_message_handler_map_type subcribe_list;
@@ -550,12 +1191,12 @@ private:
             connection_->close();
         }
 
-        // clear old handler queue
-        clear_handler_queue();
-
-        // clear connection old send queue
+        // clear old handler queue and the connection old send queue
         if (connection_){
-            connection_->clear_send_queue_locked();
+            connection_->post(std::bind(
+                &standalone_async_client::clear_handler_queue,
+                this));
+            connection_->clear_send_queue_in_strand();
         }
     }
 };
@@ -0,0 +1,296 @@
+﻿/**
+ *
+ * standalone_async_client_pool.hpp
+ *
+ * multiple multiplexed connections to one redis node
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-12
+ */
+
+#ifndef __ydk_rediscpp_detail_standalone_async_client_pool_hpp__
+#define __ydk_rediscpp_detail_standalone_async_client_pool_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/async/standalone_async_client.hpp>
+#include <utility/asio_base/io_service_pool.hpp>
+#include <atomic>
+#include <set>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+/** how to choose the connection for a command */
+enum async_dispatch_policy{
+    async_dispatch_round_robin = 0,
+    async_dispatch_least_pending,       // least outstanding requests
+};
+
+/**
+ * the commands are dispatched to the connections by the dispatch policy,
+ * the replies of different connections could be parsed in different io threads.
+ * the subscribe is always done by the first connection, and the first connection
+ * no longer accepts other commands while any channel subscribed( if more than
+ * one connection)
+ */
+class standalone_async_client_pool :
+    public base_async_client
+{
+protected:
+    std::vector<standalone_async_client*>   clients_;
+    async_dispatch_policy                   policy_;
+    std::atomic<uint32_t>                   next_index_;
+    std::set<std::string>                   subscribed_channels_;
+    std::mutex                              subscribe_mtx_;
+    std::atomic_bool                        has_subscribed_;
+
+public:
+    /**
+     * @param io_service - the io service of the connections
+     * @param uri - the redis uri
+     * @param connection_count - the connection count
+     * @param policy - the dispatch policy
+     */
+    standalone_async_client_pool(asio::io_service& io_service, const char* uri,
+        int32_t connection_count = 1,
+        async_dispatch_policy policy = async_dispatch_least_pending)
+        : policy_(policy)
+    {
+        next_index_ = 0;
+        has_subscribed_ = false;
+
+        if (connection_count < 1){
+            connection_count = 1;
+        }
+
+        for (int32_t i = 0; i < connection_count; ++i){
+            clients_.push_back(new standalone_async_client(io_service, uri));
+        }
+    }
+
+    /**
+     * @brief each connection is bound to one io_service( thread) of the io_service_pool
+     * @param io_service_pool - the io_service_pool of the connections
+     */
+    standalone_async_client_pool(utility::asio_base::io_service_pool& io_service_pool,
+        const char* uri,
+        int32_t connection_count = 1,
+        async_dispatch_policy policy = async_dispatch_least_pending)
+        : policy_(policy)
+    {
+        next_index_ = 0;
+        has_subscribed_ = false;
+
+        if (connection_count < 1){
+            connection_count = 1;
+        }
+
+        for (int32_t i = 0; i < connection_count; ++i){
+            clients_.push_back(new standalone_async_client(
+                io_service_pool.get_io_service(), uri, true));
+        }
+    }
+
+    virtual ~standalone_async_client_pool(){
+        for (auto client : clients_){
+            delete client;
+        }
+        clients_.clear();
+    }
+
+    void    shutdown(){
+        for (auto client : clients_){
+            client->shutdown();
+        }
+    }
+
+    /**
+    * @brief shutdown the clients, the requests not replied completed with nullptr
+    * @param closed_handler - called after the requests of all the clients completed
+    */
+    void    close(const std::function<void()>& closed_handler = nullptr){
+        if (clients_.empty()){
+            if (closed_handler){
+                closed_handler();
+            }
+            return;
+        }
+
+        std::shared_ptr<std::atomic<int32_t>> remaining =
+            std::make_shared<std::atomic<int32_t>>((int32_t)clients_.size());
+        for (auto client : clients_){
+            client->close([remaining, closed_handler](){
+                if (--(*remaining) == 0 && closed_handler){
+                    closed_handler();
+                }
+            });
+        }
+    }
+
+    void    try_connect(bool use_promise = false){
+        for (auto client : clients_){
+            client->try_connect(use_promise);
+        }
+    }
+
+    /** any connection connected */
+    bool    is_connected(){
+        for (auto client : clients_){
+            if (client->is_connected()){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string uri_string(){
+        return clients_[0]->uri_string();
+    }
+
+    int32_t connection_count(){
+        return (int32_t)clients_.size();
+    }
+
+    /**
+     * @brief set the backpressure option of every connection, the watermarks
+     * and the handler are applied to each connection separately
+     */
+    void    set_backpressure_option(const async_backpressure_option& option){
+        for (auto client : clients_){
+            client->set_backpressure_option(option);
+        }
+    }
+
+    /**
+     * @brief the handler is called when each connection opened, should be set before connect
+     */
+    void    set_open_handler(const connection_open_handler& handler){
+        for (auto client : clients_){
+            client->set_open_handler(handler);
+        }
+    }
+
+    /**
+     * @brief run the handlers in the executor, each connection keeps its own order
+     */
+    void    set_completion_executor(asio::io_service* executor){
+        for (auto client : clients_){
+            client->set_completion_executor(executor);
+        }
+    }
+
+    /**
+     * @brief choose a connection for a command by the dispatch policy
+     */
+    standalone_async_client* select_client(){
+        std::size_t count = clients_.size();
+
+        // the first connection is reserved for subscribe
+        std::size_t begin = (has_subscribed_ && count > 1) ? 1 : 0;
+        std::size_t candidates = count - begin;
+        if (candidates == 1){
+            return clients_[begin];
+        }
+
+        if (policy_ == async_dispatch_least_pending){
+            standalone_async_client* selected = nullptr;
+            int32_t min_pending = 0;
+            uint32_t start = next_index_++;
+            for (std::size_t i = 0; i < candidates; ++i){
+                standalone_async_client* client = clients_[begin + (start + i) % candidates];
+                if (!client->is_connected()){
+                    continue;
+                }
+
+                int32_t pending = client->pending_count();
+                if (!selected || pending < min_pending){
+                    selected = client;
+                    min_pending = pending;
+                }
+            }
+
+            return selected ? selected : clients_[begin];
+        }
+
+        // round robin, skip the connection not connected
+        uint32_t start = next_index_++;
+        for (std::size_t i = 0; i < candidates; ++i){
+            standalone_async_client* client = clients_[begin + (start + i) % candidates];
+            if (client->is_connected()){
+                return client;
+            }
+        }
+
+        return clients_[begin + start % candidates];
+    }
+
+public:
+    /** implement of interface of base_async_client */
+    /** try connect to server */
+    virtual void connect() override{
+        for (auto client : clients_){
+            client->connect();
+        }
+    }
+
+    /**
+    * @brief subscribe specific channel with the first connection
+    */
+    virtual void subscribe(const std::string& channel_name,
+        const channel_message_handler& message_handler,
+        const reply_handler& reply_handler) override{
+        {
+            std::lock_guard<std::mutex> locker(subscribe_mtx_);
+            subscribed_channels_.insert(channel_name);
+            has_subscribed_ = true;
+        }
+
+        clients_[0]->subscribe(channel_name, message_handler, reply_handler);
+    }
+
+    /**
+    * @brief unsubscribe specific channel
+    */
+    virtual void unsubscribe(const std::string& channel_name,
+        const reply_handler& reply_handler) override{
+        clients_[0]->unsubscribe(channel_name, reply_handler);
+
+        std::lock_guard<std::mutex> locker(subscribe_mtx_);
+        subscribed_channels_.erase(channel_name);
+        has_subscribed_ = !subscribed_channels_.empty();
+    }
+
+    /**
+    * @brief publish message to specific channel
+    */
+    virtual void publish(const std::string& channel_name,
+        const std::string& message,
+        const reply_handler& reply_handler) override{
+        select_client()->publish(channel_name, message, reply_handler);
+    }
+
+    /**
+    * @brief do command on the connection chosen by the dispatch policy
+    */
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        const reply_handler& handler) override{
+        select_client()->do_command(cmd, hash_slot, handler);
+    }
+
+    virtual void do_command(const redis_command& cmd, int32_t hash_slot,
+        reply_handler&& handler) override{
+        select_client()->do_command(cmd, hash_slot, std::move(handler));
+    }
+
+    /** is cluster mode */
+    virtual bool cluster_mode() override{
+        return false;
+    }
+};
+typedef std::shared_ptr<standalone_async_client_pool> standalone_async_client_pool_ptr;
+}
+}
+
+#endif
@@ -0,0 +1,233 @@
+﻿/**
+ *
+ * circuit_breaker.hpp
+ *
+ * the circuit breaker of a redis node, the requests to the node fail at once
+ * while the breaker open, and the exponential backoff with jitter
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-24
+ */
+
+#ifndef __ydk_rediscpp_detail_circuit_breaker_hpp__
+#define __ydk_rediscpp_detail_circuit_breaker_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/**
+ * @brief the exponential backoff with equal jitter, the delay is in
+ * [d / 2, d], d = min(max_delay, base_delay * 2 ^ attempt)
+ * @param attempt - the times failed before, start from 0
+ */
+static inline int32_t backoff_delay(int32_t base_delay, int32_t max_delay, int32_t attempt){
+    int64_t delay = base_delay;
+    for (int32_t i = 0; i < attempt && delay < max_delay; ++i){
+        delay *= 2;
+    }
+    delay = std::min<int64_t>(delay, max_delay);
+
+    int64_t half = delay / 2;
+    return (int32_t)(half + (half > 0 ? std::rand() % (half + 1) : 0));
+}
+
+enum circuit_state{
+    circuit_closed = 0,     // the requests pass
+    circuit_open,           // the requests fail at once
+    circuit_half_open,      // one probe request pass
+};
+
+struct circuit_breaker_option{
+    bool        enabled;
+    int32_t     window_time;                // the failure rate counted in the window, in milliseconds
+    int32_t     min_request_count;          // the rate not checked if less requests in the window
+    int32_t     failure_rate_threshold;     // open if the failure percent reached
+    int32_t     consecutive_failure_threshold;  // open if failed so many times in a row
+    int32_t     open_time;                  // the first open time, in milliseconds
+    int32_t     max_open_time;              // the open time doubled after each failed probe
+
+    circuit_breaker_option()
+        : enabled(true)
+        , window_time(10000)
+        , min_request_count(20)
+        , failure_rate_threshold(50)
+        , consecutive_failure_threshold(5)
+        , open_time(500)
+        , max_open_time(30000){
+    }
+};
+
+class circuit_breaker
+{
+protected:
+    circuit_breaker_option  option_;
+    std::mutex              mtx_;
+    std::atomic<int32_t>    state_;
+    int64_t                 window_start_;
+    int32_t                 request_count_;
+    int32_t                 failure_count_;
+    int32_t                 consecutive_failures_;
+    int32_t                 open_times_;        // opened in a row without success
+    int64_t                 retry_time_;        // open until, or the probe time out
+    bool                    probing_;
+
+public:
+    circuit_breaker(const circuit_breaker_option& option = circuit_breaker_option())
+        : option_(option)
+        , window_start_(0)
+        , request_count_(0)
+        , failure_count_(0)
+        , consecutive_failures_(0)
+        , open_times_(0)
+        , retry_time_(0)
+        , probing_(false){
+        state_ = circuit_closed;
+    }
+
+public:
+    /** should be set before any request */
+    void    set_option(const circuit_breaker_option& option){
+        std::lock_guard<std::mutex> locker(mtx_);
+        option_ = option;
+    }
+
+    circuit_state state(){
+        return (circuit_state)state_.load();
+    }
+
+    /** closed, like the node address changed */
+    void    reset(){
+        std::lock_guard<std::mutex> locker(mtx_);
+        state_ = circuit_closed;
+        open_times_ = 0;
+        probing_ = false;
+        reset_window(now_milliseconds());
+    }
+
+    /**
+     * @brief could the request be sent to the node
+     */
+    bool    allow_request(){
+        if (!option_.enabled || state_ == circuit_closed){
+            return true;
+        }
+
+        std::lock_guard<std::mutex> locker(mtx_);
+        int64_t now = now_milliseconds();
+        if (state_ == circuit_open){
+            if (now < retry_time_){
+                return false;
+            }
+
+            state_ = circuit_half_open;
+            probing_ = false;
+        }
+
+        if (state_ == circuit_half_open){
+            // only one probe, another one if the result of the probe not reported in time
+            if (probing_ && now < retry_time_){
+                return false;
+            }
+
+            probing_ = true;
+            retry_time_ = now + option_.open_time;
+        }
+
+        return true;
+    }
+
+    void    on_success(){
+        if (!option_.enabled){
+            return;
+        }
+
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (state_ != circuit_closed){
+            rds_log_info("circuit_breaker[%p] probe success, closed.", this);
+
+            state_ = circuit_closed;
+            open_times_ = 0;
+            reset_window(now_milliseconds());
+        }
+
+        count_request(false);
+    }
+
+    void    on_failure(){
+        if (!option_.enabled){
+            return;
+        }
+
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (state_ == circuit_half_open){
+            open();
+            return;
+        }
+
+        if (state_ == circuit_open){
+            return;
+        }
+
+        count_request(true);
+        if (consecutive_failures_ >= option_.consecutive_failure_threshold ||
+            (request_count_ >= option_.min_request_count &&
+            failure_count_ * 100 >= request_count_ * option_.failure_rate_threshold)){
+            open();
+        }
+    }
+
+protected:
+    void    count_request(bool failed){
+        int64_t now = now_milliseconds();
+        if (now - window_start_ >= option_.window_time){
+            reset_window(now);
+        }
+
+        ++request_count_;
+        if (failed){
+            ++failure_count_;
+            ++consecutive_failures_;
+        }
+        else{
+            consecutive_failures_ = 0;
+        }
+    }
+
+    void    reset_window(int64_t now){
+        window_start_ = now;
+        request_count_ = 0;
+        failure_count_ = 0;
+        consecutive_failures_ = 0;
+    }
+
+    void    open(){
+        int32_t delay = backoff_delay(option_.open_time, option_.max_open_time, open_times_++);
+        retry_time_ = now_milliseconds() + delay;
+        probing_ = false;
+        state_ = circuit_open;
+
+        rds_log_warn("circuit_breaker[%p] open for [%d]ms, requests[%d] failures[%d] open_times[%d].",
+            this, delay, request_count_, failure_count_, open_times_);
+    }
+
+    static int64_t now_milliseconds(){
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+}
+}
+
+#endif
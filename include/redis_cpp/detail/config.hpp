@@ -14,4 +14,11 @@
 /** asio standalone */
 #define ASIO_STANDALONE
 
+/** c++20 coroutine support */
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define REDIS_CPP_HAS_COROUTINE
+#endif
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+﻿/**
+ *
+ * redis_cached_script.hpp
+ *
+ * the lua script with the sha1 computed locally, evaluated by evalsha
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-17
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_cached_script_hpp__
+#define __ydk_rediscpp_detail_redis_cached_script_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/redis_reply.hpp>
+#include <utility/codec/sha1.hpp>
+#include <string>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/**
+ * only the sha1 is sent while the script cached by the redis node, the script
+ * is loaded to the node when the node reply NOSCRIPT( like restarted, flushed
+ * or a new node of the cluster)
+ * the object is immutable, could be shared by threads( like a static one)
+ */
+class redis_cached_script
+{
+protected:
+    std::string     script_;
+    std::string     sha1_;
+
+public:
+    redis_cached_script(const char* script)
+        : script_(script)
+    {
+        sha1_ = utility::codec::sha1_hex(script_.c_str(), script_.size());
+    }
+
+    redis_cached_script(const std::string& script)
+        : script_(script)
+    {
+        sha1_ = utility::codec::sha1_hex(script_.c_str(), script_.size());
+    }
+
+    const std::string& script() const{
+        return script_;
+    }
+
+    const std::string& sha1() const{
+        return sha1_;
+    }
+
+    /** check the error reply is NOSCRIPT */
+    static bool is_noscript_error(const std::string& error_msg){
+        return strnicmp(error_msg.c_str(), "NOSCRIPT", 8) == 0;
+    }
+};
+}
+}
+
+#endif
@@ -16,6 +16,8 @@
 #include <redis_cpp/detail/sync/redis_sync_operator.hpp>
 #include <redis_cpp/detail/redis_slot.hpp>
 #include <utility/asio_base/timer.hpp>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <unordered_map>
 
@@ -26,6 +28,9 @@ namespace detail
 /** check cluster slots interval in milliseconds */
 static const int32_t check_cluster_slot_interval = 5000;
 
+/** min interval of the refresh triggered by redirect in milliseconds */
+static const int32_t min_refresh_cluster_slot_interval = 1000;
+
 typedef std::function<void(const slot_range_map_type&)> cluster_slots_change_handler;
 
 class redis_cluster_slots
@@ -37,15 +42,22 @@ protected:
     std::vector<std::string>                    uri_list_;
     std::string                                 redis_passwd_;
     std::mutex                                  slot_mtx_;
+    std::mutex                                  check_mtx_;
     utility::asio_base::timer::ptr              check_cluster_slots_timer_;
     cluster_slots_change_handler*               cluster_slots_change_handler_;
     std::atomic_bool                            started_timer_;
+    std::atomic_bool                            refresh_pending_;
+    std::atomic<int64_t>                        last_refresh_time_;
+    bool                                        compare_replicas_;
 
 public:
     redis_cluster_slots(asio::io_service& service)
         : io_service_(service)
-        , cluster_slots_change_handler_(nullptr){
+        , cluster_slots_change_handler_(nullptr)
+        , compare_replicas_(false){
         started_timer_ = false;
+        refresh_pending_ = false;
+        last_refresh_time_ = 0;
         check_cluster_slots_timer_ = utility::asio_base::timer::create(io_service_);
         check_cluster_slots_timer_->register_handler(
             std::bind(&redis_cluster_slots::check_cluster_slots_timer_handler,
@@ -79,6 +91,14 @@ public:
         }
     }
 
+    /**
+     * @brief the replicas changed is also a change, only if the replicas are used
+     * by the read commands. should be set before start_timer
+     */
+    void    set_compare_replicas(bool compare){
+        compare_replicas_ = compare;
+    }
+
     /** 
      * @brief set redis passwd
      */
@@ -132,16 +152,47 @@ public:
     }
 
     /**
-    * @brief get address by slot
+    * @brief refresh the cluster slots immediately in the io thread of the
+    * slots checker, used while redirect detected. the requests in
+    * min_refresh_cluster_slot_interval are merged
+    */
+    void    refresh(){
+        int64_t now = now_milliseconds();
+        if (now - last_refresh_time_ < min_refresh_cluster_slot_interval){
+            return;
+        }
+
+        if (refresh_pending_.exchange(true)){
+            return;
+        }
+
+        io_service_.post([this](){
+            check_cluster_slots();
+            last_refresh_time_ = now_milliseconds();
+            refresh_pending_ = false;
+        });
+    }
+
+    /**
+    * @brief update the address of the slot( by the moved redirect)
     */
-    std::string* get_address_by_slot(int32_t slot){
+    void    update_slot_address(int32_t slot, const std::string& address){
+        std::lock_guard<std::mutex> locker(slot_mtx_);
+        set_slot_addr_map(slot, address);
+    }
+
+    /**
+    * @brief get address by slot, copied since the moved redirect may update it
+    */
+    bool    get_address_by_slot(int32_t slot, std::string& address){
         std::lock_guard<std::mutex> locker(slot_mtx_);
 
         auto iter = slot_addr_map_.find(slot);
         if (iter != slot_addr_map_.end()){
-            return &iter->second;
+            address = iter->second;
+            return true;
         }
-        return nullptr;
+        return false;
     }
 
 protected:
@@ -208,7 +259,7 @@ protected:
             this, slot_addr_map_.size());
     }
 
-    static bool slot_range_info_eq(const slot_range_info& s1,
+    bool    slot_range_info_eq(const slot_range_info& s1,
         const slot_range_info& s2){
         if (s1.start_slot != s2.start_slot)
             return false;
@@ -216,6 +267,18 @@ protected:
             return false;
         if (s1.master != s2.master)
             return false;
+
+        if (!compare_replicas_)
+            return true;
+
+        // the replicas used by the read commands
+        if (s1.slave_list.size() != s2.slave_list.size())
+            return false;
+
+        for (std::size_t i = 0; i < s1.slave_list.size(); ++i){
+            if (s1.slave_list[i] != s2.slave_list[i])
+                return false;
+        }
         return true;
     }
 
@@ -247,14 +310,26 @@ protected:
         return check_cluster_node_change(map);
     }
 
+    static int64_t now_milliseconds(){
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void    check_cluster_slots(){
+        // the timer and the refresh may run in different threads
+        std::lock_guard<std::mutex> locker(check_mtx_);
+
+        slot_range_map_type map;
+        if (cluster_slots_change(map)){
+            if ( cluster_slots_change_handler_)
+                (*cluster_slots_change_handler_)(map);
+        }
+    }
+
     void    check_cluster_slots_timer_handler(utility::asio_base::timer::ptr timer_ptr,
         const asio::error_code& error){
         if (!error){
-            slot_range_map_type map;
-            if (cluster_slots_change(map)){
-                if ( cluster_slots_change_handler_)
-                    (*cluster_slots_change_handler_)(map);
-            }
+            check_cluster_slots();
 
             timer_ptr->start(check_cluster_slot_interval);
         }
@@ -14,6 +14,7 @@
 #include <redis_cpp/detail/config.hpp>
 #include <sstream>
 #include <vector>
+#include <cstdio>
 
 namespace redis_cpp
 {
@@ -78,20 +79,54 @@ public:
         param_list_.clear();
     }
 
+    /** the command name and the params */
+    const std::vector<std::string>& params() const{
+        return param_list_;
+    }
+
+    /**
+     * @brief append the encoded command to the output, the output
+     * memory could be reused between commands
+     */
+    void encode(std::string& out) const{
+        encode(out, crlf);
+    }
+
 protected:
     std::string to_string(const std::string& crlf) const
     {
-        std::stringstream  result;
-        result << '*' << param_list_.size() << crlf;
+        std::string result;
+        encode(result, crlf);
+
+        return result;
+    }
+
+    void encode(std::string& out, const std::string& crlf) const
+    {
+        std::size_t len = 16;
+        for (auto& p : param_list_){
+            len += p.size() + 16;
+        }
+        out.reserve(out.size() + len);
+
+        append_length(out, '*', param_list_.size(), crlf);
 
         auto iter = param_list_.begin();
         for (iter; iter != param_list_.end(); ++iter)
         {
-            result << '$' << (*iter).size() << crlf;
-            result << (*iter) << crlf;
+            append_length(out, '$', (*iter).size(), crlf);
+            out.append(*iter);
+            out.append(crlf);
         }
+    }
 
-        return std::move(result.str());
+    static void append_length(std::string& out, char prefix, std::size_t len,
+        const std::string& crlf)
+    {
+        char buf[32];
+        int32_t n = snprintf(buf, sizeof(buf), "%c%llu", prefix, (unsigned long long)len);
+        out.append(buf, n);
+        out.append(crlf);
     }
 };
 }
@@ -83,6 +83,49 @@ namespace reply_util
 
         return true;
     }
+
+    /**
+    * @brief get the redirect address from the error info, like
+    * "MOVED 3999 127.0.0.1:6381" or "ASK 3999 127.0.0.1:6381"
+    * @param slot - the redirect slot
+    * @return the address, nullptr if the error info invalid
+    */
+    static const char* get_addr_from_redirect_error(const std::string& error_info, int32_t& slot)
+    {
+        std::size_t slot_pos = error_info.find(' ');
+        if (slot_pos == std::string::npos)
+            return nullptr;
+
+        if (slot_pos + 1 < error_info.size() - 1)
+            slot_pos++;
+
+        std::size_t addr_pos = error_info.find(' ', slot_pos);
+        if (addr_pos == std::string::npos)
+            return nullptr;
+
+        if (addr_pos + 1 < error_info.size() - 1)
+            addr_pos++;
+
+        std::string slot_str = error_info.substr(slot_pos, addr_pos - slot_pos - 1);
+        slot = atoi(slot_str.c_str());
+
+        return &error_info[addr_pos];
+    }
+
+    /**
+    * @brief split the address "ip:port"
+    */
+    static bool split_address(const std::string& address, std::string& ip, int32_t& port)
+    {
+        std::size_t pos = address.rfind(':');
+        if (pos == std::string::npos || pos + 1 >= address.size())
+            return false;
+
+        ip = address.substr(0, pos);
+        port = atoi(address.c_str() + pos + 1);
+
+        return port > 0;
+    }
 }
 }
 }
@@ -15,6 +15,8 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace redis_cpp
 {
@@ -24,6 +26,7 @@ namespace detail
 enum event_num
 {
     event_master_address_change = 0,
+    event_replica_state_change,
     event_max,
 };
 
@@ -39,6 +42,35 @@ struct master_address_change_event_t
     }
 };
 
+/** 
+ * the replica of the master added( +slave), subjectively down( +sdown) or
+ * up again( -sdown)
+ */
+struct replica_state_change_event_t
+{
+    std::string event_name;
+    std::string master_name;
+    std::string ip;
+    int32_t     port;
+
+    replica_state_change_event_t() :port(0){
+    }
+};
+
+/** the replica info in the reply of "sentinel replicas" */
+struct sentinel_replica_info
+{
+    std::string ip;
+    int32_t     port;
+    std::string flags;                  // like "slave", "slave,s_down,disconnected"
+    std::string master_link_status;     // "ok" or "err"
+    int64_t     master_link_down_time;  // in milliseconds, 0 if the link is up
+    int64_t     slave_repl_offset;
+
+    sentinel_replica_info() :port(0), master_link_down_time(0), slave_repl_offset(0){
+    }
+};
+
 class event_subscriber
 {
 public:
@@ -113,6 +145,12 @@ public:
     virtual bool    get_master_address_by_name(const char* master_name, 
         std::pair<std::string, int32_t>& out_master_address) = 0;
 
+    /** 
+     * @brief get the replicas of the master by master name
+     */
+    virtual bool    get_replicas_by_name(const char* master_name,
+        std::vector<sentinel_replica_info>& out_replicas) = 0;
+
     /** 
      * @brief start
      */
@@ -19,6 +19,9 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <atomic>
+#include <functional>
+#include <cstdlib>
+#include <vector>
 
 namespace redis_cpp
 {
@@ -29,6 +32,12 @@ class sentinel_client :
     public base_sentinel_client,
     public standalone_async_client
 {
+public:
+    /** (success, master ip, master port) */
+    typedef std::function<void(bool, const std::string&, int32_t)> master_address_handler;
+    /** (success, replicas) */
+    typedef std::function<void(bool, const std::vector<sentinel_replica_info>&)> replicas_handler;
+
 protected:
     std::atomic_bool    first_channel_open_;
     bool                subscribe_switchmaster_channel_;
@@ -48,7 +57,7 @@ public:
 protected:
     void get_master_address_reply_handler(
         std::string master_name,
-        std::weak_ptr<utility::sync::promise_once<std::tuple<bool, std::string, int32_t>>> proms,
+        master_address_handler handler,
         redis_cpp::redis_reply_ptr reply)
     {
         std::string uri_str = uri_string();
@@ -95,12 +104,74 @@ protected:
         rds_log_info("sentinel_client[%p] uri[%s] get master[%s] address reply, success[%d] master_address[%s:%d]",
             this, uri_str.c_str(), master_name.c_str(), success, ip.c_str(), port);
 
-        std::shared_ptr < utility::sync::promise_once<std::tuple<bool, std::string, int32_t>> >
-            proms_ptr = proms.lock();
+        handler(success, ip, port);
+    }
 
-        if (proms_ptr){
-            proms_ptr->set_value(std::make_tuple(success, ip, port));
-        }
+    void get_replicas_reply_handler(
+        std::string master_name,
+        replicas_handler handler,
+        redis_cpp::redis_reply_ptr reply)
+    {
+        std::string uri_str = uri_string();
+
+        bool success = false;
+        std::vector<sentinel_replica_info> replicas;
+        do{
+            if (!reply){
+                rds_log_error("sentinel_client[%p] uri[%s] get master[%s] replicas reply pointer is null",
+                    this, uri_str.c_str(), master_name.c_str());
+                break;
+            }
+
+            if (!reply->is_array())
+            {
+                rds_log_error("sentinel_client[%p] uri[%s] get master[%s] replicas reply is not array",
+                    this, uri_str.c_str(), master_name.c_str());
+                break;
+            }
+
+            // every replica is a flat array of the field and value pairs
+            redis_reply_arr& arry = reply->to_array();
+            for (auto& item : arry){
+                if (!item.is_array()){
+                    continue;
+                }
+
+                sentinel_replica_info replica;
+                redis_reply_arr& fields = item.to_array();
+                for (std::size_t i = 0; i + 1 < fields.size(); i += 2){
+                    std::string field = fields[i].to_string();
+                    std::string value = fields[i + 1].to_string();
+                    if (field == "ip"){
+                        replica.ip = value;
+                    }
+                    else if (field == "port"){
+                        sscanf(value.c_str(), "%d", &replica.port);
+                    }
+                    else if (field == "flags"){
+                        replica.flags = value;
+                    }
+                    else if (field == "master-link-status"){
+                        replica.master_link_status = value;
+                    }
+                    else if (field == "master-link-down-time"){
+                        replica.master_link_down_time = std::strtoll(value.c_str(), nullptr, 10);
+                    }
+                    else if (field == "slave-repl-offset"){
+                        replica.slave_repl_offset = std::strtoll(value.c_str(), nullptr, 10);
+                    }
+                }
+
+                replicas.push_back(replica);
+            }
+            success = true;
+
+        } while (0);
+
+        rds_log_info("sentinel_client[%p] uri[%s] get master[%s] replicas reply, success[%d] replica_count[%d]",
+            this, uri_str.c_str(), master_name.c_str(), success, (int32_t)replicas.size());
+
+        handler(success, replicas);
     }
 
 public:
@@ -113,17 +184,19 @@ public:
     virtual bool    get_master_address_by_name(const char* master_name,
         std::pair<std::string, int32_t>& out_master_address) override
     {
-        redis_command cmd("sentinel");
-        cmd.add_param("get-master-addr-by-name");
-        cmd.add_param(master_name);
-
         std::shared_ptr<utility::sync::promise_once<std::tuple<bool, std::string, int32_t>>>
             proms = std::make_shared<utility::sync::promise_once<std::tuple<bool, std::string, int32_t>>>();
 
-        std::string master_name_str(master_name);
+        std::weak_ptr<utility::sync::promise_once<std::tuple<bool, std::string, int32_t>>> proms_weak = proms;
+        async_get_master_address_by_name(master_name,
+            [proms_weak](bool success, const std::string& ip, int32_t port){
+            std::shared_ptr < utility::sync::promise_once<std::tuple<bool, std::string, int32_t>> >
+                proms_ptr = proms_weak.lock();
 
-        do_command(cmd, std::bind(&sentinel_client::get_master_address_reply_handler, 
-            this, master_name_str, proms, std::placeholders::_1));
+            if (proms_ptr){
+                proms_ptr->set_value(std::make_tuple(success, ip, port));
+            }
+        });
 
         std::future<std::tuple<bool, std::string, int32_t>> future = proms->get_future();
         std::chrono::milliseconds span(1000);
@@ -145,6 +218,88 @@ public:
         return true;
     }
 
+    /**
+    * @brief get master address by master name, the handler is called in the io thread,
+    * or at once if not connected
+    */
+    void    async_get_master_address_by_name(const char* master_name, master_address_handler handler)
+    {
+        redis_command cmd("sentinel");
+        cmd.add_param("get-master-addr-by-name");
+        cmd.add_param(master_name);
+
+        std::string master_name_str(master_name);
+
+        if (!do_command(cmd, std::bind(&sentinel_client::get_master_address_reply_handler,
+            this, master_name_str, handler, std::placeholders::_1)))
+        {
+            rds_log_error("sentinel_client[%p] uri[%s] get master[%s] address, but not connected.",
+                this, uri_string().c_str(), master_name);
+            handler(false, std::string(), 0);
+        }
+    }
+
+    /**
+    * @brief get the replicas of the master by master name
+    */
+    virtual bool    get_replicas_by_name(const char* master_name,
+        std::vector<sentinel_replica_info>& out_replicas) override
+    {
+        std::shared_ptr<utility::sync::promise_once<std::pair<bool, std::vector<sentinel_replica_info>>>>
+            proms = std::make_shared<utility::sync::promise_once<std::pair<bool, std::vector<sentinel_replica_info>>>>();
+
+        std::weak_ptr<utility::sync::promise_once<std::pair<bool, std::vector<sentinel_replica_info>>>> proms_weak = proms;
+        async_get_replicas_by_name(master_name,
+            [proms_weak](bool success, const std::vector<sentinel_replica_info>& replicas){
+            std::shared_ptr < utility::sync::promise_once<std::pair<bool, std::vector<sentinel_replica_info>>> >
+                proms_ptr = proms_weak.lock();
+
+            if (proms_ptr){
+                proms_ptr->set_value(std::make_pair(success, replicas));
+            }
+        });
+
+        std::future<std::pair<bool, std::vector<sentinel_replica_info>>> future = proms->get_future();
+        std::chrono::milliseconds span(1000);
+        std::future_status status = future.wait_for(span);
+        if (status != std::future_status::ready)
+        {
+            rds_log_error("sentinel_client[%p] uri[%s] wait for get_replicas_by_name[%s] time out, status[%d].",
+                this, uri_string().c_str(), master_name, status);
+            return false;
+        }
+
+        std::pair<bool, std::vector<sentinel_replica_info>> ret = future.get();
+        if (!ret.first){
+            return false;
+        }
+
+        out_replicas.swap(ret.second);
+        return true;
+    }
+
+    /**
+    * @brief get the replicas of the master by master name, the handler is called
+    * in the io thread, or at once if not connected
+    */
+    void    async_get_replicas_by_name(const char* master_name, replicas_handler handler)
+    {
+        // "sentinel replicas" is the alias of "sentinel slaves" since redis 5.0
+        redis_command cmd("sentinel");
+        cmd.add_param("slaves");
+        cmd.add_param(master_name);
+
+        std::string master_name_str(master_name);
+
+        if (!do_command(cmd, std::bind(&sentinel_client::get_replicas_reply_handler,
+            this, master_name_str, handler, std::placeholders::_1)))
+        {
+            rds_log_error("sentinel_client[%p] uri[%s] get master[%s] replicas, but not connected.",
+                this, uri_string().c_str(), master_name);
+            handler(false, std::vector<sentinel_replica_info>());
+        }
+    }
+
     /**
     * @brief start
     */
@@ -161,6 +316,7 @@ public:
         standalone_async_client::channel_open(ip, port);
         if (subscribe_switchmaster_channel_ && first_channel_open_.exchange(false)){
             subscribe_switchmaster_channel();
+            subscribe_replica_state_channels();
         }
     }
 
@@ -215,6 +371,44 @@ protected:
         publish_event(event_master_address_change, &event);
     }
 
+    void    sentinel_replica_state_channel_msg_handler(
+        const std::string& channel_name, const std::string& message)
+    {
+        // <instance-type> <name> <ip> <port> @ <master-name> <master-ip> <master-port>
+        std::vector<std::string> splits;
+        utility::str::string_splits(message.c_str(), " ", splits);
+        if (splits.size() != 8 || splits[0] != "slave")
+        {
+            // the events of the master or the sentinels
+            return;
+        }
+
+        replica_state_change_event_t event;
+        event.event_name = channel_name;
+        event.master_name = splits[5];
+        event.ip = splits[2];
+        sscanf(splits[3].c_str(), "%d", &event.port);
+
+        rds_log_info("sentinel_client[%p] uri[%s] recv replica event[%s], master[%s] replica_addr[%s:%d].",
+            this, uri_string().c_str(), event.event_name.c_str(), event.master_name.c_str(), event.ip.c_str(), event.port);
+
+        // publish the event
+        publish_event(event_replica_state_change, &event);
+    }
+
+    /** 
+     * @brief subscrie +slave, +sdown and -sdown channels
+     */
+    void    subscribe_replica_state_channels()
+    {
+        const char* channels[] = { "+slave", "+sdown", "-sdown" };
+        for (auto channel : channels){
+            subscribe(channel,
+                std::bind(&sentinel_client::sentinel_replica_state_channel_msg_handler, this, std::placeholders::_1, std::placeholders::_2),
+                std::bind(&sentinel_client::sentinel_default_reply_handler, this, std::placeholders::_1));
+        }
+    }
+
     /** 
      * @brief subscrie +switch-master channel
      */
@@ -16,6 +16,13 @@
 #include <redis_cpp/detail/sentinel/sentinel_client.hpp>
 #include <utility/asio_base/thread_pool.hpp>
 #include <utility/str.hpp>
+#include <utility/sync/promise_once.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
 
 namespace redis_cpp
 {
@@ -25,13 +32,45 @@ class sentinel_client_pool;
 typedef std::shared_ptr<sentinel_client_pool> sentinel_client_pool_ptr;
 typedef std::weak_ptr<sentinel_client_pool>   sentinel_client_pool_weak_ptr;
 
+/** the time in milliseconds the cached master address used, in case of the
+ +switch-master missed while the subscribe connections broken */
+static const int32_t master_address_cache_time = 60000;
+
+/** the time in milliseconds to wait for the master address from the sentinels */
+static const int32_t master_address_lookup_time_out = 1000;
+
+/** the time in milliseconds to wait for the replicas from the sentinels */
+static const int32_t replicas_lookup_time_out = 1000;
+
 class sentinel_client_pool : 
-    public base_sentinel_client
+    public base_sentinel_client,
+    public event_subscriber
 {
+protected:
+    struct master_address_info{
+        std::pair<std::string, int32_t> address;
+        int64_t                         expire_time;    // in milliseconds
+    };
+
+    /** the state of one lookup sent to all the sentinels */
+    struct master_address_lookup{
+        utility::sync::promise_once<std::tuple<bool, std::string, int32_t>> proms;
+        std::atomic<int32_t>                                                remaining;
+    };
+
+    /** the state of one replicas lookup sent to all the sentinels */
+    struct replicas_lookup{
+        sentinel_client::replicas_handler   handler;
+        std::atomic_bool                    done;
+        std::atomic<int32_t>                remaining;
+    };
+
 protected:
     utility::asio_base::thread_pool thread_pool_;
     std::vector<sentinel_client*>   subscribe_client_list_;
     std::vector<sentinel_client*>   non_subscribe_client_list_;
+    std::mutex                      master_address_mtx_;
+    std::unordered_map<std::string, master_address_info> master_address_cache_;
 
 public:
     /*
@@ -102,16 +141,153 @@ public:
     virtual bool    get_master_address_by_name(const char* master_name,
         std::pair<std::string, int32_t>& out_master_address) override
     {
-        for (auto client : non_subscribe_client_list_)
+        // cached until the +switch-master of the master
         {
-            if (client->is_connected() && 
-                client->get_master_address_by_name(master_name, out_master_address))
+            std::lock_guard<std::mutex> locker(master_address_mtx_);
+            auto iter = master_address_cache_.find(master_name);
+            if (iter != master_address_cache_.end() && iter->second.expire_time > now_milliseconds())
             {
+                out_master_address = iter->second.address;
                 return true;
             }
         }
 
-        return false;
+        // ask all the sentinels at the same time, the first answer used,
+        // so a dead sentinel not delay the lookup
+        std::vector<sentinel_client*> clients;
+        for (auto client : non_subscribe_client_list_)
+        {
+            if (client->is_connected())
+            {
+                clients.push_back(client);
+            }
+        }
+
+        if (clients.empty())
+        {
+            rds_log_error("sentinel_client_pool[%p] get master[%s] address, but no sentinel connected.",
+                this, master_name);
+            return false;
+        }
+
+        std::shared_ptr<master_address_lookup> lookup = std::make_shared<master_address_lookup>();
+        lookup->remaining = (int32_t)clients.size();
+        std::future<std::tuple<bool, std::string, int32_t>> future = lookup->proms.get_future();
+
+        for (auto client : clients)
+        {
+            client->async_get_master_address_by_name(master_name,
+                [lookup](bool success, const std::string& ip, int32_t port){
+                if (success){
+                    lookup->proms.set_value(std::make_tuple(true, ip, port));
+                }
+                else if (--lookup->remaining == 0){
+                    // all the sentinels failed
+                    lookup->proms.set_value(std::make_tuple(false, std::string(), 0));
+                }
+            });
+        }
+
+        std::future_status status = future.wait_for(std::chrono::milliseconds(master_address_lookup_time_out));
+        if (status != std::future_status::ready)
+        {
+            rds_log_error("sentinel_client_pool[%p] wait for get master[%s] address time out, sentinel_count[%d].",
+                this, master_name, (int32_t)clients.size());
+            return false;
+        }
+
+        std::tuple<bool, std::string, int32_t> ret = future.get();
+        if (!std::get<0>(ret)){
+            return false;
+        }
+
+        out_master_address.first = std::get<1>(ret);
+        out_master_address.second = std::get<2>(ret);
+
+        std::lock_guard<std::mutex> locker(master_address_mtx_);
+        master_address_info& info = master_address_cache_[master_name];
+        info.address = out_master_address;
+        info.expire_time = now_milliseconds() + master_address_cache_time;
+        return true;
+    }
+
+    /**
+    * @brief get the replicas of the master by master name
+    */
+    virtual bool    get_replicas_by_name(const char* master_name,
+        std::vector<sentinel_replica_info>& out_replicas) override
+    {
+        std::shared_ptr<utility::sync::promise_once<std::pair<bool, std::vector<sentinel_replica_info>>>>
+            proms = std::make_shared<utility::sync::promise_once<std::pair<bool, std::vector<sentinel_replica_info>>>>();
+        std::future<std::pair<bool, std::vector<sentinel_replica_info>>> future = proms->get_future();
+
+        async_get_replicas_by_name(master_name,
+            [proms](bool success, const std::vector<sentinel_replica_info>& replicas){
+            proms->set_value(std::make_pair(success, replicas));
+        });
+
+        std::future_status status = future.wait_for(std::chrono::milliseconds(replicas_lookup_time_out));
+        if (status != std::future_status::ready)
+        {
+            rds_log_error("sentinel_client_pool[%p] wait for get master[%s] replicas time out.",
+                this, master_name);
+            return false;
+        }
+
+        std::pair<bool, std::vector<sentinel_replica_info>> ret = future.get();
+        if (!ret.first){
+            return false;
+        }
+
+        out_replicas.swap(ret.second);
+        return true;
+    }
+
+    /**
+    * @brief ask all the sentinels at the same time, the handler is called once
+    * with the first answer, or failed if all the sentinels failed( or none
+    * connected), in the io thread of the sentinel client or at once
+    */
+    void    async_get_replicas_by_name(const char* master_name,
+        const sentinel_client::replicas_handler& handler)
+    {
+        std::vector<sentinel_client*> clients;
+        for (auto client : non_subscribe_client_list_)
+        {
+            if (client->is_connected())
+            {
+                clients.push_back(client);
+            }
+        }
+
+        if (clients.empty())
+        {
+            rds_log_error("sentinel_client_pool[%p] get master[%s] replicas, but no sentinel connected.",
+                this, master_name);
+            handler(false, std::vector<sentinel_replica_info>());
+            return;
+        }
+
+        std::shared_ptr<replicas_lookup> lookup = std::make_shared<replicas_lookup>();
+        lookup->handler = handler;
+        lookup->done = false;
+        lookup->remaining = (int32_t)clients.size();
+
+        for (auto client : clients)
+        {
+            client->async_get_replicas_by_name(master_name,
+                [lookup](bool success, const std::vector<sentinel_replica_info>& replicas){
+                if (success){
+                    if (!lookup->done.exchange(true)){
+                        lookup->handler(true, replicas);
+                    }
+                }
+                else if (--lookup->remaining == 0 && !lookup->done.exchange(true)){
+                    // all the sentinels failed
+                    lookup->handler(false, replicas);
+                }
+            });
+        }
     }
 
     /**
@@ -157,7 +333,28 @@ public:
         }
     }
 
+    /** implements of event_subscriber */
+    virtual void on_event(event_num e, void* content) override
+    {
+        if (e != event_master_address_change){
+            return;
+        }
+
+        // every subscribe client publishes the same switch
+        master_address_change_event_t* event = (master_address_change_event_t*)content;
+
+        std::lock_guard<std::mutex> locker(master_address_mtx_);
+        master_address_info& info = master_address_cache_[event->master_name];
+        info.address = std::make_pair(event->new_ip, event->new_port);
+        info.expire_time = now_milliseconds() + master_address_cache_time;
+    }
+
 protected:
+    static int64_t now_milliseconds(){
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     /** initialize the client list */
     void    initialize(const std::vector<std::pair<std::string, int32_t>>& srv_list){
         for (std::size_t i = 0; i < srv_list.size(); ++i){
@@ -167,6 +364,7 @@ protected:
 
             std::string uri_str = uri.to_string();
             sentinel_client* client = new sentinel_client(thread_pool_.io_service(), uri_str.c_str());
+            client->add_event_subscriber(event_master_address_change, this);
             subscribe_client_list_.push_back(client);
 
             rds_log_info("sentinel_client_pool[%p] add subscribe sentinel client[%p] uri[%s] to client pool, current subscribe size[%d].",
@@ -0,0 +1,123 @@
+﻿/**
+ *
+ * sentinel_failover_option.hpp
+ *
+ * the option of buffering and replaying the commands while the master switched
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-23
+ */
+
+#ifndef __ydk_rediscpp_detail_sentinel_failover_option_hpp__
+#define __ydk_rediscpp_detail_sentinel_failover_option_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/redis_command.hpp>
+#include <redis_cpp/redis_reply.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** the interval in milliseconds to reconnect to the new master while switching */
+static const int32_t failover_reconnect_interval = 100;
+
+/**
+ * after the +switch-master, the connections to the old master are dropped, the
+ * new commands wait( at most buffer_time and buffer_bytes) until connected to the
+ * new master, and the replay commands failed by the switch are done again once
+ */
+struct sentinel_failover_option
+{
+    int32_t                         buffer_time;    // in milliseconds, no buffer and replay if 0
+    int64_t                         buffer_bytes;   // the commands over it failed at once
+    std::unordered_set<std::string> replay_commands;// the idempotent commands( lower case)
+
+    sentinel_failover_option()
+        : buffer_time(3000)
+        , buffer_bytes(1024 * 1024){
+        const char* commands[] = {
+            "ping", "echo", "get", "mget", "strlen", "getrange", "exists", "ttl", "pttl", "type",
+            "hget", "hmget", "hgetall", "hkeys", "hvals", "hlen", "hexists",
+            "lindex", "llen", "lrange",
+            "scard", "sismember", "smembers",
+            "zcard", "zcount", "zrange", "zrangebyscore", "zrank", "zrevrange", "zrevrangebyscore",
+            "zrevrank", "zscore",
+            "set", "mset", "del", "unlink", "expireat", "pexpireat", "persist",
+            "hset", "hmset", "hdel", "sadd", "srem", "zadd", "zrem",
+        };
+        replay_commands.insert(std::begin(commands), std::end(commands));
+    }
+
+    bool    is_replay_command(const redis_command& cmd) const{
+        const std::vector<std::string>& params = cmd.params();
+        if (params.empty()){
+            return false;
+        }
+
+        std::string name(params[0]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (replay_commands.find(name) == replay_commands.end()){
+            return false;
+        }
+
+        return !has_relative_option(name, params);
+    }
+
+    /**
+     * @brief "zadd ... incr" increments the score, "set ... ex|px" extends the ttl
+     * again, not replayed even in the replay commands
+     */
+    static bool has_relative_option(const std::string& name, const std::vector<std::string>& params){
+        if (name == "zadd"){
+            // the options between the key and the first score
+            for (std::size_t i = 2; i < params.size(); ++i){
+                std::string option(params[i]);
+                std::transform(option.begin(), option.end(), option.begin(), ::tolower);
+                if (option == "incr"){
+                    return true;
+                }
+                if (option != "nx" && option != "xx" && option != "gt" && option != "lt" && option != "ch"){
+                    break;
+                }
+            }
+        }
+        else if (name == "set"){
+            for (std::size_t i = 3; i < params.size(); ++i){
+                std::string option(params[i]);
+                std::transform(option.begin(), option.end(), option.begin(), ::tolower);
+                if (option == "ex" || option == "px"){
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /** the bytes of the command buffered */
+    static int64_t command_bytes(const redis_command& cmd){
+        int64_t bytes = 0;
+        for (auto& param : cmd.params()){
+            bytes += (int64_t)param.size();
+        }
+        return bytes;
+    }
+
+    /** failed by the switch, or the old master turned to replica */
+    static bool is_switch_failure(const redis_reply_ptr& reply){
+        return !reply || (reply->is_error() && reply->to_error().msg.compare(0, 8, "READONLY") == 0);
+    }
+};
+
+}
+}
+
+#endif
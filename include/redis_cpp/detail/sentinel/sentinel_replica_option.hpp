@@ -0,0 +1,89 @@
+﻿/**
+ *
+ * sentinel_replica_option.hpp
+ *
+ * the option of reading from the replicas discovered by the sentinels
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-24
+ */
+
+#ifndef __ydk_rediscpp_detail_sentinel_replica_option_hpp__
+#define __ydk_rediscpp_detail_sentinel_replica_option_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sentinel/base_sentinel_client.hpp>
+#include <redis_cpp/detail/sync/replica_read_option.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/**
+ * the replicas discovered by the sentinels, the replica is excluded while it is
+ * down( s_down, o_down or disconnected), the link to the master down too long,
+ * or the replication lag too large.
+ * the lag is checked by the offsets read from the master and the replicas
+ * themselves( "info replication"), the offsets cached by the sentinels are
+ * refreshed only every 10 seconds
+ */
+struct sentinel_replica_option : public replica_read_option
+{
+    int64_t     max_link_down_time;     // in milliseconds
+    int64_t     max_repl_lag;           // in bytes behind the master, not checked if < 0
+    int32_t     refresh_interval;       // refresh the replicas from the sentinels, in milliseconds
+
+    sentinel_replica_option()
+        : max_link_down_time(5000)
+        , max_repl_lag(1024 * 1024)
+        , refresh_interval(10000){
+    }
+
+    /** not down, and the link to the master not down too long */
+    bool    is_linked(const sentinel_replica_info& replica) const{
+        if (replica.flags.find("s_down") != std::string::npos ||
+            replica.flags.find("o_down") != std::string::npos ||
+            replica.flags.find("disconnected") != std::string::npos){
+            return false;
+        }
+
+        return replica.master_link_down_time <= max_link_down_time;
+    }
+
+    /**
+     * @param master_offset - read before the replica offset, so the lag is never
+     * larger than the real one
+     */
+    bool    is_lag_acceptable(int64_t master_offset, int64_t replica_offset) const{
+        return max_repl_lag < 0 || master_offset - replica_offset <= max_repl_lag;
+    }
+
+    /**
+     * @brief parse the offset from the reply of "info replication", the field is
+     * "master_repl_offset" of the master, "slave_repl_offset" of the replica
+     */
+    static bool parse_repl_offset(const std::string& info, const char* field, int64_t& offset){
+        std::size_t len = strlen(field);
+        std::size_t pos = 0;
+        while ((pos = info.find(field, pos)) != std::string::npos){
+            // the whole field at the line begin
+            if ((pos == 0 || info[pos - 1] == '\n') && info.size() > pos + len && info[pos + len] == ':'){
+                offset = std::strtoll(info.c_str() + pos + len + 1, nullptr, 10);
+                return true;
+            }
+            pos += len;
+        }
+
+        return false;
+    }
+};
+
+}
+}
+
+#endif
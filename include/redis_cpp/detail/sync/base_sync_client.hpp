@@ -20,6 +20,7 @@ namespace redis_cpp
 namespace detail
 {
 class base_standalone_sync_client_pool;
+class standalone_sync_client;
 class base_sync_client
 {
 public:
@@ -32,6 +33,15 @@ public:
     
     /** is cluster mode */
     virtual bool            cluster_mode() = 0;
+
+    /**
+     * @brief get a dedicated connection of the hash slot( like the transaction),
+     * the connection should be given back by standalone_sync_client::release
+     * @return nullptr if not supported
+     */
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot){
+        return nullptr;
+    }
 };
 }
 }
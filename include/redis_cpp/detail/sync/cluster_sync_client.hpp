@@ -14,15 +14,23 @@
 #include <redis_cpp/detail/config.hpp>
 #include <redis_cpp/detail/sync/base_sync_client.hpp>
 #include <redis_cpp/detail/sync/standalone_sync_client_pool.hpp>
+#include <redis_cpp/detail/sync/replica_read_option.hpp>
+#include <redis_cpp/detail/sync/replica_selector.hpp>
 #include <redis_cpp/detail/redis_cluster_slots.hpp>
+#include <redis_cpp/detail/redis_reply_util.hpp>
 #include <redis_cpp/internal/logger_handler.hpp>
 #include <utility/asio_base/thread_pool.hpp>
 #include <utility/asio_base/timer.hpp>
 #include <utility/str.hpp>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace redis_cpp
 {
@@ -44,6 +52,17 @@ struct delay_free_con_pool_info{
 class cluster_sync_client : 
     public base_sync_client
 {
+protected:
+    struct replica_node : public replica_state{
+        standalone_sync_client_pool*    pool;
+    };
+    typedef std::shared_ptr<replica_node> replica_node_ptr;
+
+    struct replica_range{
+        int32_t                         start_slot;
+        std::vector<replica_node_ptr>   nodes;
+    };
+
 protected:
     int32_t                         pool_init_size_;
     int32_t                         pool_max_size_;
@@ -56,6 +75,10 @@ protected:
     int32_t                         random_pool_roll;
     utility::asio_base::timer::ptr  delay_free_con_pool_timer_;
     redis_cluster_slots*            cluster_slots_;
+    replica_read_option             replica_option_;
+    std::map<std::string, replica_node_ptr> replica_node_map_;  // address -> replica
+    std::map<int32_t, replica_range>        replica_range_map_; // the end slot -> the replicas of the range
+    replica_selector                replica_selector_;
 
 public:
     /** 
@@ -64,15 +87,19 @@ public:
      * like redis://foobared@127.0.0.1:7000;redis://foobared@127.0.0.1:7001;redis://foobared@127.0.0.1:7002;
      * @param pool_init_size - the initialize pool size of each address connection pool
      * @param pool_max_size - the max pool size of each address connection pool
+     * @param replica_option - read from the replicas, disabled by default
      */
     cluster_sync_client(const char* uri,
         int32_t pool_init_size,
-        int32_t pool_max_size)
+        int32_t pool_max_size,
+        const replica_read_option& replica_option = replica_read_option())
         : pool_init_size_(pool_init_size)
         , pool_max_size_(pool_max_size)
         , random_pool_roll(0)
         , thread_pool_(1)
         , cluster_slots_(nullptr)
+        , replica_option_(replica_option)
+        , replica_selector_(replica_option)
     {
         thread_pool_.start();
         stopped_ = false;
@@ -90,6 +117,7 @@ public:
         cluster_slots_ = new redis_cluster_slots(thread_pool_.io_service());
         cluster_slots_->set_uri_list(uri_list);
         cluster_slots_->set_redis_passwd(redis_passwd);
+        cluster_slots_->set_compare_replicas(replica_option_.policy != replica_read_none);
 
         slot_range_map_type map;
         if (cluster_slots_->get_cluster_slots_map(map)){
@@ -135,6 +163,12 @@ public:
             }
             client_pool_map_.clear();
 
+            for (auto& node_kv : replica_node_map_){
+                delete node_kv.second->pool;
+            }
+            replica_node_map_.clear();
+            replica_range_map_.clear();
+
             // free the delay free pool
             for (auto& pool : delay_free_pool_list_){
                 delete pool.pool;
@@ -153,6 +187,14 @@ public:
     /** do command */
     virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
     {
+        if (replica_option_.policy != replica_read_none && hash_slot >= 0 &&
+            replica_option_.is_read_command(cmd)){
+            redis_reply_ptr reply = do_replica_command(cmd, hash_slot);
+            if (reply){
+                return reply;
+            }
+        }
+
         auto client = get_client_by_slot(hash_slot);
 
         if (!client){
@@ -185,7 +227,7 @@ public:
             if (EQ(err.msg.c_str(), "moved")){
                 int32_t redirect_slot = -10000;
                 const char* address =
-                    get_addr_from_redirect_error(err.msg, redirect_slot);
+                    reply_util::get_addr_from_redirect_error(err.msg, redirect_slot);
                 if (!address){
                     rds_log_error("moved invalid, error_desc:%s", err.msg.c_str());
                     return reply;
@@ -204,7 +246,7 @@ public:
             else if (EQ(err.msg.c_str(), "ask")){
                 int32_t redirect_slot = -10000;
                 const char* address =
-                    get_addr_from_redirect_error(err.msg, redirect_slot);
+                    reply_util::get_addr_from_redirect_error(err.msg, redirect_slot);
                 if (!address){
                     rds_log_error("ask invalid, error_desc:%s", err.msg.c_str());
                     return reply;
@@ -254,6 +296,12 @@ public:
         return true;
     }
 
+    /** get a client of the node which the slot located at */
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot) override
+    {
+        return get_client_by_slot(hash_slot);
+    }
+
 public:
    /**
     * @brief redirect client
@@ -325,6 +373,111 @@ protected:
         for (auto& node : map){
             add_pool(node.second.master.ip, node.second.master.port);
         }
+
+        if (replica_option_.policy != replica_read_none){
+            initialize_replicas(map);
+        }
+    }
+
+    /**
+     * @brief the readonly connection pools of the replicas, not used by the redirect
+     * @param old_nodes - the replicas before, reused if still there and removed from it
+     */
+    void    initialize_replicas(const slot_range_map_type& map,
+        std::map<std::string, replica_node_ptr>* old_nodes = nullptr){
+        for (auto& node : map){
+            replica_range& range = replica_range_map_[node.first.end_slot];
+            range.start_slot = node.first.start_slot;
+
+            for (auto& slave : node.second.slave_list){
+                std::stringstream ss;
+                ss << slave.ip << ":" << slave.port;
+                std::string address(std::move(ss.str()));
+
+                replica_node_ptr& replica = replica_node_map_[address];
+                if (!replica && old_nodes){
+                    auto old = old_nodes->find(address);
+                    if (old != old_nodes->end()){
+                        replica = old->second;
+                        old_nodes->erase(old);
+                    }
+                }
+
+                if (!replica){
+                    redis_uri uri;
+                    uri.set_passwd(cluster_slots_->get_redis_passwd());
+                    uri.set_ip(slave.ip.c_str());
+                    uri.set_port(slave.port);
+
+                    replica = std::make_shared<replica_node>();
+                    replica->address = address;
+                    replica->pool = new standalone_sync_client_pool(uri.to_string().c_str(),
+                        pool_init_size_, pool_max_size_, nullptr, true);
+
+                    auto zone = replica_option_.node_zones.find(address);
+                    if (zone != replica_option_.node_zones.end()){
+                        replica->zone = zone->second;
+                    }
+
+                    rds_log_info("cluster_client[%p] add replica pool of address[%s] zone[%s].",
+                        this, address.c_str(), replica->zone.c_str());
+                }
+
+                range.nodes.push_back(replica);
+            }
+        }
+    }
+
+    /**
+     * @brief choose the replica of the slot by the policy, prefer the replicas
+     * in the local zone, skip the replicas failed recently
+     */
+    replica_node_ptr choose_replica(int32_t hash_slot){
+        std::lock_guard<std::mutex> locker(client_pool_mtx_);
+
+        auto iter = replica_range_map_.lower_bound(hash_slot);
+        if (iter == replica_range_map_.end() || iter->second.start_slot > hash_slot){
+            return nullptr;
+        }
+
+        return replica_selector_.choose(iter->second.nodes);
+    }
+
+    /**
+     * @brief do the command on the replica
+     * @return nullptr if failed or replied error, then done by the master
+     */
+    redis_reply_ptr do_replica_command(const redis_command& cmd, int32_t hash_slot){
+        replica_node_ptr replica = choose_replica(hash_slot);
+        if (!replica){
+            return nullptr;
+        }
+
+        standalone_sync_client* client = replica->pool->get_client();
+        if (!client){
+            replica->on_failed();
+            return nullptr;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        redis_reply_ptr reply = client->do_command(cmd, hash_slot);
+        if (!reply){
+            client->free();
+            replica->on_failed();
+            rds_log_warn("cluster_client[%p] replica[%s] command failed, fall back to the master.",
+                this, replica->address.c_str());
+            return nullptr;
+        }
+        client->close();
+
+        // like moved( the replica changed) or loading, the master would reply the command error too
+        if (reply->is_error()){
+            return nullptr;
+        }
+
+        replica->on_replied(start);
+
+        return reply;
     }
 
     /** 
@@ -375,12 +528,12 @@ protected:
         if (slot < 0)
             return random_pool();
 
-        std::string* address = cluster_slots_->get_address_by_slot(slot);
-        if (!address){
+        std::string address;
+        if (!cluster_slots_->get_address_by_slot(slot, address)){
             return nullptr;
         }
 
-        return get_pool_by_address(*address);
+        return get_pool_by_address(address);
     }
 
     /** 
@@ -392,49 +545,58 @@ protected:
 
 private:
     /**
-    * @brief 从错误信息里面取出重定向的ip地址
-    */
-    static const char* get_addr_from_redirect_error(const std::string& error_info, int32_t& slot)
-    {
-        std::size_t slot_pos = error_info.find(' ');
-        if (slot_pos == std::string::npos)
-            return nullptr;
-
-        if (slot_pos + 1 < error_info.size() - 1)
-            slot_pos++;
-
-        std::size_t addr_pos = error_info.find(' ', slot_pos);
-        if (addr_pos == std::string::npos)
-            return nullptr;
+     * @brief only the pools of the nodes removed are freed( delayed), the pools
+     * of the nodes still there are kept
+     */
+    void    reset_connection_pool(const slot_range_map_type& map){
+        std::lock_guard<std::mutex> locker(client_pool_mtx_);
 
-        if (addr_pos + 1 < error_info.size() - 1)
-            addr_pos++;
+        cluster_slots_->reset(map);
 
-        std::string slot_str = error_info.substr(slot_pos, addr_pos - slot_pos - 1);
-        slot = atoi(slot_str.c_str());
+        std::set<std::string> addresses;
+        for (auto& node : map){
+            std::stringstream ss;
+            ss << node.second.master.ip << ":" << node.second.master.port;
+            std::string address(std::move(ss.str()));
+            addresses.insert(address);
 
-        return &error_info[addr_pos];
-    }
+            if (!get_pool_by_address(address)){
+                add_pool(node.second.master.ip, node.second.master.port);
+            }
+        }
 
-private:
-    void    reset_connection_pool(const slot_range_map_type& map){
         // remove the old pool
-        std::lock_guard<std::mutex> locker(client_pool_mtx_);
+        for (auto iter = client_pool_map_.begin(); iter != client_pool_map_.end();){
+            if (addresses.count(iter->first) > 0){
+                ++iter;
+                continue;
+            }
 
-        for (auto& pool : client_pool_map_){
-            delay_free_con_pool_info info;
-            info.address = pool.first;
-            info.pool = pool.second;
-            info.start_time = time(nullptr);
-            delay_free_pool_list_.push_back(info);
+            delay_free_pool(iter->first, iter->second);
+            iter = client_pool_map_.erase(iter);
         }
 
-        client_pool_map_.clear();
+        std::map<std::string, replica_node_ptr> old_replicas;
+        old_replicas.swap(replica_node_map_);
+        replica_range_map_.clear();
+        if (replica_option_.policy != replica_read_none){
+            initialize_replicas(map, &old_replicas);
+        }
+
+        for (auto& node : old_replicas){
+            delay_free_pool(node.first, node.second->pool);
+        }
 
         rds_log_info("[%p] reset_connection_pool, cur_pool[%d], delay free count[%d].",
             this, client_pool_map_.size(), delay_free_pool_list_.size());
+    }
 
-        initialize(map);
+    void    delay_free_pool(const std::string& address, standalone_sync_client_pool* pool){
+        delay_free_con_pool_info info;
+        info.address = address;
+        info.pool = pool;
+        info.start_time = time(nullptr);
+        delay_free_pool_list_.push_back(info);
     }
 
     void    process_cluster_slot_change(const slot_range_map_type& map){
@@ -0,0 +1,132 @@
+﻿/**
+ *
+ * multiplexed_sync_client.hpp
+ *
+ * sync client over a few multiplexed async connections, the commands of the
+ * concurrent callers are pipelined on the shared connections
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-15
+ */
+
+#ifndef __ydk_rediscpp_detail_multiplexed_sync_client_hpp__
+#define __ydk_rediscpp_detail_multiplexed_sync_client_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sync/base_sync_client.hpp>
+#include <redis_cpp/detail/sync/sync_reply_waiter.hpp>
+#include <redis_cpp/detail/async/standalone_async_client_pool.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <utility/asio_base/thread_pool.hpp>
+#include <memory>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** default timeout of the command in milliseconds */
+static const int32_t default_multiplexed_command_timeout = 5000;
+
+/**
+ * each call sends its command by the shared connections and blocks until the
+ * reply come, so the commands of many threads are sent in batch.
+ * the blocking commands( like blpop), the subscribe and the transaction should
+ * not be used since the connection is shared by other callers, and should not
+ * be called in the io thread of the connections
+ */
+class multiplexed_sync_client :
+    public base_sync_client
+{
+protected:
+    utility::asio_base::thread_pool*     thread_pool_;
+    bool                                 thread_pool_self_maintain_;
+    standalone_async_client_pool*        async_client_;
+    int32_t                              command_timeout_;
+
+public:
+    /**
+     * @param uri like "redis://foobared@localhost:6380/2"
+     * @param connection_count - the shared connection count
+     * @param thread_pool - the io threads of the connections, create a new one if null
+     * @param command_timeout - in milliseconds, 0 means no timeout
+     */
+    multiplexed_sync_client(const char* uri,
+        int32_t connection_count = 1,
+        utility::asio_base::thread_pool* thread_pool = nullptr,
+        int32_t command_timeout = default_multiplexed_command_timeout)
+        : command_timeout_(command_timeout)
+    {
+        if (thread_pool){
+            thread_pool_ = thread_pool;
+            thread_pool_self_maintain_ = false;
+        }
+        else{
+            thread_pool_ = new utility::asio_base::thread_pool(2);
+            thread_pool_self_maintain_ = true;
+            thread_pool_->start();
+        }
+
+        async_client_ = new standalone_async_client_pool(thread_pool_->io_service(),
+            uri, connection_count, async_dispatch_least_pending);
+    }
+
+    virtual ~multiplexed_sync_client(){
+        async_client_->shutdown();
+
+        if (thread_pool_self_maintain_){
+            thread_pool_->stop();
+            thread_pool_->wait_for_stop();
+        }
+
+        delete async_client_;
+        async_client_ = nullptr;
+
+        if (thread_pool_self_maintain_){
+            delete thread_pool_;
+            thread_pool_ = nullptr;
+        }
+    }
+
+    /** connect the shared connections, wait until connected( or timeout) */
+    void    connect(){
+        async_client_->connect();
+    }
+
+    bool    is_connected(){
+        return async_client_->is_connected();
+    }
+
+    std::string uri_string(){
+        return async_client_->uri_string();
+    }
+
+public:
+    /** interface **/
+    /** do command */
+    virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
+    {
+        sync_reply_waiter_ptr waiter = std::make_shared<sync_reply_waiter>();
+        async_client_->do_command(cmd, hash_slot, [waiter](redis_reply_ptr reply){
+            waiter->set_reply(reply);
+        });
+
+        if (!waiter->wait(command_timeout_)){
+            rds_log_error("multiplexed_sync_client[%p] uri[%s] wait reply timeout[%d ms].",
+                this, uri_string().c_str(), command_timeout_);
+            return nullptr;
+        }
+
+        return waiter->reply();
+    }
+
+    /** is cluster mode */
+    virtual bool    cluster_mode() override
+    {
+        return false;
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,537 @@
+﻿/**
+ *
+ * near_cache_sync_client.hpp
+ *
+ * sync client with the local cache of the read commands, kept coherent by
+ * the server assisted invalidation( client tracking, RESP2 redirect mode)
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-18
+ */
+
+#ifndef __ydk_rediscpp_detail_near_cache_sync_client_hpp__
+#define __ydk_rediscpp_detail_near_cache_sync_client_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sync/base_sync_client.hpp>
+#include <redis_cpp/detail/sync/standalone_sync_client_pool.hpp>
+#include <redis_cpp/detail/async/standalone_async_client.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <utility/asio_base/thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** the channel of the invalidation messages */
+static const char* tracking_invalidate_channel = "__redis__:invalidate";
+
+struct near_cache_option
+{
+    int64_t     max_memory;     // the memory budget of the cached replies, in bytes
+    int32_t     max_ttl;        // the max time a reply cached, in milliseconds, 0 means no limit
+
+    near_cache_option()
+        : max_memory(64 * 1024 * 1024)
+        , max_ttl(0){
+    }
+};
+
+/**
+ * the replies of the single key read commands( get, hget, hgetall ...) are
+ * cached locally, the key is tracked by the server( client tracking optin
+ * redirect to the subscribe connection), and removed from the local cache
+ * when the invalidation message received, or the key ttl reached.
+ * the least recently used replies are evicted when the memory budget reached.
+ * nothing is served from the cache while the subscribe connection is broken,
+ * and the cache is cleared when it reconnected( the invalidations may lost)
+ */
+class near_cache_sync_client :
+    public base_sync_client
+{
+protected:
+    struct cache_entry
+    {
+        std::string                             key;
+        redis_reply_ptr                         reply;
+        int64_t                                 size;
+        bool                                    has_expire;
+        std::chrono::steady_clock::time_point   expire_time;
+        std::list<std::string>::iterator        lru_iter;
+    };
+
+    /** the reads not finished, the reply is not cached if invalidated meanwhile */
+    struct pending_read
+    {
+        int32_t     count;
+        bool        invalidated;
+
+        pending_read() : count(0), invalidated(false){
+        }
+    };
+
+    /** the tracking state of a data connection */
+    struct tracking_state
+    {
+        uint64_t    session_id;
+        uint64_t    epoch;
+    };
+
+protected:
+    utility::asio_base::thread_pool*     thread_pool_;
+    bool                                 thread_pool_self_maintain_;
+    standalone_sync_client_pool*         data_pool_;
+    standalone_async_client*             subscriber_;
+    near_cache_option                    option_;
+    std::unordered_set<std::string>      cacheable_commands_;
+
+    std::mutex                                                  mtx_;
+    std::unordered_map<std::string, cache_entry>                entries_;       // encoded command -> entry
+    std::unordered_map<std::string, std::vector<std::string>>   key_index_;     // key -> encoded commands
+    std::list<std::string>                                      lru_list_;      // most recently used first
+    std::unordered_map<std::string, pending_read>               pending_reads_;
+    int64_t                                                     memory_;
+
+    std::atomic<int64_t>                 tracking_redirect_id_;     // the client id of the subscribe connection
+    std::atomic<uint64_t>                tracking_epoch_;           // increased when the redirect id changed
+    std::mutex                           tracking_mtx_;
+    std::map<standalone_sync_client*, tracking_state> tracking_clients_;
+
+    std::atomic<int64_t>                 hit_count_;
+    std::atomic<int64_t>                 miss_count_;
+
+public:
+    /**
+     * @param uri like "redis://foobared@localhost:6380/2"
+     * @param pool_init_size - the init size of the data connection pool
+     * @param pool_max_size - the max size of the data connection pool
+     * @param thread_pool - the io threads, create a new one if null
+     * @param option - the cache option
+     */
+    near_cache_sync_client(const char* uri,
+        int32_t pool_init_size,
+        int32_t pool_max_size,
+        utility::asio_base::thread_pool* thread_pool = nullptr,
+        const near_cache_option& option = near_cache_option())
+        : option_(option)
+        , memory_(0)
+    {
+        tracking_redirect_id_ = 0;
+        tracking_epoch_ = 0;
+        hit_count_ = 0;
+        miss_count_ = 0;
+
+        if (thread_pool){
+            thread_pool_ = thread_pool;
+            thread_pool_self_maintain_ = false;
+        }
+        else{
+            thread_pool_ = new utility::asio_base::thread_pool(2);
+            thread_pool_self_maintain_ = true;
+            thread_pool_->start();
+        }
+
+        data_pool_ = new standalone_sync_client_pool(uri, pool_init_size, pool_max_size, thread_pool_);
+        subscriber_ = new standalone_async_client(thread_pool_->io_service(), uri);
+        subscriber_->set_open_handler(
+            std::bind(&near_cache_sync_client::on_subscriber_open, this));
+
+        static const char* default_commands[] = {
+            "get", "strlen", "getrange",
+            "hget", "hmget", "hgetall", "hexists", "hlen", "hkeys", "hvals",
+            "lrange", "lindex", "llen",
+            "smembers", "sismember", "scard",
+            "zrange", "zrevrange", "zscore", "zcard", "zrank", "zrevrank",
+        };
+        for (auto cmd : default_commands){
+            cacheable_commands_.insert(cmd);
+        }
+    }
+
+    virtual ~near_cache_sync_client(){
+        subscriber_->shutdown();
+
+        if (thread_pool_self_maintain_){
+            thread_pool_->stop();
+            thread_pool_->wait_for_stop();
+        }
+
+        delete subscriber_;
+        subscriber_ = nullptr;
+
+        delete data_pool_;
+        data_pool_ = nullptr;
+
+        if (thread_pool_self_maintain_){
+            delete thread_pool_;
+            thread_pool_ = nullptr;
+        }
+    }
+
+    /** connect the subscribe connection and subscribe the invalidation channel */
+    void    connect(){
+        subscriber_->connect();
+        subscriber_->subscribe(tracking_invalidate_channel,
+            std::bind(&near_cache_sync_client::on_invalidate, this,
+            std::placeholders::_1, std::placeholders::_2),
+            [](redis_reply_ptr reply){});
+    }
+
+    /**
+     * @brief set the read commands could be cached( lower case), the first param
+     * must be the only key. should be set before used
+     */
+    void    set_cacheable_commands(const std::vector<std::string>& commands){
+        cacheable_commands_.clear();
+        cacheable_commands_.insert(commands.begin(), commands.end());
+    }
+
+    /** remove all the cached replies */
+    void    clear(){
+        std::lock_guard<std::mutex> locker(mtx_);
+        entries_.clear();
+        key_index_.clear();
+        lru_list_.clear();
+        memory_ = 0;
+
+        for (auto& iter : pending_reads_){
+            iter.second.invalidated = true;
+        }
+    }
+
+    int64_t hit_count(){
+        return hit_count_;
+    }
+
+    int64_t miss_count(){
+        return miss_count_;
+    }
+
+    int64_t memory(){
+        std::lock_guard<std::mutex> locker(mtx_);
+        return memory_;
+    }
+
+    std::size_t size(){
+        std::lock_guard<std::mutex> locker(mtx_);
+        return entries_.size();
+    }
+
+public:
+    /** interface **/
+    /** do command, the reply of the read command may come from the cache */
+    virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
+    {
+        const std::vector<std::string>& params = cmd.params();
+        if (!is_cacheable(params)){
+            // the write of this client is seen by the following reads at once,
+            // the other keys of the multiple keys writes invalidated by the server
+            if (params.size() > 1){
+                invalidate_key(params[1]);
+            }
+
+            return data_pool_->do_command(cmd, hash_slot);
+        }
+
+        if (!tracking_ready()){
+            return data_pool_->do_command(cmd, hash_slot);
+        }
+
+        std::string id(std::move(cmd.to_string()));
+        redis_reply_ptr reply = lookup(id);
+        if (reply){
+            ++hit_count_;
+            return reply;
+        }
+
+        ++miss_count_;
+        return read_and_cache(cmd, id, params[1]);
+    }
+
+    /** is cluster mode */
+    virtual bool    cluster_mode() override
+    {
+        return false;
+    }
+
+    /** the dedicated connection bypass the cache */
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot) override
+    {
+        return data_pool_->acquire_client(hash_slot);
+    }
+
+protected:
+    bool    is_cacheable(const std::vector<std::string>& params){
+        if (params.size() < 2){
+            return false;
+        }
+
+        std::string name(params[0]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        return cacheable_commands_.find(name) != cacheable_commands_.end();
+    }
+
+    bool    tracking_ready(){
+        return tracking_redirect_id_ != 0 && subscriber_->is_connected();
+    }
+
+    /** get a copy of the cached reply, null if not cached or expired */
+    redis_reply_ptr lookup(const std::string& id){
+        std::lock_guard<std::mutex> locker(mtx_);
+
+        auto iter = entries_.find(id);
+        if (iter == entries_.end()){
+            return nullptr;
+        }
+
+        cache_entry& entry = iter->second;
+        if (entry.has_expire && entry.expire_time <= std::chrono::steady_clock::now()){
+            erase_entry(iter);
+            return nullptr;
+        }
+
+        lru_list_.splice(lru_list_.begin(), lru_list_, entry.lru_iter);
+        return std::make_shared<redis_reply>(*entry.reply);
+    }
+
+    /**
+     * @brief read the key with the tracking enabled, and the ttl of the key
+     * in one write, cache the reply if not invalidated meanwhile
+     */
+    redis_reply_ptr read_and_cache(const redis_command& cmd, const std::string& id,
+        const std::string& key){
+        standalone_sync_client* client = data_pool_->acquire_client(-1);
+        if (!client){
+            rds_log_error("near_cache_sync_client[%p] can't find available client to do cmd.", this);
+            return nullptr;
+        }
+
+        if (!ensure_tracking(client)){
+            client->release(false);
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            pending_reads_[key].count++;
+        }
+
+        std::vector<redis_command> cmds;
+        cmds.reserve(3);
+        redis_command caching_cmd("client");
+        caching_cmd.add_param("caching");
+        caching_cmd.add_param("yes");
+        cmds.push_back(std::move(caching_cmd));
+        cmds.push_back(cmd);
+        redis_command pttl_cmd("pttl");
+        pttl_cmd.add_param(key);
+        cmds.push_back(std::move(pttl_cmd));
+
+        std::vector<redis_reply_ptr> replies;
+        bool ret = client->do_pipeline(cmds, replies);
+        client->release(ret);
+
+        std::lock_guard<std::mutex> locker(mtx_);
+        auto pending_iter = pending_reads_.find(key);
+        bool invalidated = pending_iter->second.invalidated;
+        if (--pending_iter->second.count == 0){
+            pending_reads_.erase(pending_iter);
+        }
+
+        if (!ret){
+            return nullptr;
+        }
+
+        redis_reply_ptr reply = replies[1];
+        if (invalidated || reply->is_error() || !replies[0]->check_status_ok() ||
+            !replies[2]->is_integer()){
+            return reply;
+        }
+
+        // -1 no ttl, -2 not exists( the nil reply cached too)
+        int64_t pttl = replies[2]->to_integer();
+        if (pttl == 0){
+            return reply;
+        }
+
+        cache_entry entry;
+        entry.key = key;
+        entry.reply = std::make_shared<redis_reply>(*reply);
+        entry.size = (int64_t)(id.size() + key.size()) + reply_size(*reply) + 64;
+        entry.has_expire = pttl > 0 || option_.max_ttl > 0;
+        if (entry.has_expire){
+            int64_t ttl = pttl > 0 ? pttl : option_.max_ttl;
+            if (option_.max_ttl > 0){
+                ttl = (std::min)(ttl, (int64_t)option_.max_ttl);
+            }
+            entry.expire_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(ttl);
+        }
+        insert_entry(id, entry);
+
+        return reply;
+    }
+
+    /** enable the tracking of the data connection, again after reconnected */
+    bool    ensure_tracking(standalone_sync_client* client){
+        uint64_t epoch = tracking_epoch_;
+        int64_t redirect_id = tracking_redirect_id_;
+        {
+            std::lock_guard<std::mutex> locker(tracking_mtx_);
+            auto iter = tracking_clients_.find(client);
+            if (iter != tracking_clients_.end() &&
+                iter->second.session_id == client->session_id() &&
+                iter->second.epoch == epoch){
+                return true;
+            }
+        }
+
+        redis_command cmd("client");
+        cmd.add_param("tracking");
+        cmd.add_param("on");
+        cmd.add_param("redirect");
+        cmd.add_param(redirect_id);
+        cmd.add_param("optin");
+
+        redis_reply_ptr reply = client->do_command(cmd, -1);
+        if (!reply || !reply->check_status_ok()){
+            rds_log_error("near_cache_sync_client[%p] enable client tracking redirect[%lld] failed.",
+                this, (long long)redirect_id);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> locker(tracking_mtx_);
+        tracking_state& state = tracking_clients_[client];
+        state.session_id = client->session_id();
+        state.epoch = epoch;
+        return true;
+    }
+
+    void    insert_entry(const std::string& id, cache_entry& entry){
+        auto iter = entries_.find(id);
+        if (iter != entries_.end()){
+            erase_entry(iter);
+        }
+
+        if (entry.size > option_.max_memory){
+            return;
+        }
+
+        lru_list_.push_front(id);
+        entry.lru_iter = lru_list_.begin();
+        key_index_[entry.key].push_back(id);
+        memory_ += entry.size;
+        entries_[id] = std::move(entry);
+
+        // evict the least recently used
+        while (memory_ > option_.max_memory && !lru_list_.empty()){
+            erase_entry(entries_.find(lru_list_.back()));
+        }
+    }
+
+    void    erase_entry(std::unordered_map<std::string, cache_entry>::iterator iter){
+        cache_entry& entry = iter->second;
+        memory_ -= entry.size;
+        lru_list_.erase(entry.lru_iter);
+
+        auto index_iter = key_index_.find(entry.key);
+        if (index_iter != key_index_.end()){
+            std::vector<std::string>& ids = index_iter->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), iter->first), ids.end());
+            if (ids.empty()){
+                key_index_.erase(index_iter);
+            }
+        }
+
+        entries_.erase(iter);
+    }
+
+    void    invalidate_key(const std::string& key){
+        std::lock_guard<std::mutex> locker(mtx_);
+
+        auto pending_iter = pending_reads_.find(key);
+        if (pending_iter != pending_reads_.end()){
+            pending_iter->second.invalidated = true;
+        }
+
+        auto index_iter = key_index_.find(key);
+        if (index_iter == key_index_.end()){
+            return;
+        }
+
+        std::vector<std::string> ids;
+        ids.swap(index_iter->second);
+        key_index_.erase(index_iter);
+
+        for (auto& id : ids){
+            auto iter = entries_.find(id);
+            if (iter != entries_.end()){
+                memory_ -= iter->second.size;
+                lru_list_.erase(iter->second.lru_iter);
+                entries_.erase(iter);
+            }
+        }
+    }
+
+    static int64_t reply_size(redis_reply& reply){
+        if (reply.is_string()){
+            return (int64_t)reply.to_string().size() + 32;
+        }
+
+        if (reply.is_array()){
+            int64_t size = 32;
+            for (auto& r : reply.to_array()){
+                size += reply_size(r);
+            }
+            return size;
+        }
+
+        return 32;
+    }
+
+    /** the invalidation message, the key or empty if all the keys invalidated */
+    void    on_invalidate(const std::string& channel, const std::string& key){
+        if (key.empty()){
+            clear();
+        }
+        else{
+            invalidate_key(key);
+        }
+    }
+
+    /** get the client id of the subscribe connection before it subscribed */
+    void    on_subscriber_open(){
+        tracking_redirect_id_ = 0;
+        clear();
+
+        redis_command cmd("client");
+        cmd.add_param("id");
+        subscriber_->do_command(cmd, -1, [this](redis_reply_ptr reply){
+            if (!reply || !reply->is_integer()){
+                rds_log_error("near_cache_sync_client[%p] get client id of the subscribe connection failed.", this);
+                return;
+            }
+
+            // the invalidations before may lost
+            clear();
+            ++tracking_epoch_;
+            tracking_redirect_id_ = reply->to_integer();
+
+            rds_log_info("near_cache_sync_client[%p] client tracking redirect to client[%lld].",
+                this, (long long)reply->to_integer());
+        });
+    }
+};
+}
+}
+
+#endif
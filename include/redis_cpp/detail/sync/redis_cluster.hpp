@@ -37,6 +37,15 @@ public:
         redis_reply_ptr reply = do_command(cmd);
         return reply_util::parser_cluster_slots(reply, map);
     }
+
+    /**
+     * @brief enable the read queries of the connection to the replica
+     */
+    bool    readonly(){
+        redis_command cmd("readonly");
+
+        return check_status_ok(cmd);
+    }
 };
 }
 }
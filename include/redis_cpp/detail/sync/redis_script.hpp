@@ -12,6 +12,7 @@
 
 #include <redis_cpp/detail/config.hpp>
 #include <redis_cpp/detail/redis_command.hpp>
+#include <redis_cpp/detail/redis_cached_script.hpp>
 #include <redis_cpp/detail/sync/redis_command_executor.hpp>
 #include <redis_cpp/internal/logger_handler.hpp>
 #include <vector>
@@ -83,6 +84,48 @@ public:
         return do_command(cmd);
     }
 
+    /**
+    * @brief exculate the cached lua script by evalsha, load the script to the
+    * node and retry if the node reply NOSCRIPT
+    * @param script: the cached lua script
+    * @param keys:   the keys
+    * @param args:   the args
+    * @return redis_reply
+    */
+    redis_reply_ptr eval(const redis_cached_script& script, const std::vector<std::string>& keys, const std::vector<std::string>& args)
+    {
+        redis_reply_ptr reply = evalsha(script.sha1().c_str(), keys, args);
+        if (!reply || !reply->is_error() || 
+            !redis_cached_script::is_noscript_error(reply->to_error().msg)) {
+            return reply;
+        }
+
+        // load to the node of the keys
+        redis_command cmd("script");
+        cmd.add_param("load");
+        cmd.add_param(script.script());
+
+        if (!keys.empty()) {
+            hash_slot(keys[0].c_str());
+        }
+        else {
+            reset_hash_slot();
+        }
+
+        std::string sha1;
+        if (!get_string_result(cmd, sha1)) {
+            rds_log_error("redis_script load script[%s] failed.", script.sha1().c_str());
+            return reply;
+        }
+
+        if (sha1 != script.sha1()) {
+            rds_log_warn("redis_script loaded sha1[%s] differ from local sha1[%s].",
+                sha1.c_str(), script.sha1().c_str());
+        }
+
+        return evalsha(sha1.c_str(), keys, args);
+    }
+
     /** 
      * @brief script load command
      * a. load the script to the cache, but not excuate it
@@ -0,0 +1,306 @@
+﻿/**
+ *
+ * redis_transaction.hpp
+ *
+ * multi/exec transaction on a dedicated connection, with watch
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-16
+ */
+
+#ifndef __ydk_rediscpp_detail_redis_transaction_hpp__
+#define __ydk_rediscpp_detail_redis_transaction_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sync/base_sync_client.hpp>
+#include <redis_cpp/detail/sync/standalone_sync_client.hpp>
+#include <redis_cpp/detail/redis_slot.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** default retry times of the optimistic transaction */
+static const int32_t default_transaction_retry_times = 5;
+
+enum transaction_result{
+    transaction_ok = 0,
+    transaction_aborted,        // the watched keys changed, could retry
+    transaction_failed,         // connection failed or the command rejected
+};
+
+/**
+ * the transaction pins one connection( the connection of the slot's node in
+ * cluster mode) until finished, the commands queued are sent with multi/exec
+ * in one write.
+ * the transaction is also a sync client, so the redis_sync_operator on it do
+ * the command immediately on the pinned connection, used to read the watched
+ * keys before queue the commands.
+ * in cluster mode, all the keys should be in the same slot, and the slot is
+ * from the slot key, the first watched key or the first command done on the
+ * transaction, the transaction without any of them fails( the multi/exec
+ * could not be sent to a random node)
+ */
+class redis_transaction :
+    public base_sync_client
+{
+public:
+    /** return false to discard the transaction */
+    typedef std::function<bool(redis_transaction& trans)> transaction_handler;
+
+protected:
+    base_sync_client*               sync_client_;
+    standalone_sync_client*         client_;
+    int32_t                         hash_slot_;
+    bool                            watching_;
+    bool                            broken_;
+    std::vector<redis_command>      queued_cmds_;
+
+public:
+    /**
+     * @param sync_client - the client( or pool) to get the connection
+     * @param slot_key - the key to choose the node in cluster mode, use the
+     * first watched key if null
+     */
+    redis_transaction(base_sync_client* sync_client, const char* slot_key = nullptr)
+        : sync_client_(sync_client)
+        , client_(nullptr)
+        , hash_slot_(-1)
+        , watching_(false)
+        , broken_(false)
+    {
+        if (slot_key && sync_client_->cluster_mode()){
+            hash_slot_ = redis_slot::slot(slot_key);
+        }
+    }
+
+    ~redis_transaction(){
+        discard();
+    }
+
+public:
+    /**
+     * @brief watch the keys, exec will be aborted if any of them changed
+     * @return false if the connection failed
+     */
+    bool    watch(const std::vector<std::string>& keys){
+        if (keys.empty()){
+            return true;
+        }
+
+        if (hash_slot_ < 0 && sync_client_->cluster_mode()){
+            hash_slot_ = redis_slot::slot(keys[0].c_str());
+        }
+
+        redis_command cmd("watch");
+        for (auto& key : keys){
+            cmd.add_param(key);
+        }
+
+        redis_reply_ptr reply = do_command(cmd, hash_slot_);
+        if (!reply || !reply->check_status_ok()){
+            return false;
+        }
+
+        watching_ = true;
+        return true;
+    }
+
+    /** queue the command, sent when exec */
+    void    queue(const redis_command& cmd){
+        queued_cmds_.push_back(cmd);
+    }
+
+    void    queue(redis_command&& cmd){
+        queued_cmds_.push_back(std::move(cmd));
+    }
+
+    std::size_t queued_count(){
+        return queued_cmds_.size();
+    }
+
+    /**
+     * @brief send multi, the queued commands and exec in one write
+     * @param replies - out, the reply of each queued command if transaction_ok
+     */
+    transaction_result exec(std::vector<redis_reply_ptr>& replies){
+        replies.clear();
+
+        if (broken_){
+            // the connection broken after watch, the watch is lost
+            queued_cmds_.clear();
+            return transaction_failed;
+        }
+
+        if (!acquire()){
+            return transaction_failed;
+        }
+
+        std::vector<redis_command> cmds;
+        cmds.reserve(queued_cmds_.size() + 2);
+        cmds.push_back(redis_command("multi"));
+        for (auto& cmd : queued_cmds_){
+            cmds.push_back(std::move(cmd));
+        }
+        cmds.push_back(redis_command("exec"));
+        queued_cmds_.clear();
+
+        std::vector<redis_reply_ptr> pipeline_replies;
+        if (!client_->do_pipeline(cmds, pipeline_replies)){
+            release(false);
+            return transaction_failed;
+        }
+
+        // exec always unwatch the keys
+        watching_ = false;
+        release(true);
+
+        redis_reply_ptr exec_reply = pipeline_replies.back();
+        if (exec_reply->is_nil()){
+            return transaction_aborted;
+        }
+
+        if (!exec_reply->is_array()){
+            // the first queued error tell why the transaction is rejected
+            for (std::size_t i = 1; i + 1 < pipeline_replies.size(); ++i){
+                if (pipeline_replies[i]->is_error()){
+                    rds_log_error("transaction[%p] command[%d] rejected, error[%s].",
+                        this, (int32_t)i - 1, pipeline_replies[i]->to_error().msg.c_str());
+                    break;
+                }
+            }
+
+            return transaction_failed;
+        }
+
+        redis_reply_arr& arr = exec_reply->to_array();
+        replies.reserve(arr.size());
+        for (auto& r : arr){
+            replies.push_back(std::make_shared<redis_reply>(std::move(r)));
+        }
+
+        return transaction_ok;
+    }
+
+    /** drop the queued commands, unwatch the keys and give back the connection */
+    void    discard(){
+        queued_cmds_.clear();
+
+        if (!client_){
+            return;
+        }
+
+        bool healthy = true;
+        if (watching_){
+            redis_reply_ptr reply = client_->do_command(redis_command("unwatch"), hash_slot_);
+            healthy = reply && reply->check_status_ok();
+            watching_ = false;
+        }
+
+        release(healthy);
+    }
+
+    /**
+     * @brief the optimistic transaction, watch the keys and run the handler
+     * to read and queue the commands, retry if the watched keys changed
+     * @param sync_client - the client( or pool)
+     * @param watch_keys - the watched keys
+     * @param handler - read by the transaction and queue the commands
+     * @param replies - out, the reply of each queued command
+     * @param max_retry_times - retry times if aborted
+     */
+    static transaction_result execute(base_sync_client* sync_client,
+        const std::vector<std::string>& watch_keys,
+        const transaction_handler& handler,
+        std::vector<redis_reply_ptr>& replies,
+        int32_t max_retry_times = default_transaction_retry_times){
+
+        transaction_result result = transaction_aborted;
+        for (int32_t i = 0; i <= max_retry_times; ++i){
+            redis_transaction trans(sync_client);
+            if (!trans.watch(watch_keys)){
+                return transaction_failed;
+            }
+
+            if (!handler(trans)){
+                return transaction_failed;
+            }
+
+            result = trans.exec(replies);
+            if (result != transaction_aborted){
+                return result;
+            }
+        }
+
+        rds_log_warn("transaction aborted after retry [%d] times.", max_retry_times);
+
+        return result;
+    }
+
+public:
+    /** interface **/
+    /** do command immediately on the pinned connection */
+    virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
+    {
+        if (hash_slot_ < 0 && !client_ && sync_client_->cluster_mode()){
+            hash_slot_ = hash_slot;
+        }
+
+        if (!acquire()){
+            return nullptr;
+        }
+
+        redis_reply_ptr reply = client_->do_command(cmd, hash_slot_);
+        if (!reply){
+            // the connection is broken, the watch is lost too
+            broken_ = watching_;
+            watching_ = false;
+            release(false);
+        }
+
+        return reply;
+    }
+
+    /** is cluster mode */
+    virtual bool    cluster_mode() override
+    {
+        return sync_client_->cluster_mode();
+    }
+
+protected:
+    bool    acquire(){
+        if (client_){
+            return true;
+        }
+
+        if (hash_slot_ < 0 && sync_client_->cluster_mode()){
+            rds_log_error("transaction[%p] no key to choose the node in cluster mode.", this);
+            return false;
+        }
+
+        client_ = sync_client_->acquire_client(hash_slot_);
+        if (!client_){
+            rds_log_error("transaction[%p] acquire client of slot[%d] failed.",
+                this, hash_slot_);
+            return false;
+        }
+
+        return true;
+    }
+
+    void    release(bool healthy){
+        if (client_){
+            client_->release(healthy);
+            client_ = nullptr;
+        }
+    }
+};
+}
+}
+
+#endif
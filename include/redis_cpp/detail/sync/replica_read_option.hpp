@@ -0,0 +1,78 @@
+﻿/**
+ *
+ * replica_read_option.hpp
+ *
+ * the option of doing the read commands on the replicas
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-22
+ */
+
+#ifndef __ydk_rediscpp_detail_replica_read_option_hpp__
+#define __ydk_rediscpp_detail_replica_read_option_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/redis_command.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** the replica not used in this time after failed, in milliseconds */
+static const int32_t replica_retry_interval = 5000;
+
+enum replica_read_policy{
+    replica_read_none = 0,              // all the commands on the masters
+    replica_read_round_robin,           // the read commands on the replicas in turn
+    replica_read_lowest_latency,        // the read commands on the replica with the lowest ewma latency
+};
+
+/**
+ * the read commands are done on the replicas( the data may be stale), and
+ * fall back to the master if the replica failed or replied error
+ */
+struct replica_read_option{
+    replica_read_policy                 policy;
+    std::string                         local_zone;     // prefer the replicas in the zone if not empty
+    std::map<std::string, std::string>  node_zones;     // "ip:port" -> the zone of the replica
+    std::unordered_set<std::string>     read_commands;  // the commands( lower case) could be done on the replicas
+
+    replica_read_option()
+        : policy(replica_read_none){
+        const char* commands[] = {
+            "get", "mget", "strlen", "getrange", "getbit", "bitcount", "exists", "ttl", "pttl", "type",
+            "hget", "hmget", "hgetall", "hkeys", "hvals", "hlen", "hexists", "hstrlen", "hscan",
+            "lindex", "llen", "lrange",
+            "scard", "sismember", "smembers", "srandmember", "sscan",
+            "zcard", "zcount", "zrange", "zrangebyscore", "zrank", "zrevrange", "zrevrangebyscore",
+            "zrevrank", "zscore", "zscan",
+        };
+        read_commands.insert(std::begin(commands), std::end(commands));
+    }
+
+    /** could be done on the replicas */
+    bool    is_read_command(const redis_command& cmd) const{
+        const std::vector<std::string>& params = cmd.params();
+        if (params.empty()){
+            return false;
+        }
+
+        std::string name(params[0]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        return read_commands.find(name) != read_commands.end();
+    }
+};
+
+}
+}
+
+#endif
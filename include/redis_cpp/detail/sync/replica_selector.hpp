@@ -0,0 +1,119 @@
+﻿/**
+ *
+ * replica_selector.hpp
+ *
+ * choose the replica for the read command by the replica read option, shared
+ * by the clients reading from the replicas
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-25
+ */
+
+#ifndef __ydk_rediscpp_detail_replica_selector_hpp__
+#define __ydk_rediscpp_detail_replica_selector_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sync/replica_read_option.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** the state of a replica used by the choosing, the connection pool added by the client */
+struct replica_state
+{
+    std::string                 address;
+    std::string                 zone;
+    std::atomic<int64_t>        latency;        // ewma of the command time, in microseconds
+    std::atomic<int64_t>        retry_time;     // not used until then after failed, in milliseconds
+
+    replica_state(){
+        latency = 0;
+        retry_time = 0;
+    }
+
+    /** not used in replica_retry_interval */
+    void    on_failed(){
+        retry_time = now_milliseconds() + replica_retry_interval;
+    }
+
+    /** update the ewma latency by the command started at the start time */
+    void    on_replied(const std::chrono::steady_clock::time_point& start){
+        int64_t cost = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        int64_t old_latency = latency;
+        latency = old_latency == 0 ? cost : old_latency + (cost - old_latency) / 5;
+    }
+
+    static int64_t now_milliseconds(){
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+class replica_selector
+{
+protected:
+    replica_read_policy         policy_;
+    std::string                 local_zone_;
+    std::atomic<uint32_t>       roll_;
+
+public:
+    explicit replica_selector(const replica_read_option& option)
+        : policy_(option.policy)
+        , local_zone_(option.local_zone){
+        roll_ = 0;
+    }
+
+    /**
+     * @brief choose by the policy, prefer the replicas in the local zone, skip
+     * the replicas failed recently
+     * @param nodes - the replicas usable by the client, the node type derived
+     * from replica_state
+     */
+    template<class node_ptr>
+    node_ptr choose(const std::vector<node_ptr>& nodes){
+        int64_t now = replica_state::now_milliseconds();
+        std::vector<node_ptr> candidates;
+        std::vector<node_ptr> zone_candidates;
+        for (auto& node : nodes){
+            if (node->retry_time > now){
+                continue;
+            }
+
+            candidates.push_back(node);
+            if (!local_zone_.empty() && node->zone == local_zone_){
+                zone_candidates.push_back(node);
+            }
+        }
+
+        if (!zone_candidates.empty()){
+            candidates.swap(zone_candidates);
+        }
+
+        if (candidates.empty()){
+            return nullptr;
+        }
+
+        if (policy_ == replica_read_lowest_latency){
+            return *std::min_element(candidates.begin(), candidates.end(),
+                [](const node_ptr& a, const node_ptr& b){
+                return a->latency < b->latency;
+            });
+        }
+
+        return candidates[roll_++ % candidates.size()];
+    }
+};
+
+}
+}
+
+#endif
@@ -13,7 +13,22 @@
 
 #include <redis_cpp/detail/config.hpp>
 #include <redis_cpp/detail/sentinel/sentinel_client_pool.hpp>
+#include <redis_cpp/detail/sentinel/sentinel_failover_option.hpp>
+#include <redis_cpp/detail/sentinel/sentinel_replica_option.hpp>
+#include <redis_cpp/detail/sync/replica_selector.hpp>
 #include <redis_cpp/detail/sync/standalone_sync_client_pool.hpp>
+#include <utility/asio_base/thread_pool.hpp>
+#include <utility/asio_base/timer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 namespace redis_cpp
 {
@@ -24,24 +39,92 @@ class sentinel_sync_client :
     public standalone_sync_client_pool,
     public event_subscriber
 {
+protected:
+    struct replica_node : public replica_state{
+        standalone_sync_client_pool*    pool;
+
+        replica_node() : pool(nullptr){
+        }
+
+        ~replica_node(){
+            delete pool;
+        }
+    };
+    typedef std::shared_ptr<replica_node> replica_node_ptr;
+
 protected:
     sentinel_client_pool_ptr    sentinel_client_pool_;
     std::string                 master_name_;
+    int32_t                     pool_init_size_;
+    int32_t                     pool_max_size_;
+    sentinel_replica_option     replica_option_;
+    utility::asio_base::thread_pool worker_thread_pool_;     // refresh the replicas
+    utility::asio_base::thread_pool switch_thread_pool_;     // switch the master, not blocked by the refresh
+    utility::asio_base::timer::ptr  refresh_replicas_timer_;
+    std::atomic_bool            refresh_pending_;
+    std::mutex                  replica_mtx_;
+    std::map<std::string, replica_node_ptr> replica_node_map_;  // address -> the available replica
+    replica_selector            replica_selector_;
+    sentinel_failover_option    failover_option_;
+    std::mutex                  switch_mtx_;
+    std::condition_variable     switch_cv_;
+    bool                        switching_;
+    std::chrono::steady_clock::time_point switch_deadline_;
+    int64_t                     buffered_bytes_;
+    std::atomic<uint32_t>       switch_seq_;
+
 public:
+    /**
+     * @param replica_option - read from the replicas discovered by the sentinels, disabled by default
+     */
     sentinel_sync_client(
         const char* master_name,
         const char* uri,
         int32_t pool_init_size,
         int32_t pool_max_size,
-        utility::asio_base::thread_pool* thread_pool = nullptr)
+        utility::asio_base::thread_pool* thread_pool = nullptr,
+        const sentinel_replica_option& replica_option = sentinel_replica_option())
         : master_name_(master_name)
         , standalone_sync_client_pool(uri, pool_init_size, pool_max_size, thread_pool)
+        , pool_init_size_(pool_init_size)
+        , pool_max_size_(pool_max_size)
+        , replica_option_(replica_option)
+        , replica_selector_(replica_option)
+        , worker_thread_pool_(1)
+        , switch_thread_pool_(1)
     {
+        refresh_pending_ = false;
+        switching_ = false;
+        buffered_bytes_ = 0;
+        switch_seq_ = 0;
+
+        worker_thread_pool_.start();
+        switch_thread_pool_.start();
+
+        if (replica_option_.policy != replica_read_none){
+            refresh_replicas_timer_ = utility::asio_base::timer::create(worker_thread_pool_.io_service());
+            refresh_replicas_timer_->register_handler(std::bind(
+                &sentinel_sync_client::refresh_replicas_timer_handler,
+                this, std::placeholders::_1, std::placeholders::_2));
+            refresh_replicas_timer_->start(replica_option_.refresh_interval);
+        }
     }
 
     ~sentinel_sync_client()
     {
         set_sentinel_client_pool(nullptr);
+
+        if (replica_option_.policy != replica_read_none){
+            refresh_replicas_timer_->cancel();
+        }
+
+        worker_thread_pool_.stop();
+        worker_thread_pool_.wait_for_stop();
+        switch_thread_pool_.stop();
+        switch_thread_pool_.wait_for_stop();
+
+        std::lock_guard<std::mutex> locker(replica_mtx_);
+        replica_node_map_.clear();
     }
 
 public:
@@ -49,12 +132,18 @@ public:
     {
         if (sentinel_client_pool_){
             sentinel_client_pool_->remove_event_subscriber(event_master_address_change, this);
+            sentinel_client_pool_->remove_event_subscriber(event_replica_state_change, this);
         }
 
         sentinel_client_pool_ = sentinel;
 
         if (sentinel_client_pool_){
             sentinel_client_pool_->add_event_subscriber(event_master_address_change, this);
+
+            if (replica_option_.policy != replica_read_none){
+                sentinel_client_pool_->add_event_subscriber(event_replica_state_change, this);
+                post_refresh_replicas();
+            }
         }
     }
 
@@ -63,6 +152,84 @@ public:
         return sentinel_client_pool_;
     }
 
+    /**
+    * @brief set the failover option, should be set before any command
+    */
+    void    set_failover_option(const sentinel_failover_option& option)
+    {
+        failover_option_ = option;
+    }
+
+    /** is switching to the new master */
+    bool    is_switching()
+    {
+        std::lock_guard<std::mutex> locker(switch_mtx_);
+        return check_switch_deadline();
+    }
+
+    /** the addresses of the replicas which the read commands done on */
+    std::vector<std::string> available_replicas()
+    {
+        std::vector<std::string> addresses;
+
+        std::lock_guard<std::mutex> locker(replica_mtx_);
+        for (auto& iter : replica_node_map_){
+            addresses.push_back(iter.first);
+        }
+
+        return addresses;
+    }
+
+public:
+    /** interface **/
+    /** do command, the read commands on the replicas if enabled */
+    virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
+    {
+        if (replica_option_.policy != replica_read_none && replica_option_.is_read_command(cmd)){
+            redis_reply_ptr reply = do_replica_command(cmd, hash_slot);
+            if (reply){
+                return reply;
+            }
+        }
+
+        uint32_t seq = switch_seq_;
+        if (!wait_for_switch(cmd)){
+            return nullptr;
+        }
+
+        redis_reply_ptr reply = standalone_sync_client_pool::do_command(cmd, hash_slot);
+
+        // failed by the master switch, replay once on the new master
+        if (sentinel_failover_option::is_switch_failure(reply) &&
+            (seq != switch_seq_ || is_switching()) &&
+            failover_option_.is_replay_command(cmd)){
+            rds_log_warn("sentinel_sync_client[%p] master[%s] command[%s] failed by the master switch, replay it.",
+                this, master_name_.c_str(), cmd.params()[0].c_str());
+
+            if (!wait_for_switch(cmd)){
+                return nullptr;
+            }
+
+            reply = standalone_sync_client_pool::do_command(cmd, hash_slot);
+        }
+
+        return reply;
+    }
+
+    /** implement of base_standalone_sync_client_pool */
+    /** the client of the old master not reclaimed */
+    virtual void reclaim_to_pool(standalone_sync_client* client) override
+    {
+        if (client && client->check_address_change(get_uri())){
+            rds_log_info("sentinel_sync_client[%p] master[%s] drop the client[%p] of old master[%s].",
+                this, master_name_.c_str(), client, client->get_uri_string().c_str());
+            remove_client(client);
+            return;
+        }
+
+        standalone_sync_client_pool::reclaim_to_pool(client);
+    }
+
 public:
     /** implements of event_subscriber */
     virtual void on_event(event_num e, void* content) override
@@ -76,7 +243,40 @@ public:
             if (event->master_name != master_name_)
                 return;
 
-            reset_uri_string(event->new_ip, event->new_port);
+            redis_uri old_uri = get_uri();
+            if (old_uri.get_ip() != event->new_ip || old_uri.get_port() != event->new_port){
+                begin_switch();
+                reset_uri_string(event->new_ip, event->new_port);
+
+                switch_thread_pool_.io_service().post([this](){
+                    switch_master();
+                });
+            }
+
+            // the old master may be the replica now
+            if (replica_option_.policy != replica_read_none){
+                post_refresh_replicas();
+            }
+
+            break;
+        }
+        case redis_cpp::detail::event_replica_state_change:
+        {
+            replica_state_change_event_t* event = (replica_state_change_event_t*)content;
+
+            if (event->master_name != master_name_)
+                return;
+
+            // stop reading the replica at once, do not wait the refresh
+            if (event->event_name == "+sdown"){
+                std::stringstream ss;
+                ss << event->ip << ":" << event->port;
+
+                std::lock_guard<std::mutex> locker(replica_mtx_);
+                replica_node_map_.erase(ss.str());
+            }
+
+            post_refresh_replicas();
 
             break;
         }
@@ -112,9 +312,323 @@ protected:
 
         return true;
     }
+
+protected:
+    /** the new commands wait for the new master from now */
+    void    begin_switch(){
+        if (failover_option_.buffer_time <= 0){
+            return;
+        }
+
+        std::lock_guard<std::mutex> locker(switch_mtx_);
+        switching_ = true;
+        switch_deadline_ = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(failover_option_.buffer_time);
+        ++switch_seq_;
+    }
+
+    void    end_switch(){
+        {
+            std::lock_guard<std::mutex> locker(switch_mtx_);
+            switching_ = false;
+        }
+        switch_cv_.notify_all();
+    }
+
+    /**
+     * @brief wait until connected to the new master while switching, the buffer
+     * window ends at the switch deadline, then the commands go to the pool as usual
+     * though the switch not done
+     * @return false if the buffer full
+     */
+    bool    wait_for_switch(const redis_command& cmd){
+        std::unique_lock<std::mutex> locker(switch_mtx_);
+        if (!check_switch_deadline()){
+            return true;
+        }
+
+        int64_t bytes = sentinel_failover_option::command_bytes(cmd);
+        if (buffered_bytes_ + bytes > failover_option_.buffer_bytes){
+            rds_log_error("sentinel_sync_client[%p] master[%s] switching, buffered bytes[%lld] full, command failed.",
+                this, master_name_.c_str(), (long long)buffered_bytes_);
+            return false;
+        }
+
+        buffered_bytes_ += bytes;
+        switch_cv_.wait_until(locker, switch_deadline_, [this](){ return !switching_; });
+        buffered_bytes_ -= bytes;
+
+        check_switch_deadline();
+        return true;
+    }
+
+    /**
+     * @brief the switching not ended before the deadline, stop buffering, the
+     * switch thread goes on connecting to the new master
+     * @return still switching
+     * @note call with switch_mtx_ locked
+     */
+    bool    check_switch_deadline(){
+        if (switching_ && std::chrono::steady_clock::now() >= switch_deadline_){
+            rds_log_warn("sentinel_sync_client[%p] master[%s] not switched in the buffer time, stop buffering.",
+                this, master_name_.c_str());
+            switching_ = false;
+            switch_cv_.notify_all();
+        }
+
+        return switching_;
+    }
+
+    /**
+     * @brief drop the idle clients of the old master, connect to the new master
+     * until the switch deadline, in the switch thread
+     */
+    void    switch_master(){
+        redis_uri uri = get_uri();
+
+        // the stale ones freed when reclaimed
+        std::vector<standalone_sync_client*> clients;
+        {
+            std::lock_guard<std::mutex> locker(list_mtx_);
+            while (!free_sync_client_queue_.empty()){
+                clients.push_back(free_sync_client_queue_.front());
+                free_sync_client_queue_.pop();
+            }
+        }
+        for (auto client : clients){
+            reclaim_to_pool(client);
+        }
+
+        for (;;){
+            // connect every failover_reconnect_interval, not wait the backoff and the breaker
+            standalone_sync_client* client = try_allocate_a_client(true);
+            if (client){
+                bool connected = !client->check_address_change(uri);
+                reclaim_to_pool(client);
+
+                if (connected){
+                    rds_log_info("sentinel_sync_client[%p] master[%s] connected to the new master[%s].",
+                        this, master_name_.c_str(), uri.to_string().c_str());
+                    break;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> locker(switch_mtx_);
+                if (!switching_ || std::chrono::steady_clock::now() >= switch_deadline_){
+                    break;
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(failover_reconnect_interval));
+        }
+
+        ensure_min_client_count();
+        end_switch();
+    }
+
+    void    refresh_replicas_timer_handler(utility::asio_base::timer::ptr timer_ptr,
+        const asio::error_code& error){
+        if (!error){
+            refresh_replicas();
+
+            timer_ptr->start(replica_option_.refresh_interval);
+        }
+        else{
+            rds_log_error("sentinel_sync_client[%p] refresh_replicas_timer error, %s:%d.",
+                this, error.message().c_str(), error.value());
+        }
+    }
+
+    /**
+     * @brief refresh in the refresh thread, the events published in the thread of
+     * the sentinel client which the blocking query needs, the events in a burst
+     * refresh once
+     */
+    void    post_refresh_replicas(){
+        if (refresh_pending_.exchange(true)){
+            return;
+        }
+
+        worker_thread_pool_.io_service().post([this](){
+            refresh_pending_ = false;
+            refresh_replicas();
+        });
+    }
+
+    /**
+     * @brief query the replicas from the sentinels, keep the available ones
+     */
+    void    refresh_replicas(){
+        sentinel_client_pool_ptr sentinel = sentinel_client_pool_;
+        if (!sentinel){
+            return;
+        }
+
+        std::vector<sentinel_replica_info> replicas;
+        if (!sentinel->get_replicas_by_name(master_name_.c_str(), replicas)){
+            rds_log_error("sentinel_sync_client[%p] master[%s] get replicas failed.",
+                this, master_name_.c_str());
+            return;
+        }
+
+        std::map<std::string, replica_node_ptr> node_map;
+        {
+            std::lock_guard<std::mutex> locker(replica_mtx_);
+            node_map = replica_node_map_;
+        }
+
+        // read before the replicas, the max offset of the replicas if the master not replied,
+        // not read while switching, the old master may be frozen
+        int64_t master_offset = 0;
+        bool master_replied = !is_switching() &&
+            read_repl_offset(this, "master_repl_offset", master_offset);
+
+        std::vector<std::pair<replica_node_ptr, int64_t>> candidates;
+        for (auto& replica : replicas){
+            std::stringstream ss;
+            ss << replica.ip << ":" << replica.port;
+            std::string address(std::move(ss.str()));
+
+            if (!replica_option_.is_linked(replica)){
+                rds_log_warn("sentinel_sync_client[%p] master[%s] replica[%s] excluded, flags[%s] link_down_time[%lld].",
+                    this, master_name_.c_str(), address.c_str(), replica.flags.c_str(),
+                    (long long)replica.master_link_down_time);
+                continue;
+            }
+
+            replica_node_ptr node;
+            auto iter = node_map.find(address);
+            if (iter != node_map.end()){
+                node = iter->second;
+            }
+            else{
+                node = create_replica_node(replica, address);
+            }
+
+            int64_t offset = 0;
+            if (!read_repl_offset(node->pool, "slave_repl_offset", offset)){
+                rds_log_warn("sentinel_sync_client[%p] master[%s] replica[%s] excluded, read the offset failed.",
+                    this, master_name_.c_str(), address.c_str());
+                continue;
+            }
+
+            candidates.push_back(std::make_pair(node, offset));
+        }
+
+        if (!master_replied){
+            for (auto& candidate : candidates){
+                master_offset = std::max(master_offset, candidate.second);
+            }
+        }
+
+        std::map<std::string, replica_node_ptr> available_map;
+        for (auto& candidate : candidates){
+            replica_node_ptr& node = candidate.first;
+            if (!replica_option_.is_lag_acceptable(master_offset, candidate.second)){
+                rds_log_warn("sentinel_sync_client[%p] master[%s] replica[%s] excluded, lag[%lld].",
+                    this, master_name_.c_str(), node->address.c_str(),
+                    (long long)(master_offset - candidate.second));
+                continue;
+            }
+
+            available_map[node->address] = node;
+        }
+
+        // the pools of the removed replicas freed after the commands on them done
+        std::lock_guard<std::mutex> locker(replica_mtx_);
+        replica_node_map_.swap(available_map);
+    }
+
+    replica_node_ptr create_replica_node(const sentinel_replica_info& replica, const std::string& address){
+        // the same password and db as the master
+        redis_uri uri = get_uri();
+        uri.set_ip(replica.ip.c_str());
+        uri.set_port(replica.port);
+
+        replica_node_ptr node = std::make_shared<replica_node>();
+        node->address = address;
+        node->pool = new standalone_sync_client_pool(uri.to_string().c_str(),
+            pool_init_size_, pool_max_size_, thread_pool_, true);
+
+        auto zone = replica_option_.node_zones.find(address);
+        if (zone != replica_option_.node_zones.end()){
+            node->zone = zone->second;
+        }
+
+        rds_log_info("sentinel_sync_client[%p] master[%s] add replica pool of address[%s] zone[%s].",
+            this, master_name_.c_str(), address.c_str(), node->zone.c_str());
+
+        return node;
+    }
+
+    /**
+     * @brief read the replication offset by "info replication", the master's
+     * command not done by the replicas
+     */
+    bool    read_repl_offset(standalone_sync_client_pool* pool, const char* field, int64_t& offset){
+        redis_command cmd("info");
+        cmd.add_param("replication");
+        redis_reply_ptr reply = pool->standalone_sync_client_pool::do_command(cmd, -1);
+        if (!reply || !reply->is_string()){
+            return false;
+        }
+
+        return sentinel_replica_option::parse_repl_offset(reply->to_string(), field, offset);
+    }
+
+    /** choose from the available replicas by the policy */
+    replica_node_ptr choose_replica(){
+        std::vector<replica_node_ptr> nodes;
+        {
+            std::lock_guard<std::mutex> locker(replica_mtx_);
+            for (auto& iter : replica_node_map_){
+                nodes.push_back(iter.second);
+            }
+        }
+
+        return replica_selector_.choose(nodes);
+    }
+
+    /**
+     * @brief do the command on the replica
+     * @return nullptr if failed or replied error, then done by the master
+     */
+    redis_reply_ptr do_replica_command(const redis_command& cmd, int32_t hash_slot){
+        replica_node_ptr replica = choose_replica();
+        if (!replica){
+            return nullptr;
+        }
+
+        standalone_sync_client* client = replica->pool->get_client();
+        if (!client){
+            replica->on_failed();
+            return nullptr;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        redis_reply_ptr reply = client->do_command(cmd, hash_slot);
+        if (!reply){
+            client->free();
+            replica->on_failed();
+            rds_log_warn("sentinel_sync_client[%p] replica[%s] command failed, fall back to the master.",
+                this, replica->address.c_str());
+            return nullptr;
+        }
+        client->close();
+
+        // like loading, the master would reply the command error too
+        if (reply->is_error()){
+            return nullptr;
+        }
+
+        replica->on_replied(start);
+
+        return reply;
+    }
 };
 
 }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,278 @@
+﻿/**
+ *
+ * sharded_sync_client.hpp
+ *
+ * the keys are distributed to several independent redis masters by the
+ * consistent hash( ketama) on client side, without redis cluster
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-21
+ */
+
+#ifndef __ydk_rediscpp_detail_sharded_sync_client_hpp__
+#define __ydk_rediscpp_detail_sharded_sync_client_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sync/base_sync_client.hpp>
+#include <redis_cpp/detail/sync/standalone_sync_client_pool.hpp>
+#include <redis_cpp/detail/redis_slot.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <redis_cpp/redis_uri.hpp>
+#include <utility/asio_base/thread_pool.hpp>
+#include <utility/codec/sha1.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** the points on the hash ring of the node with weight 1 */
+static const int32_t sharded_node_points = 160;
+
+struct sharded_node
+{
+    std::string     uri;        // like "redis://foobared@127.0.0.1:6379/0"
+    int32_t         weight;     // the share of the keys is in proportion to it
+
+    sharded_node(const std::string& u, int32_t w = 1)
+        : uri(u)
+        , weight(w){
+    }
+};
+
+/**
+ * the client is in cluster mode, so the operators pass the hash slot( crc16
+ * of the key or the hash tag) of the key, and the slot is routed to the node
+ * by the ketama ring, the keys with the same hash tag are on the same node.
+ * the node of a slot changes only if the node added or removed near it on
+ * the ring, not depends on the order of the nodes.
+ * the multi-key commands without hash slot( mget, mset, del, exists, unlink,
+ * touch) are split by node and the replies merged, the other commands without
+ * hash slot are done on the first node
+ */
+class sharded_sync_client :
+    public base_sync_client
+{
+protected:
+    utility::asio_base::thread_pool             thread_pool_;
+    std::vector<standalone_sync_client_pool*>   pools_;
+    std::vector<int32_t>                        slot_nodes_;    // hash slot -> the index of the pool
+
+public:
+    /**
+     * @param nodes - the independent masters
+     * @param pool_init_size - the initialize pool size of each node
+     * @param pool_max_size - the max pool size of each node
+     */
+    sharded_sync_client(const std::vector<sharded_node>& nodes,
+        int32_t pool_init_size,
+        int32_t pool_max_size)
+        : thread_pool_(1)
+    {
+        thread_pool_.start();
+
+        for (auto& node : nodes){
+            pools_.push_back(new standalone_sync_client_pool(node.uri.c_str(),
+                pool_init_size, pool_max_size, &thread_pool_));
+        }
+
+        build_slot_nodes(nodes);
+    }
+
+    ~sharded_sync_client(){
+        thread_pool_.stop();
+        thread_pool_.wait_for_stop();
+
+        for (auto pool : pools_){
+            delete pool;
+        }
+        pools_.clear();
+    }
+
+public:
+    /** the index of the node which the key located at */
+    int32_t node_index(const std::string& key){
+        if (pools_.empty()){
+            return -1;
+        }
+
+        return slot_nodes_[redis_slot::slot(key.data(), (int32_t)key.size())];
+    }
+
+    std::size_t node_count(){
+        return pools_.size();
+    }
+
+public:
+    /** interface **/
+    /** do command */
+    virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
+    {
+        if (pools_.empty()){
+            rds_log_error("sharded_sync_client[%p] no node.", this);
+            return nullptr;
+        }
+
+        if (hash_slot >= 0){
+            return pools_[slot_nodes_[hash_slot]]->do_command(cmd, hash_slot);
+        }
+
+        return do_multi_key_command(cmd);
+    }
+
+    /** is cluster mode, so the hash slot of the key passed */
+    virtual bool    cluster_mode() override
+    {
+        return true;
+    }
+
+    /** get a client of the node which the slot located at */
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot) override
+    {
+        if (pools_.empty()){
+            return nullptr;
+        }
+
+        return pools_[hash_slot >= 0 ? slot_nodes_[hash_slot] : 0]->get_client();
+    }
+
+protected:
+    /** the ketama ring, every slot located at the first point after its hash */
+    void    build_slot_nodes(const std::vector<sharded_node>& nodes){
+        slot_nodes_.assign(redis_slot::max_hash_slot, 0);
+        if (nodes.empty()){
+            return;
+        }
+
+        std::vector<std::pair<uint32_t, int32_t>> ring;
+        for (std::size_t i = 0; i < nodes.size(); ++i){
+            redis_uri uri(nodes[i].uri.c_str());
+            std::string name = uri.get_ip() + ":" + std::to_string(uri.get_port());
+
+            // 4 points from each digest
+            int32_t digests = sharded_node_points / 4 * std::max<int32_t>(nodes[i].weight, 1);
+            for (int32_t j = 0; j < digests; ++j){
+                std::string point_key = name + "-" + std::to_string(j);
+                unsigned char digest[20];
+                utility::codec::sha1(point_key.data(), point_key.size(), digest);
+                for (int32_t k = 0; k < 4; ++k){
+                    ring.push_back(std::make_pair(read_point(digest + k * 4), (int32_t)i));
+                }
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+
+        for (int32_t slot = 0; slot < redis_slot::max_hash_slot; ++slot){
+            std::string slot_key = std::to_string(slot);
+            unsigned char digest[20];
+            utility::codec::sha1(slot_key.data(), slot_key.size(), digest);
+
+            auto iter = std::lower_bound(ring.begin(), ring.end(),
+                std::make_pair(read_point(digest), (int32_t)-1));
+            if (iter == ring.end()){
+                iter = ring.begin();
+            }
+            slot_nodes_[slot] = iter->second;
+        }
+    }
+
+    static uint32_t read_point(const unsigned char* p){
+        return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[0];
+    }
+
+    /** split the multi-key command by node, merge the replies */
+    redis_reply_ptr do_multi_key_command(const redis_command& cmd){
+        const std::vector<std::string>& params = cmd.params();
+        if (params.size() < 2 || pools_.size() == 1){
+            return pools_[0]->do_command(cmd, -1);
+        }
+
+        std::string name(params[0]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        // the params of each key
+        std::size_t step = 0;
+        if (name == "mget" || name == "del" || name == "exists" ||
+            name == "unlink" || name == "touch"){
+            step = 1;
+        }
+        else if (name == "mset"){
+            step = 2;
+        }
+        else{
+            return pools_[0]->do_command(cmd, -1);
+        }
+
+        // node -> the sub command and the index of its keys in the command
+        std::map<int32_t, std::pair<redis_command, std::vector<std::size_t>>> splits;
+        for (std::size_t i = 1; i + step <= params.size(); i += step){
+            auto& split = splits[node_index(params[i])];
+            if (split.second.empty()){
+                split.first = redis_command(params[0]);
+            }
+
+            for (std::size_t j = 0; j < step; ++j){
+                split.first.add_param(params[i + j]);
+            }
+            split.second.push_back((i - 1) / step);
+        }
+
+        if (splits.size() == 1){
+            return pools_[splits.begin()->first]->do_command(cmd, -1);
+        }
+
+        redis_reply_arr values;
+        if (name == "mget"){
+            values.resize((params.size() - 1) / step);
+        }
+
+        int64_t count = 0;
+        redis_reply_ptr status_reply;
+        for (auto& iter : splits){
+            redis_reply_ptr reply = pools_[iter.first]->do_command(iter.second.first, -1);
+            if (!reply || reply->is_error()){
+                // the other nodes may be done already
+                rds_log_error("sharded_sync_client[%p] command[%s] failed on node[%s].",
+                    this, name.c_str(), pools_[iter.first]->uri_string().c_str());
+                return reply;
+            }
+
+            if (name == "mget"){
+                if (!reply->is_array() || reply->to_array().size() != iter.second.second.size()){
+                    return nullptr;
+                }
+
+                redis_reply_arr& arr = reply->to_array();
+                for (std::size_t i = 0; i < arr.size(); ++i){
+                    values[iter.second.second[i]] = std::move(arr[i]);
+                }
+            }
+            else if (name == "mset"){
+                status_reply = reply;
+            }
+            else if (reply->is_integer()){
+                count += reply->to_integer();
+            }
+        }
+
+        if (name == "mget"){
+            return std::make_shared<redis_reply>(std::move(values));
+        }
+
+        if (name == "mset"){
+            return status_reply;
+        }
+
+        return std::make_shared<redis_reply>(count);
+    }
+};
+}
+}
+
+#endif
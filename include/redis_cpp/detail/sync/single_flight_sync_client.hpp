@@ -0,0 +1,136 @@
+﻿/**
+ *
+ * single_flight_sync_client.hpp
+ *
+ * the identical concurrent read commands are coalesced, only the first one
+ * is sent, the others share its reply
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-19
+ */
+
+#ifndef __ydk_rediscpp_detail_single_flight_sync_client_hpp__
+#define __ydk_rediscpp_detail_single_flight_sync_client_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/detail/sync/base_sync_client.hpp>
+#include <redis_cpp/detail/sync/sync_reply_waiter.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/**
+ * wraps a sync client( like standalone_sync_client_pool or cluster_sync_client),
+ * the commands enabled( by the command name) with the same encoded bytes in
+ * flight at the same time are done only once, the callers come later wait
+ * for the reply of the first one. only the read commands should be enabled
+ */
+class single_flight_sync_client :
+    public base_sync_client
+{
+protected:
+    base_sync_client*                                       sync_client_;
+    std::unordered_set<std::string>                         commands_;
+    std::mutex                                              mtx_;
+    std::unordered_map<std::string, sync_reply_waiter_ptr>  flights_;   // encoded command -> the first caller
+    std::atomic<int64_t>                                    shared_count_;
+
+public:
+    /**
+     * @param sync_client - the client to do the commands
+     * @param commands - the commands coalesced( lower case), like "get", "hgetall"
+     */
+    single_flight_sync_client(base_sync_client* sync_client,
+        const std::vector<std::string>& commands)
+        : sync_client_(sync_client)
+        , commands_(commands.begin(), commands.end())
+    {
+        shared_count_ = 0;
+    }
+
+    virtual ~single_flight_sync_client(){
+    }
+
+    /** the count of the callers shared the reply of others */
+    int64_t shared_count(){
+        return shared_count_;
+    }
+
+public:
+    /** interface **/
+    /** do command */
+    virtual redis_reply_ptr do_command(const redis_command& cmd, int32_t hash_slot) override
+    {
+        if (!is_coalesced(cmd)){
+            return sync_client_->do_command(cmd, hash_slot);
+        }
+
+        std::string id(std::move(cmd.to_string()));
+        sync_reply_waiter_ptr waiter;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            sync_reply_waiter_ptr& flight = flights_[id];
+            if (!flight){
+                flight = std::make_shared<sync_reply_waiter>();
+                leader = true;
+            }
+            waiter = flight;
+        }
+
+        if (!leader){
+            ++shared_count_;
+            waiter->wait(0);
+
+            // the reply is shared, each caller get a copy
+            redis_reply_ptr reply = waiter->reply();
+            return reply ? std::make_shared<redis_reply>(*reply) : nullptr;
+        }
+
+        redis_reply_ptr reply = sync_client_->do_command(cmd, hash_slot);
+        {
+            // the callers come after the reply got send the command again
+            std::lock_guard<std::mutex> locker(mtx_);
+            flights_.erase(id);
+        }
+
+        waiter->set_reply(reply ? std::make_shared<redis_reply>(*reply) : nullptr);
+        return reply;
+    }
+
+    /** is cluster mode */
+    virtual bool    cluster_mode() override
+    {
+        return sync_client_->cluster_mode();
+    }
+
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot) override
+    {
+        return sync_client_->acquire_client(hash_slot);
+    }
+
+protected:
+    bool    is_coalesced(const redis_command& cmd){
+        const std::vector<std::string>& params = cmd.params();
+        if (params.empty()){
+            return false;
+        }
+
+        std::string name(params[0]);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        return commands_.find(name) != commands_.end();
+    }
+};
+}
+}
+
+#endif
@@ -21,6 +21,8 @@
 #include <redis_cpp/detail/redis_buffer.hpp>
 #include <redis_cpp/internal/logger_handler.hpp>
 #include <redis_cpp/redis_uri.hpp>
+#include <vector>
+#include <atomic>
 
 namespace redis_cpp
 {
@@ -40,6 +42,8 @@ protected:
     redis_uri                           uri_;
     base_standalone_sync_client_pool*   client_pool_;
     bool                                cluster_enabled_;
+    bool                                readonly_;
+    uint64_t                            session_id_;
 
 public:
     /** 
@@ -54,6 +58,8 @@ public:
         : uri_(uri)
         , client_pool_(pool)
         , cluster_enabled_(false)
+        , readonly_(false)
+        , session_id_(0)
     {
         remote_endpoint_ = 
             new asio::ip::tcp::endpoint(
@@ -89,38 +95,54 @@ public:
             return nullptr;
         }
 
-        for (;;){
-            int32_t size = connection_->read();
+        return read_reply();
+    }
 
-            if (size < 0){
-                return nullptr;
-            }
+    /** is cluster mode */
+    virtual bool         cluster_mode() override
+    {
+        return false;
+    }
 
-            parser_.push_bytes(connection_->get_receive_buffer(), size);
-            parse_result result = parser_.parse();
+    /** the client itself is a dedicated connection */
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot) override
+    {
+        return this;
+    }
 
-            if (result == redis_ok){
-                return parser_.transfer_reply();
-            }
-            else if (result == redis_incomplete){
-                // wait for remain content
-            }
-            else if (result == redis_error){
-                // error 
+public:
+    /**
+     * @brief send the commands in one write, then read the replies in order
+     * @param cmds - the commands
+     * @param replies - out, one reply for each command
+     * @return false if the connection failed
+     */
+    bool do_pipeline(const std::vector<redis_command>& cmds,
+        std::vector<redis_reply_ptr>& replies){
+        std::string str;
+        for (auto& cmd : cmds){
+            cmd.encode(str);
+        }
 
-                error_handler("paser redis content failed");
+        asio::error_code ec;
+        connection_->write(str, ec);
 
-                return nullptr;
-            }
+        if (ec){
+            error_handler(ec.message().c_str());
+            return false;
         }
 
-        return nullptr;
-    }
+        replies.clear();
+        replies.reserve(cmds.size());
+        for (std::size_t i = 0; i < cmds.size(); ++i){
+            redis_reply_ptr reply = read_reply();
+            if (!reply){
+                return false;
+            }
+            replies.push_back(reply);
+        }
 
-    /** is cluster mode */
-    virtual bool         cluster_mode() override
-    {
-        return false;
+        return true;
     }
 
 public:
@@ -133,6 +155,8 @@ public:
         if (!connection_->connect(*remote_endpoint_))
             return false;
 
+        session_id_ = next_session_id();
+
         redis_sync_operator redis_op(this);
 
         // auth
@@ -145,9 +169,30 @@ public:
             redis_op.select(uri_.get_dbnum());
         }
 
+        // the connection to the cluster replica
+        if (readonly_ && !redis_op.readonly()){
+            rds_log_error("sync_client[%p] uri[%s] readonly failed.",
+                this, uri_.to_string().c_str());
+            connection_->close();
+            return false;
+        }
+
         return true;
     }
 
+    /** send readonly after connected, should be set before connect */
+    void set_readonly(bool readonly){
+        readonly_ = readonly;
+    }
+
+    /** 
+     * @brief the unique id of the connection session, changed after reconnect,
+     * used to check the connection state( like client tracking) still valid
+     */
+    uint64_t session_id(){
+        return session_id_;
+    }
+
     /** check the connection is connected */
     bool is_connected(){
         return connection_->is_connected();
@@ -170,6 +215,23 @@ public:
         }
     }
 
+    /**
+     * @brief give back the client got by acquire_client
+     * @param healthy - false if the connection is broken or in unknown state
+     */
+    void release(bool healthy){
+        if (!client_pool_){
+            return;
+        }
+
+        if (healthy){
+            close();
+        }
+        else{
+            free();
+        }
+    }
+
     /** destroy the client */
     void destroy(){
         delete this;
@@ -187,6 +249,41 @@ public:
 
 protected:
 
+    static uint64_t next_session_id(){
+        static std::atomic<uint64_t> session_id(0);
+        return ++session_id;
+    }
+
+    /** read one reply */
+    redis_reply_ptr read_reply(){
+        for (;;){
+            // the pipelined replies may be already in the parser
+            parse_result result = parser_.parse();
+
+            if (result == redis_ok){
+                return parser_.transfer_reply();
+            }
+            else if (result == redis_error){
+                // error 
+
+                error_handler("paser redis content failed");
+
+                return nullptr;
+            }
+
+            // wait for remain content
+            int32_t size = connection_->read();
+
+            if (size < 0){
+                return nullptr;
+            }
+
+            parser_.push_bytes(connection_->get_receive_buffer(), size);
+        }
+
+        return nullptr;
+    }
+
     void error_handler(const char* error){
 
         rds_log_error("standalone sync client error[%s].", error);
@@ -15,8 +15,10 @@
 #include <redis_cpp/detail/config.hpp>
 #include <redis_cpp/detail/sync/standalone_sync_client.hpp>
 #include <redis_cpp/detail/sync/base_standalone_sync_client_pool.hpp>
+#include <redis_cpp/detail/circuit_breaker.hpp>
 #include <utility/asio_base/thread_pool.hpp>
 #include <utility/asio_base/timer.hpp>
+#include <chrono>
 #include <queue>
 #include <vector>
 #include <mutex>
@@ -32,6 +34,10 @@ static const int32_t check_sync_client_valid_interval = 5000;
 /** auto extand pool max size uplimit */
 static const int32_t auto_extand_pool_size_uplimit = 25;
 
+/** the first delay in milliseconds to connect again after the connect failed,
+ doubled after each failure up to check_sync_client_valid_interval */
+static const int32_t sync_reconnect_min_interval = 100;
+
 class standalone_sync_client_pool : 
     public base_standalone_sync_client_pool,
     public base_sync_client
@@ -47,15 +53,22 @@ protected:
     int32_t                              pool_min_size_;
     redis_uri                            redis_uri_;
     bool                                 auto_extand_pool_max_size_;
+    bool                                 readonly_;
     std::mutex                           uri_mtx_;
+    circuit_breaker                      breaker_;
+    int32_t                              connect_failures_;  // connect failed in a row
+    int64_t                              next_connect_time_; // no connect until then, in milliseconds
+    int32_t                              connecting_count_;  // the clients connecting out of the lock
 
 public:
     standalone_sync_client_pool(
         const char* uri, 
         int32_t pool_init_size,
         int32_t pool_max_size,
-        utility::asio_base::thread_pool* thread_pool = nullptr) 
-            : redis_uri_(uri), auto_extand_pool_max_size_(true){
+        utility::asio_base::thread_pool* thread_pool = nullptr,
+        bool readonly = false) 
+            : redis_uri_(uri), auto_extand_pool_max_size_(true), readonly_(readonly)
+            , connect_failures_(0), next_connect_time_(0), connecting_count_(0){
         if (thread_pool){
             thread_pool_ = thread_pool;
             thread_pool_self_maintain_ = false;
@@ -119,15 +132,23 @@ public:
     }
 
     void        reset_uri_string(const std::string& ip, int32_t port){
-        std::lock_guard<std::mutex> locker(uri_mtx_);
+        {
+            std::lock_guard<std::mutex> locker(uri_mtx_);
 
-        std::string old_uri = redis_uri_.to_string();
-        redis_uri_.set_ip(ip.c_str());
-        redis_uri_.set_port(port);
-        std::string new_uri = redis_uri_.to_string();
+            std::string old_uri = redis_uri_.to_string();
+            redis_uri_.set_ip(ip.c_str());
+            redis_uri_.set_port(port);
+            std::string new_uri = redis_uri_.to_string();
 
-        rds_log_info("standalone_sync_client_pool[%p] uri[%s] change to uri[%s].",
-            this, old_uri.c_str(), new_uri.c_str());
+            rds_log_info("standalone_sync_client_pool[%p] uri[%s] change to uri[%s].",
+                this, old_uri.c_str(), new_uri.c_str());
+        }
+
+        // the failures of the old node
+        breaker_.reset();
+        std::lock_guard<std::mutex> locker(list_mtx_);
+        connect_failures_ = 0;
+        next_connect_time_ = 0;
     }
 
     bool empty(){
@@ -135,6 +156,18 @@ public:
         return total_sync_client_list_.empty();
     }
 
+    /**
+     * @brief the commands fail at once while the node failed too many, should be
+     * set before any command
+     */
+    void    set_circuit_breaker_option(const circuit_breaker_option& option){
+        breaker_.set_option(option);
+    }
+
+    circuit_state breaker_state(){
+        return breaker_.state();
+    }
+
 public:
 
     /** implement of base_sync_client* /
@@ -143,8 +176,11 @@ public:
     {
         standalone_sync_client* client = get_client();
         if (!client){
-            rds_log_error("pool[%p] can't find available client to do cmd, uri[%s].", 
-                this, uri_string().c_str());
+            // the breaker logged when opened
+            if (breaker_.state() == circuit_closed){
+                rds_log_error("pool[%p] can't find available client to do cmd, uri[%s].", 
+                    this, uri_string().c_str());
+            }
             return nullptr;
         }
 
@@ -165,6 +201,12 @@ public:
         return false;
     }
 
+    /** get a client from the pool */
+    virtual standalone_sync_client* acquire_client(int32_t hash_slot) override
+    {
+        return get_client();
+    }
+
     /** implement of base_standalone_sync_client_pool */
     /** interfaces */
 
@@ -174,6 +216,8 @@ public:
         if (!client)
             return;
 
+        breaker_.on_success();
+
         std::lock_guard<std::mutex> locker(list_mtx_);
 
         // todo, check the client vaild
@@ -188,6 +232,33 @@ public:
         if (!client)
             return;
 
+        breaker_.on_failure();
+        remove_client(client);
+    }
+
+    /** get a client from the pool, nullptr at once while the breaker open */
+    standalone_sync_client* get_client(){
+        if (!breaker_.allow_request()){
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> locker(list_mtx_);
+
+            if (!free_sync_client_queue_.empty()){
+                standalone_sync_client* client = free_sync_client_queue_.front();
+                free_sync_client_queue_.pop();
+                return client;
+            }
+        }
+
+        // connect out of the lock, the callers with the free clients not wait for it
+        return try_allocate_a_client();
+    }
+
+protected:
+    /** remove and free the client from pool, not a failure of the node */
+    void    remove_client(standalone_sync_client* client){
         // try remove the client from this pool
         {
             std::lock_guard<std::mutex> locker(list_mtx_);
@@ -209,24 +280,6 @@ public:
         client->destroy();
     }
 
-    /** get a client from the pool */
-    standalone_sync_client* get_client(){
-        std::lock_guard<std::mutex> locker(list_mtx_);
-
-        if (free_sync_client_queue_.empty()){
-            try_allocate_a_client();
-        }
-
-        if (free_sync_client_queue_.empty()){
-            return nullptr;
-        }
-
-        standalone_sync_client* client = free_sync_client_queue_.front();
-        free_sync_client_queue_.pop();
-        return client;
-    }
-
-protected:
 
     /** 
      * @brief check_client_available_one_time
@@ -287,8 +340,13 @@ protected:
 
         int32_t to_increase_count = pool_min_size_ - current_total_count;
         for (int32_t i = 0; i < to_increase_count; ++i){
+            standalone_sync_client* client = try_allocate_a_client();
+            if (!client){
+                break;
+            }
+
             std::lock_guard<std::mutex> locker(list_mtx_);
-            try_allocate_a_client();
+            free_sync_client_queue_.push(client);
         }
     }
 
@@ -319,7 +377,13 @@ protected:
             this, pool_min_size_, pool_max_size_);
 
         for (int32_t i = 0; i < pool_min_size_; ++i){
-            try_allocate_a_client();
+            standalone_sync_client* client = try_allocate_a_client();
+            if (!client){
+                break;
+            }
+
+            std::lock_guard<std::mutex> locker(list_mtx_);
+            free_sync_client_queue_.push(client);
         }
 
         rds_log_info("pool[%p] init finished, cur[%d] free[%d] max[%d], uri[%s].",
@@ -328,39 +392,83 @@ protected:
             pool_max_size_, uri_string().c_str());
     }
 
-    void    try_allocate_a_client(){
+    /**
+     * @brief connect a new client out of the lock, the slot is reserved while connecting
+     * @param force - connect even in the backoff, and the failure not counted by the
+     * breaker( like connect to the new master while switching)
+     * @return the new client not in the free queue, nullptr if the pool full or failed
+     */
+    standalone_sync_client* try_allocate_a_client(bool force = false){
+        {
+            std::lock_guard<std::mutex> locker(list_mtx_);
+
+            int32_t current_count = (int32_t)total_sync_client_list_.size() + connecting_count_;
+            if (current_count >= pool_max_size_ &&
+                auto_extand_pool_max_size_ &&
+                pool_max_size_ < auto_extand_pool_size_uplimit){
 
-        if ((int32_t)total_sync_client_list_.size() >= pool_max_size_ &&
-            auto_extand_pool_max_size_ &&
-            pool_max_size_ < auto_extand_pool_size_uplimit){
+                rds_log_info("pool[%p] uri[%s] cur poolsize[%d] reach max[%d], "
+                    "try extand max pool size from [%d] to [%d], uplimit[%d].",
+                    this, uri_string().c_str(),
+                    current_count,
+                    pool_max_size_, pool_max_size_,
+                    pool_max_size_ + 1, auto_extand_pool_size_uplimit);
 
-            rds_log_info("pool[%p] uri[%s] cur poolsize[%d] reach max[%d], "
-                "try extand max pool size from [%d] to [%d], uplimit[%d].",
-                this, uri_string().c_str(),
-                total_sync_client_list_.size(), 
-                pool_max_size_, pool_max_size_, 
-                pool_max_size_ + 1, auto_extand_pool_size_uplimit);
+                pool_max_size_++;
+            }
 
-            pool_max_size_++;
-        }
+            if (current_count >= pool_max_size_)
+                return nullptr;
 
-        if ((int32_t)total_sync_client_list_.size() >= pool_max_size_)
-            return;
+            // not connect again and again to the node down, only one connect to it at
+            // a time, the caller not wait the connect time out. not a failure of the node
+            if (!force && (now_milliseconds() < next_connect_time_ ||
+                (connect_failures_ > 0 && connecting_count_ > 0))){
+                return nullptr;
+            }
+
+            ++connecting_count_;
+        }
 
         standalone_sync_client* new_client = create_client();
-        if (!new_client){
-            return;
+
+        {
+            std::lock_guard<std::mutex> locker(list_mtx_);
+            --connecting_count_;
+
+            if (new_client){
+                connect_failures_ = 0;
+                next_connect_time_ = 0;
+                total_sync_client_list_.push_back(new_client);
+
+                rds_log_info("add new client to pool[%p], cur[%d] free[%d] max[%d] uri[%s].",
+                    this, total_sync_client_list_.size(),
+                    free_sync_client_queue_.size(),
+                    pool_max_size_, uri_string().c_str());
+
+                return new_client;
+            }
+
+            next_connect_time_ = now_milliseconds() + backoff_delay(sync_reconnect_min_interval,
+                check_sync_client_valid_interval, connect_failures_++);
         }
 
-        if (!add_client(new_client)){
-            new_client->destroy();
+        if (!force){
+            breaker_.on_failure();
         }
+        return nullptr;
+    }
+
+    static int64_t now_milliseconds(){
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
     standalone_sync_client* create_client(){
         std::string uri(std::move(uri_string()));
         standalone_sync_client* client =
             new standalone_sync_client(thread_pool_->io_service(), uri.c_str(), this);
+        client->set_readonly(readonly_);
 
         if (!client->connect()){
             client->destroy();
@@ -372,26 +480,6 @@ protected:
         return client;
     }
 
-    bool    add_client(standalone_sync_client* client){
-        if (!client){
-            return false;
-        }
-
-        if ((int32_t)total_sync_client_list_.size() >= pool_max_size_){
-            return false;
-        }
-
-        free_sync_client_queue_.push(client);
-        total_sync_client_list_.push_back(client);
-
-        rds_log_info("add new client to pool[%p], cur[%d] free[%d] max[%d] uri[%s].",
-            this, total_sync_client_list_.size(), 
-            free_sync_client_queue_.size(), 
-            pool_max_size_, uri_string().c_str());
-
-        return true;
-    }
-
 };
 }
 }
@@ -0,0 +1,74 @@
+﻿/**
+ *
+ * sync_reply_waiter.hpp
+ *
+ * the sync caller waits for the reply done by others
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-15
+ */
+
+#ifndef __ydk_rediscpp_detail_sync_reply_waiter_hpp__
+#define __ydk_rediscpp_detail_sync_reply_waiter_hpp__
+
+#include <redis_cpp/detail/config.hpp>
+#include <redis_cpp/redis_reply.hpp>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace redis_cpp
+{
+namespace detail
+{
+
+/** the caller waits for the reply on it */
+class sync_reply_waiter
+{
+protected:
+    std::mutex              mtx_;
+    std::condition_variable cv_;
+    redis_reply_ptr         reply_;
+    bool                    done_;
+
+public:
+    sync_reply_waiter()
+        : done_(false){
+    }
+
+    void    set_reply(redis_reply_ptr reply){
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            reply_ = reply;
+            done_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * @brief wait for the reply
+     * @param timeout - in milliseconds, 0 means wait until the reply come
+     * @return false if timeout
+     */
+    bool    wait(int32_t timeout){
+        std::unique_lock<std::mutex> locker(mtx_);
+        if (timeout <= 0){
+            cv_.wait(locker, [this](){ return done_; });
+            return true;
+        }
+
+        return cv_.wait_for(locker, std::chrono::milliseconds(timeout),
+            [this](){ return done_; });
+    }
+
+    redis_reply_ptr reply(){
+        std::lock_guard<std::mutex> locker(mtx_);
+        return reply_;
+    }
+};
+typedef std::shared_ptr<sync_reply_waiter> sync_reply_waiter_ptr;
+}
+}
+
+#endif
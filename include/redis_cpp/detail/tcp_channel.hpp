@@ -21,6 +21,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 #include <future>
 
 namespace redis_cpp
@@ -31,6 +32,10 @@ namespace detail
 static const int32_t max_receiver_buffer_len = 0xffff;
 static const int32_t max_write_queue_size = 0x1000;
 
+/** the sent buffers are recycled for the next send */
+static const int32_t max_free_send_buffer_count = 0x10;
+static const int32_t max_free_send_buffer_capacity = 0x200000;
+
 enum channel_state{
     connecting = 0,
     connected = 1,
@@ -178,6 +183,11 @@ public:
 
 class tcp_async_channel;
 typedef std::shared_ptr<tcp_async_channel> tcp_async_channel_ptr;
+/**
+ * the handlers are run in the strand, if the io_service is run by only one
+ * thread( exclusive loop), the strand and the lock of the read/write are not
+ * needed, and the close from other threads is posted to the loop
+ */
 class tcp_async_channel :
     public base_tcp_channel,
     public std::enable_shared_from_this < tcp_async_channel >
@@ -186,25 +196,34 @@ protected:
     asio::io_service::strand        strand_;
     tcp_channel_event*              event_handler_;
     std::queue<redis_buffer_ptr>    send_queue_;
+    std::vector<redis_buffer_ptr>   free_send_buffers_;
+    std::atomic<int64_t>            pending_write_bytes_;
     std::atomic_bool                shutdown_;
+    bool                            exclusive_loop_;
 
 public:
     ~tcp_async_channel()
     {
-        close();
+        internal_close();
     }
 
-    static tcp_async_channel_ptr create(asio::io_service& io_service){
-        return tcp_async_channel_ptr(new tcp_async_channel(io_service));
+    /**
+     * @param exclusive_loop - the io_service is run by only one thread
+     */
+    static tcp_async_channel_ptr create(asio::io_service& io_service, bool exclusive_loop = false){
+        return tcp_async_channel_ptr(new tcp_async_channel(io_service, exclusive_loop));
     }
 
 protected:
-    tcp_async_channel(asio::io_service& io_service)
+    tcp_async_channel(asio::io_service& io_service, bool exclusive_loop)
         : base_tcp_channel(io_service)
         , strand_(io_service)
         , event_handler_(nullptr)
+        , exclusive_loop_(exclusive_loop)
     {
         shutdown_ = false;
+        pending_write_bytes_ = 0;
+        free_send_buffers_.reserve(max_free_send_buffer_count);
     }
 
 public:
@@ -216,6 +235,12 @@ public:
     }
 
     void close(){
+        if (exclusive_loop_ && !running_in_strand()){
+            post(std::bind(&tcp_async_channel::internal_close,
+                shared_from_this()));
+            return;
+        }
+
         internal_close();
     }
 
@@ -243,12 +268,18 @@ public:
                 proms = std::make_shared<std::promise<bool>>();
             }
 
-            asio::async_connect(socket_, endpoint_iterator,
-                                        strand_.wrap(std::bind(&tcp_async_channel::async_connect_handler,
-                                        shared_from_this(),
-                                        proms,
-                                        std::placeholders::_1,
-                                        std::placeholders::_2)));
+            auto handler = std::bind(&tcp_async_channel::async_connect_handler,
+                shared_from_this(),
+                proms,
+                std::placeholders::_1,
+                std::placeholders::_2);
+
+            if (exclusive_loop_){
+                asio::async_connect(socket_, endpoint_iterator, handler);
+            }
+            else{
+                asio::async_connect(socket_, endpoint_iterator, strand_.wrap(handler));
+            }
         }
 
         if (proms){
@@ -272,14 +303,34 @@ public:
         return true;
     }
 
+    /**
+     * @brief send buffer, the buffer is queued in the channel strand
+     * @return false if the channel has been shutdown
+     */
     bool send(redis_buffer_ptr buffer){
-        std::lock_guard<std::mutex> locker(mtx_);
+        if (shutdown_){
+            return false;
+        }
 
-        if (send_queue_.size() > max_write_queue_size){
+        post(std::bind(&tcp_async_channel::send_in_strand,
+            shared_from_this(),
+            buffer));
+
+        return true;
+    }
+
+    /**
+     * @brief send buffer, only be called in the channel strand( the send
+     * queue is only accessed in the strand, so no lock needed)
+     * @return false if the send queue too long
+     */
+    bool send_in_strand(redis_buffer_ptr buffer){
+        if (send_queue_full()){
             rds_log_error("async_channel[%p] current send queue too long, give up.", this);
             return false;
         }
 
+        pending_write_bytes_ += buffer->readable_bytes();
         send_queue_.push(buffer);
         if (send_queue_.size() == 1){
             async_write(buffer);
@@ -288,24 +339,74 @@ public:
         return true;
     }
 
-    void clear_send_queue_locked()
-    {
-        std::lock_guard<std::mutex> locker(mtx_);
+    /**
+     * @brief get an empty send buffer, the sent buffer is reused if any,
+     * only in the channel strand
+     */
+    redis_buffer_ptr acquire_send_buffer(){
+        if (!free_send_buffers_.empty()){
+            redis_buffer_ptr buffer = std::move(free_send_buffers_.back());
+            free_send_buffers_.pop_back();
+            return buffer;
+        }
 
-        clear_send_queue();
+        return redis_buffer::create(0x400, true);
+    }
+
+    /** the bytes in the send queue not written yet */
+    int64_t pending_write_bytes(){
+        return pending_write_bytes_;
+    }
+
+    /** is the send queue too long, only in the channel strand */
+    bool send_queue_full(){
+        return send_queue_.size() > max_write_queue_size;
+    }
+
+    /** is the current thread running in the channel strand */
+    bool running_in_strand(){
+        if (exclusive_loop_){
+            return io_service_.get_executor().running_in_this_thread();
+        }
+
+        return strand_.running_in_this_thread();
+    }
+
+    /** post handler to the channel strand */
+    template<class handler_type>
+    void post(const handler_type& handler){
+        if (exclusive_loop_){
+            io_service_.post(handler);
+        }
+        else{
+            strand_.post(handler);
+        }
+    }
+
+    void clear_send_queue_in_strand()
+    {
+        post(std::bind(&tcp_async_channel::clear_send_queue,
+            shared_from_this()));
     }
 
 protected:
 
     void start_receive(){
+        auto handler = std::bind(&tcp_async_channel::async_receive_handler,
+            shared_from_this(),
+            recv_buffer,
+            std::placeholders::_1,
+            std::placeholders::_2);
+
+        if (exclusive_loop_){
+            socket_.async_read_some(asio::buffer(recv_buffer, max_receiver_buffer_len), handler);
+            return;
+        }
+
         std::lock_guard<std::mutex> locker(mtx_);
 
         socket_.async_read_some(asio::buffer(recv_buffer, max_receiver_buffer_len),
-                                strand_.wrap(std::bind(&tcp_async_channel::async_receive_handler,
-                                                        shared_from_this(),
-                                                        recv_buffer,
-                                                        std::placeholders::_1,
-                                                        std::placeholders::_2)));
+                                strand_.wrap(handler));
     }
 
     void async_receive_handler(char* dst, std::error_code error, std::size_t length){
@@ -326,12 +427,22 @@ protected:
 
 
     void async_write(redis_buffer_ptr buffer){
+        auto handler = std::bind(&tcp_async_channel::async_write_handler,
+            shared_from_this(),
+            buffer,
+            std::placeholders::_1,
+            std::placeholders::_2);
+
+        if (exclusive_loop_){
+            asio::async_write(socket_, asio::buffer(buffer->data(), buffer->readable_bytes()), handler);
+            return;
+        }
+
+        // the socket could be closed by other thread
+        std::lock_guard<std::mutex> locker(mtx_);
+
         asio::async_write(socket_, asio::buffer(buffer->data(), buffer->readable_bytes()),
-                          strand_.wrap(std::bind(&tcp_async_channel::async_write_handler,
-                                                 shared_from_this(),
-                                                 buffer,
-                                                 std::placeholders::_1,
-                                                 std::placeholders::_2)));
+                          strand_.wrap(handler));
     }
 
     void async_write_handler(redis_buffer_ptr buffer, std::error_code error, std::size_t length){
@@ -345,14 +456,19 @@ protected:
             return;
         }
 
-        std::lock_guard<std::mutex> locker(mtx_);
-
         if ( !send_queue_.empty())
             send_queue_.pop();
 
+        int32_t sent_bytes = buffer->readable_bytes();
+        pending_write_bytes_ -= sent_bytes;
+        recycle_send_buffer(buffer);
+
         if (!send_queue_.empty() && con_state_ == connected){
             async_write(send_queue_.front());
         }
+
+        if (!shutdown_ && event_handler_)
+            event_handler_->message_sent(remote_ip_.c_str(), remote_port_, sent_bytes);
     }
 
 
@@ -424,7 +540,16 @@ protected:
             event_handler_->channel_closed(remote_ip_.c_str(), remote_port_);
     }
 
+    void recycle_send_buffer(redis_buffer_ptr& buffer){
+        if ((int32_t)free_send_buffers_.size() < max_free_send_buffer_count &&
+            buffer->max_capacity() <= max_free_send_buffer_capacity){
+            buffer->clear();
+            free_send_buffers_.push_back(std::move(buffer));
+        }
+    }
+
     void clear_send_queue(){
+        pending_write_bytes_ = 0;
         while (!send_queue_.empty()){
             send_queue_.pop();
         }
@@ -47,6 +47,12 @@ public:
      */
     virtual void message_received(const char* ip, int32_t port, 
         const char* message, int32_t size) = 0;
+
+    /**
+     * msg written to the connection
+     */
+    virtual void message_sent(const char* ip, int32_t port, int32_t size){
+    }
 };
 }
 }
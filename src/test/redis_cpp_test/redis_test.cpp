@@ -3,6 +3,9 @@
 #include <vector>
 #include <redis_cpp.hpp>
 #include <utils/redis_lock.hpp>
+#include <utils/redis_redlock.hpp>
+#include <utils/redis_cache_loader.hpp>
+#include <utils/redis_counter_aggregator.hpp>
 #include <redis_cpp/utils/ip_utils.hpp>
 #include <utility/asio_base/thread_pool.hpp>
 
@@ -1714,13 +1717,548 @@ void standalone_async_client_test(){
             std::cin >> channel_name >> message;
             client->publish(channel_name, message, std::bind(default_reply_handler, std::placeholders::_1));
         }
+        else if (cmd == "set"){
+            // in cluster mode, the command follows the moved/ask redirect
+            std::string key, value;
+            std::cin >> key >> value;
+            redis_async_operator redis_op(client);
+            redis_op.set(key.c_str(), value.c_str(), [key](bool success){
+                printf("set key[%s] ret[%d]\n", key.c_str(), success);
+            });
+        }
+        else if (cmd == "get"){
+            std::string key;
+            std::cin >> key;
+            redis_async_operator redis_op(client);
+            redis_op.get(key.c_str(), [key](bool success, const std::string& value){
+                printf("get key[%s] ret[%d] value[%s]\n", key.c_str(), success, value.c_str());
+            });
+        }
+    }
+
+    pool.wait_for_stop();
+}
+
+void redis_async_typed_command_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client client(pool.io_service(), redis_uri.c_str());
+    client.connect();
+
+    redis_async_operator redis_op(&client);
+
+    redis_op.set("async_key", "async_value", [](bool success){
+        printf("set async_key ret[%d]\n", success);
+    });
+
+    redis_op.get("async_key", [](bool success, const std::string& value){
+        printf("get async_key ret[%d] value[%s]\n", success, value.c_str());
+    });
+
+    redis_op.incr("async_counter", [](bool success, int64_t value){
+        printf("incr async_counter ret[%d] value[%lld]\n", success, (long long)value);
+    });
+
+    redis_op.hset("async_hash", "field", "value", [](bool success, int64_t value){
+        printf("hset async_hash ret[%d] value[%lld]\n", success, (long long)value);
+    });
+
+    redis_op.hgetall("async_hash", [](bool success,
+        const std::unordered_map<std::string, std::string>& table){
+        printf("hgetall async_hash ret[%d] size[%d]\n", success, (int32_t)table.size());
+    });
+
+    redis_op.zadd("async_zset", 1.5, "member", [](bool success, int64_t value){
+        printf("zadd async_zset ret[%d] value[%lld]\n", success, (long long)value);
+    });
+
+    redis_op.zrangewithscores("async_zset", 0, -1, [](bool success,
+        const std::vector<std::pair<std::string, double>>& values){
+        for (auto& v : values){
+            printf("zrange async_zset member[%s] score[%f]\n", v.first.c_str(), v.second);
+        }
+    });
+
+    pool.wait_for_stop();
+}
+
+void standalone_async_client_pool_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(4);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client_pool client_pool(pool.io_service(), redis_uri.c_str(),
+        4, async_dispatch_least_pending);
+    client_pool.connect();
+
+    redis_async_operator redis_op(&client_pool);
+
+    std::atomic<int32_t> finished(0);
+    int32_t total = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < total; ++i){
+        redis_op.incr("async_pool_counter", [&finished](bool success, int64_t value){
+            ++finished;
+        });
+    }
+
+    while (finished < total){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("%d incr finished in %lld ms\n", total, (long long)cost);
+
+    pool.wait_for_stop();
+}
+
+void async_client_multi_producer_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client client(pool.io_service(), redis_uri.c_str());
+    client.connect();
+
+    redis_async_operator redis_op(&client);
+
+    // the replies of one producer must keep the order of its commands
+    std::atomic<int32_t> finished(0);
+    std::atomic<int32_t> failed(0);
+    int32_t thread_count = 8;
+    int32_t count = 10000;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int32_t t = 0; t < thread_count; ++t){
+        producers.emplace_back([&, t](){
+            std::string key = "async_producer_" + std::to_string(t);
+            for (int32_t i = 0; i < count; ++i){
+                std::string value = std::to_string(i);
+                redis_op.set(key.c_str(), value.c_str(), [&](bool success){
+                    if (!success) ++failed;
+                    ++finished;
+                });
+                redis_op.get(key.c_str(), [&, value](bool success, const std::string& ret){
+                    if (!success || ret != value) ++failed;
+                    ++finished;
+                });
+            }
+        });
+    }
+
+    for (auto& producer : producers){
+        producer.join();
+    }
+
+    while (finished < thread_count * count * 2){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("%d commands finished in %lld ms, failed[%d]\n",
+        thread_count * count * 2, (long long)cost, failed.load());
+
+    pool.wait_for_stop();
+}
+
+void async_client_backpressure_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client client(pool.io_service(), redis_uri.c_str());
+
+    async_backpressure_option option;
+    option.high_watermark_count = 1000;
+    option.low_watermark_count = 100;
+    option.policy = async_backpressure_reject;
+    option.handler = [](bool paused){
+        printf("backpressure paused[%d]\n", paused);
+    };
+    client.set_backpressure_option(option);
+    client.connect();
+
+    redis_async_operator redis_op(&client);
+
+    // the rejected commands are completed with failure
+    std::atomic<int32_t> finished(0);
+    std::atomic<int32_t> rejected(0);
+    int32_t total = 100000;
+    for (int32_t i = 0; i < total; ++i){
+        redis_op.incr("async_backpressure_counter", [&](bool success, int64_t value){
+            if (!success) ++rejected;
+            ++finished;
+        });
+    }
+
+    while (finished < total){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    printf("%d incr finished, rejected[%d]\n", total, rejected.load());
+
+    pool.wait_for_stop();
+}
+
+void async_completion_executor_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(1);
+    pool.start();
+
+    // the handlers run in the executor threads, the io thread keeps parsing
+    utility::asio_base::thread_pool executor(4);
+    executor.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client client(pool.io_service(), redis_uri.c_str());
+    client.set_completion_executor(&executor.io_service());
+    client.connect();
+
+    redis_async_operator redis_op(&client);
+
+    std::atomic<int32_t> finished(0);
+    std::atomic<int64_t> last_value(0);
+    std::atomic<int32_t> disordered(0);
+    int32_t total = 10000;
+    for (int32_t i = 0; i < total; ++i){
+        redis_op.incr("async_executor_counter", [&](bool success, int64_t value){
+            // the handlers of one connection are still called in order
+            if (success && value <= last_value) ++disordered;
+            last_value = value;
+            ++finished;
+        });
+    }
+
+    while (finished < total){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 
+    printf("%d incr finished in executor, disordered[%d]\n", total, disordered.load());
+
     pool.wait_for_stop();
 }
 
+void async_client_exclusive_loop_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    // one io_service per core, each connection bound to one of them
+    utility::asio_base::io_service_pool loops(0, true);
+    loops.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client_pool client_pool(loops, redis_uri.c_str(),
+        loops.thread_count(), async_dispatch_round_robin);
+    client_pool.connect();
+
+    redis_async_operator redis_op(&client_pool);
+
+    std::atomic<int32_t> finished(0);
+    int32_t total = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < total; ++i){
+        redis_op.incr("async_loop_counter", [&finished](bool success, int64_t value){
+            ++finished;
+        });
+    }
+
+    while (finished < total){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("%d incr finished in %lld ms with %d loops\n", total, (long long)cost, loops.thread_count());
+
+    loops.wait_for_stop();
+}
+
+void fire_and_forget_async_client_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(1);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    fire_and_forget_async_client client(pool.io_service(), redis_uri.c_str());
+    client.set_barrier_handler([](bool healthy){
+        printf("barrier healthy[%d]\n", healthy);
+    });
+    client.try_connect(true);
+
+    // no reply, no handler
+    for (int32_t i = 0; i < 100000; ++i){
+        redis_command cmd("incr");
+        cmd.add_param("fire_and_forget_counter");
+        client.send(cmd);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+    printf("sent[%lld] dropped[%lld] barrier[%lld]\n", (long long)client.sent_count(),
+        (long long)client.dropped_count(), (long long)client.barrier_count());
+
+    client.shutdown();
+    pool.stop();
+    pool.wait_for_stop();
+}
+
+void multiplexed_sync_client_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    // many threads share two connections, the commands are pipelined
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    multiplexed_sync_client client(redis_uri.c_str(), 2);
+    client.connect();
+
+    redis_sync_operator redis_op(&client);
+
+    std::atomic<int32_t> failed(0);
+    int32_t thread_count = 16;
+    int32_t count = 10000;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < thread_count; ++t){
+        threads.push_back(std::thread([&redis_op, &failed, count, t](){
+            std::string key = "multiplexed_key_" + std::to_string(t);
+            for (int32_t i = 0; i < count; ++i){
+                std::string value = std::to_string(i);
+                std::string result;
+                if (!redis_op.set(key.c_str(), value.c_str()) || !redis_op.get(key.c_str(), result) || result != value){
+                    ++failed;
+                }
+            }
+        }));
+    }
+
+    for (auto& thread : threads){
+        thread.join();
+    }
+
+    auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("%d threads finished in %lld ms, failed[%d]\n", thread_count, (long long)cost, (int32_t)failed);
+}
+
+void near_cache_sync_client_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+
+    near_cache_option option;
+    option.max_memory = 16 * 1024 * 1024;
+    near_cache_sync_client client(redis_uri.c_str(), 2, 4, nullptr, option);
+    client.connect();
+
+    redis_sync_operator redis_op(&client);
+    redis_op.set("near_cache_key", "value_1");
+
+    std::string value;
+    for (int32_t i = 0; i < 10000; ++i){
+        redis_op.get("near_cache_key", value);
+    }
+    printf("value[%s] hit[%lld] miss[%lld]\n", value.c_str(),
+        (long long)client.hit_count(), (long long)client.miss_count());
+
+    // changed by other client, the cached reply invalidated by the server
+    standalone_sync_client_pool other_client(redis_uri.c_str(), 1, 2);
+    redis_sync_operator other_op(&other_client);
+    other_op.set("near_cache_key", "value_2");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    redis_op.get("near_cache_key", value);
+    printf("value[%s] after changed by other client\n", value.c_str());
+}
+
+void single_flight_sync_client_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+
+    standalone_sync_client_pool pool(redis_uri.c_str(), 2, 8);
+    single_flight_sync_client client(&pool, { "get", "hgetall" });
+
+    redis_sync_operator init_op(&client);
+    init_op.set("single_flight_key", "value_1");
+
+    // the concurrent reads of the same key share one round trip
+    std::vector<std::thread> threads;
+    for (int32_t i = 0; i < 8; ++i){
+        threads.push_back(std::thread([&client](){
+            redis_sync_operator redis_op(&client);
+            std::string value;
+            for (int32_t j = 0; j < 1000; ++j){
+                redis_op.get("single_flight_key", value);
+            }
+        }));
+    }
+
+    for (auto& t : threads){
+        t.join();
+    }
+
+    printf("shared count[%lld]\n", (long long)client.shared_count());
+}
+
+void sharded_sync_client_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    // the third master get half of the keys
+    std::vector<sharded_node> nodes = {
+        sharded_node("redis://foobared@127.0.0.1:6379/0", 1),
+        sharded_node("redis://foobared@127.0.0.1:6380/0", 1),
+        sharded_node("redis://foobared@127.0.0.1:6381/0", 2),
+    };
+    sharded_sync_client client(nodes, 1, 4);
+
+    redis_sync_operator redis_op(&client);
+    redis_op.set("sharded_key", "value");
+
+    // split by node and merged
+    std::unordered_map<std::string, std::string> kv_pairs;
+    std::vector<std::string> keys;
+    for (int32_t i = 0; i < 10; ++i){
+        std::string key = "sharded_key_" + std::to_string(i);
+        kv_pairs[key] = std::to_string(i);
+        keys.push_back(key);
+        printf("key[%s] node[%d]\n", key.c_str(), client.node_index(key));
+    }
+    redis_op.mset(kv_pairs);
+
+    std::vector<std::string> values;
+    redis_op.mget(keys, values);
+    printf("mget count[%d], del count[%d]\n", (int32_t)values.size(), redis_op.del(keys));
+}
+
+void cluster_replica_read_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    // the read commands on the replicas, prefer the replica in the same zone
+    replica_read_option option;
+    option.policy = replica_read_lowest_latency;
+    option.local_zone = "zone_a";
+    option.node_zones["127.0.0.1:7003"] = "zone_a";
+    option.node_zones["127.0.0.1:7004"] = "zone_b";
+    option.node_zones["127.0.0.1:7005"] = "zone_a";
+
+    std::string redis_uri_list = "redis://foobared@127.0.0.1:7000;redis://foobared@127.0.0.1:7001;redis://foobared@127.0.0.1:7002";
+    cluster_sync_client cluster(redis_uri_list.c_str(), 1, 2, option);
+
+    redis_sync_operator redis_op(&cluster);
+    redis_op.set("replica_read_key", "value");
+
+    // the replica may not be synchronized yet
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::string value;
+    for (int32_t i = 0; i < 1000; ++i){
+        redis_op.get("replica_read_key", value);
+    }
+    printf("replica_read_key[%s]\n", value.c_str());
+}
+
+#if defined(REDIS_CPP_HAS_COROUTINE)
+redis_cpp::detail::redis_task redis_coroutine_flow(redis_cpp::detail::redis_coroutine_operator& redis_op){
+    auto set_ret = co_await redis_op.set("coroutine_key", "coroutine_value");
+    printf("co_await set coroutine_key ret[%d]\n", set_ret.success);
+
+    auto get_ret = co_await redis_op.get("coroutine_key");
+    printf("co_await get coroutine_key ret[%d] value[%s]\n", get_ret.success, get_ret.value.c_str());
+
+    auto incr_ret = co_await redis_op.incr("coroutine_counter");
+    printf("co_await incr coroutine_counter ret[%d] value[%lld]\n", incr_ret.success, (long long)incr_ret.value);
+}
+
+void redis_coroutine_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_async_client client(pool.io_service(), redis_uri.c_str());
+    client.connect();
+
+    redis_coroutine_operator redis_op(&client, &pool.io_service());
+    for (int32_t i = 0; i < 100; ++i){
+        redis_coroutine_flow(redis_op);
+    }
+
+    pool.wait_for_stop();
+}
+#endif
+
+void circuit_breaker_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    // open after 5 failures in a row, probe after 500ms, at most 30s
+    circuit_breaker_option option;
+    option.consecutive_failure_threshold = 5;
+    option.open_time = 500;
+    option.max_open_time = 30000;
+
+    standalone_sync_client_pool pool("redis://foobared@127.0.0.1:6379/0", 1, 2);
+    pool.set_circuit_breaker_option(option);
+    redis_sync_operator redis_op(&pool);
+
+    // stop the redis server meanwhile, the commands fail at once while the breaker open
+    for (int32_t i = 0; i < 100000; ++i){
+        auto begin = std::chrono::steady_clock::now();
+        bool ret = redis_op.set("circuit_breaker_key", std::to_string(i).c_str());
+        auto cost = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        if (!ret){
+            printf("set failed, breaker state[%d], cost[%d]us\n", pool.breaker_state(), (int32_t)cost);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+}
+
 void redis_async_operator_test(){
     standalone_async_client_test();
+
+    // redis_async_typed_command_test();
+
+    // standalone_async_client_pool_test();
+    // async_client_multi_producer_test();
+    // async_client_backpressure_test();
+    // async_completion_executor_test();
+    // async_client_exclusive_loop_test();
+    // fire_and_forget_async_client_test();
+    // multiplexed_sync_client_test();
+    // near_cache_sync_client_test();
+    // single_flight_sync_client_test();
+    // sharded_sync_client_test();
+    // cluster_replica_read_test();
+
+#if defined(REDIS_CPP_HAS_COROUTINE)
+    // redis_coroutine_test();
+#endif
 }
 
 void sentinel_client_test(){
@@ -1746,6 +2284,29 @@ void sentinel_client_test(){
     }
 }
 
+void sentinel_master_lookup_test(){
+    using namespace redis_cpp::detail;
+
+    // the lookup not delayed by the dead sentinel( 26380)
+    const char* srv_list = "127.0.0.1:26380;127.0.0.1:26379";
+    sentinel_client_pool_ptr client_pool = sentinel_client_pool::create(srv_list);
+    client_pool->start();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    for (int32_t i = 0; i < 3; ++i){
+        auto start = std::chrono::steady_clock::now();
+        std::pair<std::string, int32_t> address;
+        bool ret = client_pool->get_master_address_by_name("acmaster", address);
+        auto cost = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        // cached after the first lookup
+        printf("get master address ret[%d] address[%s:%d] cost[%lld]us\n",
+            ret, address.first.c_str(), address.second, (long long)cost);
+    }
+}
+
 void sentinel_sync_client_test()
 {
     using namespace redis_cpp;
@@ -1813,6 +2374,82 @@ void sentinel_sync_client_test()
     }
 }
 
+void sentinel_replica_read_test()
+{
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    const char* srv_list = "127.0.0.1:26379";
+    sentinel_client_pool_ptr client_pool = sentinel_client_pool::create(srv_list);
+    client_pool->start();
+
+    // the read commands on the healthy replicas discovered by the sentinels
+    sentinel_replica_option option;
+    option.policy = replica_read_round_robin;
+    option.max_link_down_time = 5000;
+    option.max_repl_lag = 1024 * 1024;
+
+    std::string redis_uri_str = "redis://foobared@127.0.0.1:6381/1";
+    sentinel_sync_client client("acmaster", redis_uri_str.c_str(), 1, 2, nullptr, option);
+    client.set_sentinel_client_pool(client_pool);
+
+    // wait the replicas refreshed
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+    std::vector<std::string> replicas = client.available_replicas();
+    for (auto& replica : replicas){
+        printf("available replica[%s]\n", replica.c_str());
+    }
+
+    redis_sync_operator redis_op(&client);
+    redis_op.set("sentinel_replica_read_key", "value");
+
+    std::string value;
+    for (int32_t i = 0; i < 1000; ++i){
+        redis_op.get("sentinel_replica_read_key", value);
+    }
+    printf("sentinel_replica_read_key[%s]\n", value.c_str());
+}
+
+void sentinel_failover_test()
+{
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    const char* srv_list = "127.0.0.1:26379";
+    sentinel_client_pool_ptr client_pool = sentinel_client_pool::create(srv_list);
+    client_pool->start();
+
+    std::string redis_uri_str = "redis://foobared@127.0.0.1:6381/1";
+    std::pair<std::string, int32_t> address;
+    if (client_pool->get_master_address_by_name("acmaster", address)){
+        redis_uri uri(redis_uri_str.c_str());
+        uri.set_ip(address.first.c_str());
+        uri.set_port(address.second);
+        redis_uri_str = uri.to_string();
+    }
+
+    // the commands wait at most 3 seconds for the new master, the idempotent
+    // ones failed by the switch are done again
+    sentinel_failover_option option;
+    option.buffer_time = 3000;
+    option.buffer_bytes = 1024 * 1024;
+
+    sentinel_sync_client client("acmaster", redis_uri_str.c_str(), 1, 2);
+    client.set_failover_option(option);
+    client.set_sentinel_client_pool(client_pool);
+    redis_sync_operator redis_op(&client);
+
+    // run "sentinel failover acmaster" meanwhile
+    int32_t failed_count = 0;
+    for (int32_t i = 0; i < 100000; ++i){
+        if (!redis_op.set("sentinel_failover_key", std::to_string(i).c_str())){
+            ++failed_count;
+        }
+    }
+    printf("sentinel failover test, failed count[%d]\n", failed_count);
+}
+
 void sentinel_async_client_test()
 {
     using namespace redis_cpp;
@@ -2002,6 +2639,237 @@ void redis_lock_test() {
     }
 }
 
+void redis_notified_lock_test() {
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/0";
+
+    standalone_sync_client_pool client_pool(redis_uri.c_str(), 4, 8, &pool);
+    standalone_async_client async_client(pool.io_service(), redis_uri.c_str());
+    async_client.connect();
+
+    // the waiters woken by the release notification, the leases renewed by the watchdog
+    utils::redis_lock_notifier notifier(&async_client);
+    utils::redis_lock_watchdog watchdog(pool.io_service(), &client_pool);
+
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            redis_sync_operator client(&client_pool);
+            for (int32_t i = 0; i < 10; ++i) {
+                utils::redis_auto_lock locker(&client, "notified_lock", "requestor_" + std::to_string(t),
+                    300, 5000, &notifier, &watchdog, true);
+                if (!locker.islocked()) {
+                    printf("requestor[%d] lock failed\n", t);
+                    continue;
+                }
+
+                // hold longer than the key ttl, kept by the watchdog
+                printf("requestor[%d] locked, fencing token[%lld]\n", t, (long long)locker.fencing_token());
+                std::this_thread::sleep_for(std::chrono::milliseconds(i == 0 ? 500 : 10));
+            }
+        }));
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    async_client.shutdown();
+    pool.stop();
+    pool.wait_for_stop();
+}
+
+void redis_redlock_test() {
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    // lock the masters in parallel
+    utility::asio_base::thread_pool executor(3);
+    executor.start();
+
+    standalone_sync_client_pool master_1("redis://foobared@127.0.0.1:6379/0", 1, 2, &pool);
+    standalone_sync_client_pool master_2("redis://foobared@127.0.0.1:6380/0", 1, 2, &pool);
+    standalone_sync_client_pool master_3("redis://foobared@127.0.0.1:6381/0", 1, 2, &pool);
+    std::vector<base_sync_client*> masters = { &master_1, &master_2, &master_3 };
+
+    uint32_t start_time = get_cur_time();
+    {
+        redis_cpp::utils::redis_auto_redlock locker(masters, &executor, "redlock_key", "requestor", 10000, 3000);
+        printf("locked[%d] validity[%d] cost[%u]\n", locker.islocked(), locker.validity_time(), 
+            get_cur_time() - start_time);
+    }
+
+    executor.stop();
+    executor.wait_for_stop();
+    pool.stop();
+    pool.wait_for_stop();
+}
+
+void redis_cache_loader_test() {
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    standalone_sync_client_pool client_pool("redis://foobared@127.0.0.1:6379/0", 2, 8);
+    redis_sync_operator redis_op(&client_pool);
+
+    utils::cache_loader_option option;
+    option.ttl = 1000;
+    option.stale_time = 5000;
+    utils::cache_loader loader(&redis_op, option);
+
+    // the hot key rebuilt by one caller at a time, the others get the cached or stale value
+    std::atomic<int32_t> load_count(0);
+    std::vector<std::thread> threads;
+    for (int32_t i = 0; i < 8; ++i) {
+        threads.push_back(std::thread([&loader, &load_count]() {
+            std::string value;
+            for (int32_t j = 0; j < 1000; ++j) {
+                loader.get("cache_loader_key", value, [&load_count](const std::string& key, std::string& value) {
+                    ++load_count;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    value = "value_of_" + key;
+                    return true;
+                });
+            }
+        }));
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    printf("load count[%d]\n", load_count.load());
+}
+
+void redis_counter_aggregator_test() {
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(1);
+    pool.start();
+
+    standalone_sync_client_pool client_pool("redis://foobared@127.0.0.1:6379/0", 2, 8, &pool);
+    {
+        // the deltas flushed every 100 ms, and when destroyed
+        utils::counter_aggregator aggregator(pool.io_service(), &client_pool);
+        for (int32_t i = 0; i < 100000; ++i) {
+            aggregator.incrby("counter_key_" + std::to_string(i % 100), 1);
+            aggregator.hincrby("counter_hash", "field", 2);
+            aggregator.zincrby("counter_zset", "member", 0.5);
+        }
+    }
+
+    redis_sync_operator redis_op(&client_pool);
+    int64_t value = 0;
+    redis_op.get("counter_key_0", value);
+    printf("counter_key_0[%lld]\n", (long long)value);
+
+    pool.stop();
+    pool.wait_for_stop();
+}
+
+void redis_transaction_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_sync_client_pool client_pool(redis_uri.c_str(), 1, 4, &pool);
+
+    // multi/exec in one write
+    {
+        redis_transaction trans(&client_pool);
+        redis_command set_cmd("set");
+        set_cmd.add_param("trans_key");
+        set_cmd.add_param("trans_value");
+        trans.queue(set_cmd);
+        redis_command get_cmd("get");
+        get_cmd.add_param("trans_key");
+        trans.queue(get_cmd);
+
+        std::vector<redis_reply_ptr> replies;
+        transaction_result ret = trans.exec(replies);
+        printf("exec ret[%d] reply count[%d]\n", ret, (int32_t)replies.size());
+    }
+
+    // read-modify-write with watch, retry if the key changed by others
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < 4; ++t){
+        threads.push_back(std::thread([&client_pool](){
+            for (int32_t i = 0; i < 100; ++i){
+                std::vector<redis_reply_ptr> replies;
+                transaction_result ret = redis_transaction::execute(&client_pool, { "trans_counter" },
+                    [](redis_transaction& trans){
+                    redis_sync_operator redis_op(&trans);
+                    int64_t value = 0;
+                    redis_op.get("trans_counter", value);
+
+                    redis_command cmd("set");
+                    cmd.add_param("trans_counter");
+                    cmd.add_param(value + 1);
+                    trans.queue(std::move(cmd));
+                    return true;
+                }, replies, 100);
+
+                if (ret != transaction_ok){
+                    printf("transaction failed, ret[%d]\n", ret);
+                }
+            }
+        }));
+    }
+
+    for (auto& thread : threads){
+        thread.join();
+    }
+
+    redis_sync_operator redis_op(&client_pool);
+    int64_t counter = 0;
+    redis_op.get("trans_counter", counter);
+    printf("trans_counter[%lld]\n", (long long)counter);
+
+    pool.stop();
+    pool.wait_for_stop();
+}
+
+void redis_cached_script_test(){
+    using namespace redis_cpp;
+    using namespace redis_cpp::detail;
+
+    utility::asio_base::thread_pool pool(2);
+    pool.start();
+
+    std::string redis_uri = "redis://foobared@127.0.0.1:6379/1";
+    standalone_sync_client_pool client_pool(redis_uri.c_str(), 1, 2, &pool);
+    redis_sync_operator redis_op(&client_pool);
+
+    static const redis_cached_script incr_script(
+        "return redis.call('incrby', KEYS[1], ARGV[1])");
+    printf("local sha1[%s]\n", incr_script.sha1().c_str());
+
+    std::vector<std::string> keys = { "cached_script_counter" };
+    std::vector<std::string> args = { "2" };
+
+    // the first eval load the script after NOSCRIPT, then only the sha1 sent
+    redis_op.script_flush();
+    for (int32_t i = 0; i < 3; ++i){
+        redis_reply_ptr reply = redis_op.eval(incr_script, keys, args);
+        print_reply(reply.get());
+    }
+
+    pool.stop();
+    pool.wait_for_stop();
+}
+
 void redis_lua_script_test() {
     using namespace redis_cpp;
     using namespace redis_cpp::detail;
@@ -2183,20 +3051,36 @@ int main()
 
     // redis_sync_operator_test();
 
+    // circuit_breaker_test();
+
     // redis_async_operator_test();
 
     // sentinel_client_test();
 
+    // sentinel_master_lookup_test();
+
     // sentinel_sync_client_test();
 
+    // sentinel_replica_read_test();
+
+    // sentinel_failover_test();
+
     // sentinel_async_client_test();
 
     // redis_script_test();
 
     // redis_lock_test();
 
+    // redis_notified_lock_test();
+    // redis_redlock_test();
+    // redis_cache_loader_test();
+    // redis_counter_aggregator_test();
+
     // redis_lua_script_test();
 
+    // redis_transaction_test();
+    // redis_cached_script_test();
+
     //redis_key_test();
 
     //domain_test();
@@ -0,0 +1,153 @@
+﻿/**
+ *
+ * io_service_pool.hpp
+ *
+ * 每个线程一个asio::io_service的线程池, 绑定到某个io_service的对象的所有handler都在同一个线程执行
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-14
+ */
+
+#ifndef __ydk_utility_asio_base_io_service_pool_hpp__
+#define __ydk_utility_asio_base_io_service_pool_hpp__
+
+#include "asio_standalone.hpp"
+#include <asio/io_service.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace utility
+{
+namespace asio_base
+{
+class io_service_pool
+{
+protected:
+    typedef std::shared_ptr<asio::io_service> io_service_ptr;
+
+    std::vector<io_service_ptr>     io_services_;
+    std::vector<std::thread*>       thread_list_;
+    std::atomic<uint32_t>           next_index_;
+    std::atomic_bool                started_;
+    bool                            pin_cpu_;
+
+public:
+    /**
+     * @param thread_count - the io_service( thread) count, 0 means the cpu core count
+     * @param pin_cpu - bind the n-th thread to the n-th cpu core
+     */
+    io_service_pool(int32_t thread_count = 0, bool pin_cpu = false)
+        : pin_cpu_(pin_cpu)
+    {
+        if (thread_count <= 0){
+            thread_count = (int32_t)std::thread::hardware_concurrency();
+        }
+
+        if (thread_count <= 0){
+            thread_count = 1;
+        }
+
+        for (int32_t i = 0; i < thread_count; ++i){
+            // only one thread run the io_service
+            io_services_.push_back(std::make_shared<asio::io_service>(1));
+        }
+
+        next_index_ = 0;
+        started_ = false;
+    }
+
+    ~io_service_pool(){
+        // the work of each thread keeps it running until stopped
+        stop();
+        join_all();
+
+        for (auto t : thread_list_){
+            delete t;
+        }
+        thread_list_.clear();
+    }
+
+    int32_t thread_count(){
+        return (int32_t)io_services_.size();
+    }
+
+    /**
+     * @brief choose an io_service by round robin, the object created by the
+     * io_service should always use it
+     */
+    asio::io_service& get_io_service(){
+        return *io_services_[next_index_++ % io_services_.size()];
+    }
+
+    asio::io_service& io_service(int32_t index){
+        return *io_services_[index % io_services_.size()];
+    }
+
+    void start(){
+        if (!started_.exchange(true)){
+            for (std::size_t i = 0; i < io_services_.size(); ++i){
+                thread_list_.push_back(new std::thread(
+                    std::bind(&io_service_pool::run, this, i)));
+            }
+        }
+    }
+
+    void stop(){
+        for (auto& ios : io_services_){
+            ios->stop();
+        }
+    }
+
+    void wait_for_stop(){
+        join_all();
+    }
+
+protected:
+    void join_all(){
+        for (auto t : thread_list_){
+            if (t->joinable()){
+                t->join();
+            }
+        }
+    }
+
+    void run(std::size_t index){
+        if (pin_cpu_){
+            bind_cpu(index);
+        }
+
+        asio::error_code error;
+        asio::io_service::work work(*io_services_[index]);
+        io_services_[index]->run(error);
+    }
+
+    void bind_cpu(std::size_t index){
+        std::size_t core_count = std::thread::hardware_concurrency();
+        if (core_count == 0){
+            return;
+        }
+
+        std::size_t cpu = index % core_count;
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#elif defined(__linux__)
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+    }
+};
+}
+}
+
+#endif
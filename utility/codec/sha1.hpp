@@ -0,0 +1,126 @@
+﻿/**
+ *
+ * sha1.hpp
+ *
+ * sha1 digest( FIPS 180-1), used to get the sha1 of the lua script locally
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-17
+ */
+
+#ifndef __ydk_utility_codec_sha1_hpp__
+#define __ydk_utility_codec_sha1_hpp__
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+namespace utility
+{
+namespace codec
+{
+    static inline uint32_t sha1_rol(uint32_t value, int32_t bits){
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    static void sha1_transform(uint32_t state[5], const unsigned char block[64]){
+        uint32_t w[80];
+        for (int32_t i = 0; i < 16; ++i){
+            w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+                ((uint32_t)block[i * 4 + 2] << 8) | ((uint32_t)block[i * 4 + 3]);
+        }
+        for (int32_t i = 16; i < 80; ++i){
+            w[i] = sha1_rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int32_t i = 0; i < 80; ++i){
+            uint32_t f, k;
+            if (i < 20){
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40){
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60){
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else{
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            uint32_t temp = sha1_rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = sha1_rol(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    /**
+     * @brief sha1 digest
+     * @param digest - out, 20 bytes
+     */
+    static void sha1(const char* buf, std::size_t len, unsigned char digest[20]){
+        uint32_t state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+        const unsigned char* data = (const unsigned char*)buf;
+
+        std::size_t i = 0;
+        for (; i + 64 <= len; i += 64){
+            sha1_transform(state, data + i);
+        }
+
+        // padding, 0x80 then zeros then the bit length in big endian
+        unsigned char block[128] = { 0 };
+        std::size_t remain = len - i;
+        memcpy(block, data + i, remain);
+        block[remain] = 0x80;
+        std::size_t block_size = (remain + 1 + 8 <= 64) ? 64 : 128;
+
+        uint64_t bit_len = (uint64_t)len * 8;
+        for (int32_t j = 0; j < 8; ++j){
+            block[block_size - 1 - j] = (unsigned char)(bit_len >> (j * 8));
+        }
+
+        sha1_transform(state, block);
+        if (block_size == 128){
+            sha1_transform(state, block + 64);
+        }
+
+        for (int32_t j = 0; j < 20; ++j){
+            digest[j] = (unsigned char)(state[j / 4] >> ((3 - j % 4) * 8));
+        }
+    }
+
+    /**
+     * @brief sha1 digest in lower case hex( 40 chars), the same as redis "script load"
+     */
+    static std::string sha1_hex(const char* buf, std::size_t len){
+        static const char hex[] = "0123456789abcdef";
+
+        unsigned char digest[20];
+        sha1(buf, len, digest);
+
+        std::string out(40, '0');
+        for (int32_t i = 0; i < 20; ++i){
+            out[i * 2] = hex[digest[i] >> 4];
+            out[i * 2 + 1] = hex[digest[i] & 0x0F];
+        }
+
+        return out;
+    }
+}
+}
+
+#endif
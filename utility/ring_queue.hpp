@@ -0,0 +1,88 @@
+﻿/**
+ *
+ * ring_queue.hpp
+ *
+ * fifo queue on a growable ring buffer, the memory is reused after the queue
+ * reaches its peak size( not thread safe)
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-13
+ */
+
+#ifndef __ydk_utility_ring_queue_hpp__
+#define __ydk_utility_ring_queue_hpp__
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace utility
+{
+
+template<class T>
+class ring_queue
+{
+protected:
+    std::vector<T>  slots_;
+    std::size_t     head_;
+    std::size_t     size_;
+
+public:
+    explicit ring_queue(std::size_t capacity = 64)
+        : head_(0)
+        , size_(0)
+    {
+        std::size_t n = 2;
+        while (n < capacity){
+            n <<= 1;
+        }
+        slots_.resize(n);
+    }
+
+    bool empty() const{
+        return size_ == 0;
+    }
+
+    std::size_t size() const{
+        return size_;
+    }
+
+    void push(T&& value){
+        if (size_ == slots_.size()){
+            grow();
+        }
+
+        slots_[(head_ + size_) & (slots_.size() - 1)] = std::move(value);
+        ++size_;
+    }
+
+    void push(const T& value){
+        T v(value);
+        push(std::move(v));
+    }
+
+    T& front(){
+        return slots_[head_];
+    }
+
+    /** the slot is reset so the resources held by the value are released */
+    void pop(){
+        slots_[head_] = T();
+        head_ = (head_ + 1) & (slots_.size() - 1);
+        --size_;
+    }
+
+protected:
+    void grow(){
+        std::vector<T> slots(slots_.size() * 2);
+        for (std::size_t i = 0; i < size_; ++i){
+            slots[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+        }
+
+        slots_.swap(slots);
+        head_ = 0;
+    }
+};
+}
+
+#endif
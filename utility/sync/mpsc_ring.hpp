@@ -0,0 +1,141 @@
+﻿/**
+ *
+ * mpsc_ring.hpp
+ *
+ * lock free bounded multiple producers single consumer ring( dmitry vyukov's bounded queue)
+ * the slots are allocated once and reused, the value in the slot is filled and consumed
+ * in place, so the value could keep its own memory( e.g. the capacity of a string)
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2017-06-13
+ */
+
+#ifndef __ydk_utility_sync_mpsc_ring_hpp__
+#define __ydk_utility_sync_mpsc_ring_hpp__
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace utility
+{
+namespace sync
+{
+
+template<class T>
+class mpsc_ring
+{
+protected:
+    struct slot
+    {
+        std::atomic<std::size_t>    sequence;
+        T                           value;
+    };
+
+    slot*                       slots_;
+    std::size_t                 mask_;
+    std::atomic<std::size_t>    enqueue_pos_;   // shared by producers
+    std::size_t                 dequeue_pos_;   // owned by the consumer
+
+public:
+    mpsc_ring& operator=(const mpsc_ring& that) = delete;
+    mpsc_ring(const mpsc_ring& that) = delete;
+
+    /**
+     * @param capacity - round up to power of 2
+     */
+    explicit mpsc_ring(std::size_t capacity)
+        : slots_(nullptr)
+        , mask_(0)
+        , dequeue_pos_(0)
+    {
+        std::size_t size = 2;
+        while (size < capacity){
+            size <<= 1;
+        }
+
+        slots_ = new slot[size];
+        mask_ = size - 1;
+        for (std::size_t i = 0; i < size; ++i){
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+    }
+
+    ~mpsc_ring()
+    {
+        delete[] slots_;
+    }
+
+    std::size_t capacity(){
+        return mask_ + 1;
+    }
+
+    /**
+     * @brief claim a slot and fill the value in place, could be called by any thread
+     * @param fill - void(T& value)
+     * @return false if the ring is full
+     */
+    template<class filler>
+    bool try_push(filler&& fill)
+    {
+        slot* s = nullptr;
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;){
+            s = &slots_[pos & mask_];
+            std::size_t seq = s->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0){
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+            else if (dif < 0){
+                return false;
+            }
+            else{
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(s->value);
+        s->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief consume the value in place and release the slot, only the consumer thread
+     * @param consume - void(T& value)
+     * @return false if the ring is empty, or the producer which claimed the next
+     * slot has not filled it yet( the value will be seen by the next pop)
+     */
+    template<class consumer>
+    bool pop(consumer&& consume)
+    {
+        slot* s = &slots_[dequeue_pos_ & mask_];
+        std::size_t seq = s->sequence.load(std::memory_order_acquire);
+        if (seq != dequeue_pos_ + 1){
+            return false;
+        }
+
+        consume(s->value);
+        s->sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+
+        return true;
+    }
+
+    /**
+     * @brief is the ring empty, only the consumer thread
+     */
+    bool empty()
+    {
+        slot* s = &slots_[dequeue_pos_ & mask_];
+        return s->sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+};
+}
+}
+
+#endif
@@ -0,0 +1,261 @@
+﻿/**
+ *
+ * redis_cache_loader.hpp
+ *
+ * the read-through cache, get the value or compute it by the loader,
+ * with the rebuild lock and the probabilistic early recomputation( xfetch)
+ * to avoid the recompute storm when the hot key expired
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2019-01-10
+ */
+
+#ifndef __ydk_rediscpp_redis_utils_redis_cache_loader_hpp
+#define __ydk_rediscpp_redis_utils_redis_cache_loader_hpp
+
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <functional>
+#include <redis_cpp/detail/sync/redis_sync_operator.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <utils/redis_lock.hpp>
+
+namespace redis_cpp
+{
+namespace utils {
+
+struct cache_loader_option {
+    int32_t ttl;            // the value is fresh in ttl, in milliseconds
+    int32_t stale_time;     // the value is kept and served stale after ttl while rebuilding, in milliseconds
+    double  beta;           // > 1.0 recompute earlier, < 1.0 later, 0 disable the early recomputation
+    int32_t lock_ttl;       // the rebuild lock ttl, should be longer than the compute, in milliseconds
+    int32_t lock_time_out;  // wait the rebuild of others time out if no value cached, in milliseconds
+
+    cache_loader_option()
+        : ttl(60000)
+        , stale_time(10000)
+        , beta(1.0)
+        , lock_ttl(10000)
+        , lock_time_out(3000) {
+    }
+};
+
+// read-through cache with stampede protection
+class cache_loader
+{
+public:
+    /** compute the value of the key, return false if failed( not cached) */
+    typedef std::function<bool(const std::string& key, std::string& value)> loader_type;
+
+protected:
+    // the cached value with the expiry and compute time, "expiry:delta:value"
+    struct cache_entry {
+        int64_t     expiry;     // the logical expiry, unix time in milliseconds
+        int64_t     delta;      // the time of compute, in milliseconds
+        std::string value;
+    };
+
+protected:
+    detail::redis_sync_operator*    m_redis_op;
+    cache_loader_option             m_option;
+    redis_lock_notifier*            m_notifier;
+    std::string                     m_requestor_prefix;
+    std::mutex                      m_mtx;
+    std::mt19937_64                 m_random;
+    uint64_t                        m_sequence;
+
+public:
+    /**
+     * @brief
+     * @param op        : redis_operator
+     * @param option    : the cache option
+     * @param notifier  : wake the waiters of the rebuild lock by the release notification, if not null
+     */
+    cache_loader(detail::redis_sync_operator* op,
+        const cache_loader_option& option = cache_loader_option(),
+        redis_lock_notifier* notifier = nullptr)
+        : m_redis_op(op)
+        , m_option(option)
+        , m_notifier(notifier)
+        , m_random(std::random_device()())
+        , m_sequence(0) {
+
+        m_requestor_prefix = std::to_string(m_random()) + ":";
+    }
+
+    ~cache_loader() {
+    }
+
+    /**
+     * @brief get the value of the key, compute and cache it by the loader if
+     * missed or expired. only one caller rebuild the key at the same time, the
+     * others get the stale value, or wait the rebuild if nothing cached
+     * @return false if the value not cached and the loader failed
+     */
+    bool    get(const std::string& key, std::string& value, const loader_type& loader) {
+        cache_entry entry;
+        bool cached = read(key, entry);
+        if (cached && !should_recompute(entry)) {
+            value.swap(entry.value);
+            return true;
+        }
+
+        std::string lock_key = rebuild_lock_key(key);
+        redis_lock locker(m_redis_op, lock_key, next_requestor_id(), m_option.lock_ttl,
+            m_option.lock_time_out, m_notifier);
+
+        if (cached) {
+            // someone is rebuilding, serve the stale value
+            if (!locker.try_lock()) {
+                value.swap(entry.value);
+                return true;
+            }
+        }
+        else {
+            if (!locker.lock()) {
+                // the rebuild of others may be finished just now
+                if (read(key, entry)) {
+                    value.swap(entry.value);
+                    return true;
+                }
+
+                rds_log_warn("cache_loader[%p] wait rebuild of key[%s] time out.", this, key.c_str());
+                return false;
+            }
+
+            // rebuilt by others while waiting the lock
+            if (read(key, entry) && now_time() < entry.expiry) {
+                locker.unlock();
+                value.swap(entry.value);
+                return true;
+            }
+        }
+
+        bool loaded = load(key, value, loader);
+        locker.unlock();
+
+        if (!loaded && cached) {
+            // keep serving the stale value if the loader failed
+            value.swap(entry.value);
+            return true;
+        }
+
+        return loaded;
+    }
+
+    /**
+     * @brief set the value of the key directly, like write through
+     */
+    bool    set(const std::string& key, const std::string& value) {
+        return store(key, value, 0);
+    }
+
+    /**
+     * @brief remove the cached value, the next get will rebuild
+     * @return true if the value was cached
+     */
+    bool    invalidate(const std::string& key) {
+        return m_redis_op->del(key.c_str()) > 0;
+    }
+
+protected:
+    bool    load(const std::string& key, std::string& value, const loader_type& loader) {
+        auto start = std::chrono::steady_clock::now();
+        if (!loader(key, value)) {
+            rds_log_error("cache_loader[%p] load key[%s] failed.", this, key.c_str());
+            return false;
+        }
+
+        int64_t delta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        store(key, value, delta);
+
+        return true;
+    }
+
+    /** the value and the metadata set by psetex atomically */
+    bool    store(const std::string& key, const std::string& value, int64_t delta) {
+        std::string data = std::to_string(now_time() + m_option.ttl) + ":" + std::to_string(delta) + ":";
+        data.append(value);
+
+        return m_redis_op->psetex(key.c_str(), data.c_str(), (int32_t)data.size(),
+            m_option.ttl + m_option.stale_time);
+    }
+
+    bool    read(const std::string& key, cache_entry& entry) {
+        std::string data;
+        if (!m_redis_op->get(key.c_str(), data)) {
+            return false;
+        }
+
+        std::size_t first = data.find(':');
+        std::size_t second = (first == std::string::npos) ? first : data.find(':', first + 1);
+        if (second == std::string::npos) {
+            // not set by the loader, rebuild it
+            return false;
+        }
+
+        long long expiry = 0;
+        long long delta = 0;
+        if (sscanf(data.c_str(), "%lld:%lld:", &expiry, &delta) != 2) {
+            return false;
+        }
+
+        entry.expiry = expiry;
+        entry.delta = delta;
+        entry.value = data.substr(second + 1);
+
+        return true;
+    }
+
+    /**
+     * @brief xfetch, recompute before the expiry with the probability increase
+     * when the expiry approaching, the longer compute the earlier
+     */
+    bool    should_recompute(const cache_entry& entry) {
+        int64_t now = now_time();
+        if (now >= entry.expiry) {
+            return true;
+        }
+
+        if (m_option.beta <= 0.0) {
+            return false;
+        }
+
+        double r = 0.0;
+        {
+            std::lock_guard<std::mutex> locker(m_mtx);
+            r = std::uniform_real_distribution<double>(0.0, 1.0)(m_random);
+        }
+        if (r <= 0.0) {
+            return true;
+        }
+
+        double gap = -(double)std::max<int64_t>(entry.delta, 1) * m_option.beta * std::log(r);
+        return (double)now + gap >= (double)entry.expiry;
+    }
+
+    std::string rebuild_lock_key(const std::string& key) {
+        return key + ":rebuild";
+    }
+
+    std::string next_requestor_id() {
+        std::lock_guard<std::mutex> locker(m_mtx);
+        return m_requestor_prefix + std::to_string(++m_sequence);
+    }
+
+    static int64_t now_time() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
+
+}
+}
+
+#endif
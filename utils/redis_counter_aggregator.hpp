@@ -0,0 +1,324 @@
+﻿/**
+ *
+ * redis_counter_aggregator.hpp
+ *
+ * write combining of the counters( incrby, hincrby, zincrby), the deltas are
+ * accumulated locally and flushed by pipeline periodically or when too many
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2019-01-12
+ */
+
+#ifndef __ydk_rediscpp_redis_utils_redis_counter_aggregator_hpp
+#define __ydk_rediscpp_redis_utils_redis_counter_aggregator_hpp
+
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <redis_cpp/detail/sync/base_sync_client.hpp>
+#include <redis_cpp/detail/sync/standalone_sync_client.hpp>
+#include <redis_cpp/detail/redis_slot.hpp>
+#include <redis_cpp/internal/logger_handler.hpp>
+#include <utility/asio_base/timer.hpp>
+
+namespace redis_cpp
+{
+namespace utils {
+
+struct counter_aggregator_option {
+    int32_t flush_interval;     // the max time the deltas kept locally, in milliseconds
+    int32_t max_pending;        // flush when the pending counters reach it
+    int32_t shard_count;        // the shards of the pending counters, less lock contention
+
+    counter_aggregator_option()
+        : flush_interval(100)
+        , max_pending(10000)
+        , shard_count(16) {
+    }
+};
+
+// accumulate the counter deltas, flush them by pipeline
+class counter_aggregator
+{
+protected:
+    enum counter_type {
+        counter_incrby = 0,
+        counter_hincrby,
+        counter_zincrby,
+    };
+
+    struct counter_entry {
+        counter_type    type;
+        std::string     key;
+        std::string     field;      // the hash field or the zset member
+        int64_t         delta;
+        double          score_delta;
+    };
+
+    struct shard {
+        std::mutex                                      mtx;
+        std::unordered_map<std::string, counter_entry>  counters;
+    };
+
+    // the commands sent to one node by one pipeline
+    struct node_batch {
+        detail::standalone_sync_client*     client;
+        std::vector<detail::redis_command>  cmds;
+        std::vector<int32_t>                slots;
+
+        node_batch() : client(nullptr) {
+        }
+    };
+
+    // shared with the timer handler, which may run after destroyed
+    struct timer_guard {
+        std::mutex  mtx;        // held while the handler running
+        bool        stopped;
+
+        timer_guard() : stopped(false) {
+        }
+    };
+    typedef std::shared_ptr<timer_guard> timer_guard_ptr;
+
+protected:
+    detail::base_sync_client*           m_sync_client;
+    counter_aggregator_option           m_option;
+    std::vector<std::unique_ptr<shard>> m_shards;
+    std::atomic<int32_t>                m_pending_count;
+    std::mutex                          m_flush_mtx;
+    utility::asio_base::timer::ptr      m_timer;
+    timer_guard_ptr                     m_timer_guard;
+
+public:
+    /**
+     * @brief
+     * @param io_service : the io_service to run the flush timer
+     * @param client : the sync client( or pool, or cluster client) to flush the counters
+     * @param option : the flush option
+     */
+    counter_aggregator(asio::io_service& io_service, detail::base_sync_client* client,
+        const counter_aggregator_option& option = counter_aggregator_option())
+        : m_sync_client(client)
+        , m_option(option) {
+        m_pending_count = 0;
+
+        int32_t shard_count = std::max<int32_t>(m_option.shard_count, 1);
+        for (int32_t i = 0; i < shard_count; ++i) {
+            m_shards.push_back(std::unique_ptr<shard>(new shard()));
+        }
+
+        m_timer_guard = std::make_shared<timer_guard>();
+        m_timer = utility::asio_base::timer::create(io_service);
+        m_timer->register_handler(
+            std::bind(&counter_aggregator::flush_timer_handler,
+            this, m_timer_guard, std::placeholders::_1, std::placeholders::_2));
+        m_timer->start(m_option.flush_interval);
+    }
+
+    /** the pending deltas are flushed before destroyed, after the running timer handler */
+    ~counter_aggregator() {
+        {
+            std::lock_guard<std::mutex> locker(m_timer_guard->mtx);
+            m_timer_guard->stopped = true;
+            m_timer->cancel();
+        }
+
+        flush();
+    }
+
+    void    incrby(const std::string& key, int64_t delta) {
+        add(counter_incrby, key, std::string(), delta, 0.0);
+    }
+
+    void    hincrby(const std::string& key, const std::string& field, int64_t delta) {
+        add(counter_hincrby, key, field, delta, 0.0);
+    }
+
+    void    zincrby(const std::string& key, const std::string& member, double delta) {
+        add(counter_zincrby, key, member, 0, delta);
+    }
+
+    /** the count of the counters not flushed */
+    int32_t pending_count() {
+        return m_pending_count;
+    }
+
+    /**
+     * @brief send the pending deltas now, one pipeline per node
+     */
+    void    flush() {
+        std::lock_guard<std::mutex> flush_locker(m_flush_mtx);
+
+        std::vector<counter_entry> entries;
+        for (auto& s : m_shards) {
+            std::lock_guard<std::mutex> locker(s->mtx);
+            for (auto& iter : s->counters) {
+                entries.push_back(std::move(iter.second));
+            }
+            m_pending_count -= (int32_t)s->counters.size();
+            s->counters.clear();
+        }
+
+        if (entries.empty()) {
+            return;
+        }
+
+        // group by slot, then by the node of the slot
+        bool cluster = m_sync_client->cluster_mode();
+        std::map<int32_t, std::vector<detail::redis_command>> slot_cmds;
+        for (auto& entry : entries) {
+            if (entry.delta == 0 && entry.score_delta == 0.0) {
+                continue;
+            }
+
+            int32_t slot = cluster ? detail::redis_slot::slot(entry.key.c_str()) : -1;
+            slot_cmds[slot].push_back(make_command(entry));
+        }
+
+        std::map<std::string, node_batch> batches;
+        for (auto& iter : slot_cmds) {
+            detail::standalone_sync_client* client = m_sync_client->acquire_client(iter.first);
+            if (!client) {
+                rds_log_error("counter_aggregator[%p] acquire client of slot[%d] failed, [%d] counters lost.",
+                    this, iter.first, (int32_t)iter.second.size());
+                continue;
+            }
+
+            node_batch& batch = batches[client->get_uri_string()];
+            if (batch.client) {
+                client->release(true);
+            }
+            else {
+                batch.client = client;
+            }
+
+            for (auto& cmd : iter.second) {
+                batch.cmds.push_back(std::move(cmd));
+                batch.slots.push_back(iter.first);
+            }
+        }
+
+        for (auto& iter : batches) {
+            flush_batch(iter.second);
+        }
+    }
+
+protected:
+    void    add(counter_type type, const std::string& key, const std::string& field,
+        int64_t delta, double score_delta) {
+        std::string id = std::to_string((int32_t)type) + ":" + std::to_string(key.size()) + ":" + key + field;
+        shard& s = *m_shards[std::hash<std::string>()(id) % m_shards.size()];
+
+        bool added = false;
+        {
+            std::lock_guard<std::mutex> locker(s.mtx);
+            auto iter = s.counters.find(id);
+            if (iter == s.counters.end()) {
+                counter_entry& entry = s.counters[id];
+                entry.type = type;
+                entry.key = key;
+                entry.field = field;
+                entry.delta = delta;
+                entry.score_delta = score_delta;
+                added = true;
+            }
+            else {
+                iter->second.delta += delta;
+                iter->second.score_delta += score_delta;
+            }
+        }
+
+        if (added && ++m_pending_count >= m_option.max_pending) {
+            // skip if flushing by others
+            std::unique_lock<std::mutex> flush_locker(m_flush_mtx, std::try_to_lock);
+            if (flush_locker.owns_lock()) {
+                flush_locker.unlock();
+                flush();
+            }
+        }
+    }
+
+    void    flush_batch(node_batch& batch) {
+        std::vector<redis_reply_ptr> replies;
+        if (!batch.client->do_pipeline(batch.cmds, replies)) {
+            // not resent, the counters may be increased already
+            batch.client->release(false);
+            rds_log_error("counter_aggregator[%p] flush to [%s] failed, [%d] counters lost.",
+                this, batch.client->get_uri_string().c_str(), (int32_t)batch.cmds.size());
+            return;
+        }
+        batch.client->release(true);
+
+        for (std::size_t i = 0; i < replies.size(); ++i) {
+            if (!replies[i]->is_error()) {
+                continue;
+            }
+
+            // the rejected command is not applied, resend by the client to follow the redirection
+            redis_reply_ptr reply = replies[i];
+            if (m_sync_client->cluster_mode()) {
+                reply = m_sync_client->do_command(batch.cmds[i], batch.slots[i]);
+            }
+
+            if (!reply || reply->is_error()) {
+                rds_log_error("counter_aggregator[%p] flush command[%s] failed, error[%s].",
+                    this, batch.cmds[i].to_debug_string().c_str(),
+                    reply ? reply->to_error().msg.c_str() : "");
+            }
+        }
+    }
+
+    static detail::redis_command make_command(const counter_entry& entry) {
+        switch (entry.type) {
+        case counter_hincrby: {
+            detail::redis_command cmd("hincrby");
+            cmd.add_param(entry.key);
+            cmd.add_param(entry.field);
+            cmd.add_param(entry.delta);
+            return cmd;
+        }
+        case counter_zincrby: {
+            char score[64] = { 0 };
+            snprintf(score, sizeof(score), "%.17g", entry.score_delta);
+
+            detail::redis_command cmd("zincrby");
+            cmd.add_param(entry.key);
+            cmd.add_param(score);
+            cmd.add_param(entry.field);
+            return cmd;
+        }
+        default: {
+            detail::redis_command cmd("incrby");
+            cmd.add_param(entry.key);
+            cmd.add_param(entry.delta);
+            return cmd;
+        }
+        }
+    }
+
+    void    flush_timer_handler(timer_guard_ptr guard, utility::asio_base::timer::ptr timer_ptr,
+        const asio::error_code& error) {
+        // the handler queued before the cancel sees stopped, not touch the destroyed this
+        std::lock_guard<std::mutex> locker(guard->mtx);
+        if (error || guard->stopped) {
+            return;
+        }
+
+        flush();
+
+        timer_ptr->start(m_option.flush_interval);
+    }
+};
+
+}
+}
+
+#endif
@@ -12,21 +12,299 @@
 #define __ydk_rediscpp_redis_utils_redis_lock_hpp
 
 #include <cstdint>
+#include <algorithm>
 #include <string>
 #include <chrono>
 #include <thread>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <redis_cpp/detail/sync/redis_sync_operator.hpp>
+#include <redis_cpp/detail/async/base_async_client.hpp>
+#include <utility/asio_base/timer.hpp>
 
 namespace redis_cpp
 {
 namespace utils {
 
+/** the channel published when the lock released */
+static std::string redis_lock_release_channel(const std::string& lock_key) {
+    return lock_key + ":released";
+}
+
+/** the counter of the fencing token, in the same slot with the lock key */
+static std::string redis_lock_fence_key(const std::string& lock_key) {
+    std::size_t begin = lock_key.find('{');
+    if (begin != std::string::npos) {
+        std::size_t end = lock_key.find('}', begin + 1);
+        if (end != std::string::npos && end > begin + 1) {
+            return lock_key + ".fence";
+        }
+    }
+
+    return "{" + lock_key + "}.fence";
+}
+
+// wake the lock waiters when the lock released, by subscribe the release channel
+class redis_lock_notifier
+{
+protected:
+    struct channel_state {
+        int32_t                 waiters;
+        uint64_t                generation;
+        std::condition_variable cv;
+
+        channel_state() : waiters(0), generation(0) {
+        }
+    };
+    typedef std::shared_ptr<channel_state> channel_state_ptr;
+
+protected:
+    detail::base_async_client*                  m_async_client;
+    std::mutex                                  m_mtx;
+    std::map<std::string, channel_state_ptr>    m_channels;
+
+public:
+    /** 
+     * @brief 
+     * @param client : the async client to subscribe the release channels
+     */
+    redis_lock_notifier(detail::base_async_client* client)
+        : m_async_client(client) {
+    }
+
+    ~redis_lock_notifier() {
+        std::lock_guard<std::mutex> locker(m_mtx);
+        for (auto& iter : m_channels) {
+            m_async_client->unsubscribe(iter.first, [](redis_reply_ptr reply) {});
+        }
+        m_channels.clear();
+    }
+
+    /** 
+     * @brief start to wait the release of the channel, subscribe if the first waiter
+     * @return the current generation of the channel
+     */
+    uint64_t add_waiter(const std::string& channel) {
+        std::lock_guard<std::mutex> locker(m_mtx);
+
+        channel_state_ptr& state = m_channels[channel];
+        if (!state) {
+            state = std::make_shared<channel_state>();
+            m_async_client->subscribe(channel,
+                std::bind(&redis_lock_notifier::on_released, this, std::placeholders::_1, std::placeholders::_2),
+                [](redis_reply_ptr reply) {});
+        }
+
+        state->waiters++;
+        return state->generation;
+    }
+
+    /** stop waiting, unsubscribe if the last waiter */
+    void remove_waiter(const std::string& channel) {
+        std::lock_guard<std::mutex> locker(m_mtx);
+
+        auto iter = m_channels.find(channel);
+        if (iter == m_channels.end()) {
+            return;
+        }
+
+        if (--iter->second->waiters <= 0) {
+            m_channels.erase(iter);
+            m_async_client->unsubscribe(channel, [](redis_reply_ptr reply) {});
+        }
+    }
+
+    /** the release times of the channel observed */
+    uint64_t generation(const std::string& channel) {
+        std::lock_guard<std::mutex> locker(m_mtx);
+
+        auto iter = m_channels.find(channel);
+        return iter != m_channels.end() ? iter->second->generation : 0;
+    }
+
+    /** 
+     * @brief wait until the channel released after the generation
+     * @param timeout : in milliseconds
+     * @return false if timeout
+     */
+    bool wait(const std::string& channel, uint64_t generation, int32_t timeout) {
+        std::unique_lock<std::mutex> locker(m_mtx);
+
+        auto iter = m_channels.find(channel);
+        if (iter == m_channels.end()) {
+            return false;
+        }
+
+        channel_state_ptr state = iter->second;
+        return state->cv.wait_for(locker, std::chrono::milliseconds(timeout),
+            [&state, generation]() { return state->generation != generation; });
+    }
+
+protected:
+    void on_released(const std::string& channel, const std::string& message) {
+        std::lock_guard<std::mutex> locker(m_mtx);
+
+        auto iter = m_channels.find(channel);
+        if (iter != m_channels.end()) {
+            iter->second->generation++;
+            iter->second->cv.notify_all();
+        }
+    }
+};
+
+// renew the leases of the held locks in background
+class redis_lock_watchdog
+{
+protected:
+    enum {
+        check_interval = 100,           // in milliseconds
+    };
+
+    enum renew_result {
+        renew_ok = 0,
+        renew_lost,                     // the key expired or held by others
+        renew_failed,                   // the command failed, could retry
+    };
+
+    struct lease {
+        std::string     lock_key;
+        std::string     requestor_id;
+        int32_t         expire_time;
+        std::chrono::steady_clock::time_point next_renew_time;
+    };
+
+protected:
+    detail::redis_sync_operator         m_redis_op;
+    utility::asio_base::timer::ptr      m_timer;
+    std::mutex                          m_mtx;
+    std::map<std::string, lease>        m_leases;
+
+public:
+    /** 
+     * @brief 
+     * @param io_service : the io_service to run the renew timer
+     * @param client : the sync client to renew the leases
+     */
+    redis_lock_watchdog(asio::io_service& io_service, detail::base_sync_client* client)
+        : m_redis_op(client) {
+        m_timer = utility::asio_base::timer::create(io_service);
+        m_timer->register_handler(
+            std::bind(&redis_lock_watchdog::renew_timer_handler,
+            this, std::placeholders::_1, std::placeholders::_2));
+        m_timer->start(check_interval);
+    }
+
+    ~redis_lock_watchdog() {
+        m_timer->cancel();
+    }
+
+    /** 
+     * @brief renew the lease every 1/3 of the key ttl, until unwatch
+     * @param key_expire_time : the key ttl in milliseconds
+     */
+    void    watch(const std::string& lock_key, const std::string& requestor_id, int32_t key_expire_time) {
+        lease l;
+        l.lock_key = lock_key;
+        l.requestor_id = requestor_id;
+        l.expire_time = key_expire_time;
+        l.next_renew_time = std::chrono::steady_clock::now() + 
+            std::chrono::milliseconds(key_expire_time / 3);
+
+        std::lock_guard<std::mutex> locker(m_mtx);
+        m_leases[lease_id(lock_key, requestor_id)] = l;
+    }
+
+    void    unwatch(const std::string& lock_key, const std::string& requestor_id) {
+        std::lock_guard<std::mutex> locker(m_mtx);
+        m_leases.erase(lease_id(lock_key, requestor_id));
+    }
+
+    /** 
+     * @brief extend the lease if still held by the requestor
+     */
+    static renew_result renew(detail::redis_sync_operator* op, const std::string& lock_key, 
+        const std::string& requestor_id, int32_t key_expire_time) {
+        static const detail::redis_cached_script renew_script(
+            "if redis.call('get', KEYS[1]) == ARGV[1] then return redis.call('pexpire', KEYS[1], ARGV[2]) else return 0 end");
+
+        std::vector<std::string> keys;
+        std::vector<std::string> args;
+
+        keys.push_back(lock_key);
+        args.push_back(requestor_id);
+        args.push_back(std::to_string(key_expire_time));
+        auto reply = op->eval(renew_script, keys, args);
+        if (!reply || !reply->is_integer()) {
+            return renew_failed;
+        }
+
+        return reply->to_integer() == 1 ? renew_ok : renew_lost;
+    }
+
+protected:
+    static std::string lease_id(const std::string& lock_key, const std::string& requestor_id) {
+        return lock_key + '\n' + requestor_id;
+    }
+
+    void    renew_leases() {
+        auto now = std::chrono::steady_clock::now();
+
+        std::vector<lease> due_leases;
+        {
+            std::lock_guard<std::mutex> locker(m_mtx);
+            for (auto& iter : m_leases) {
+                if (iter.second.next_renew_time <= now) {
+                    due_leases.push_back(iter.second);
+                }
+            }
+        }
+
+        for (auto& l : due_leases) {
+            renew_result result = renew(&m_redis_op, l.lock_key, l.requestor_id, l.expire_time);
+
+            std::lock_guard<std::mutex> locker(m_mtx);
+            auto iter = m_leases.find(lease_id(l.lock_key, l.requestor_id));
+            if (iter == m_leases.end()) {
+                continue;
+            }
+
+            if (result == renew_ok) {
+                iter->second.next_renew_time = std::chrono::steady_clock::now() + 
+                    std::chrono::milliseconds(l.expire_time / 3);
+            }
+            else if (result == renew_lost) {
+                // no use to renew any more
+                rds_log_warn("redis_lock_watchdog lock[%s] requestor[%s] lost, stop renew.",
+                    l.lock_key.c_str(), l.requestor_id.c_str());
+                m_leases.erase(iter);
+            }
+            else {
+                // retry at next check
+                rds_log_warn("redis_lock_watchdog renew lock[%s] requestor[%s] failed.",
+                    l.lock_key.c_str(), l.requestor_id.c_str());
+            }
+        }
+    }
+
+    void    renew_timer_handler(utility::asio_base::timer::ptr timer_ptr, const asio::error_code& error) {
+        if (error) {
+            return;
+        }
+
+        renew_leases();
+
+        timer_ptr->start(check_interval);
+    }
+};
+
 // redis distribute lock
 class redis_lock
 {
 protected:
     enum {
-        try_lock_interval = 100,        // in milliseconds
+        try_lock_interval = 100,        // in milliseconds, also the fallback while waiting the release notification
     };
 protected:
     detail::redis_sync_operator*    m_redis_op;
@@ -34,6 +312,11 @@ protected:
     std::string                     m_lock_requestor_id;
     int32_t                         m_key_expired_time;
     int32_t                         m_locked_time_out;
+    redis_lock_notifier*            m_notifier;
+    redis_lock_watchdog*            m_watchdog;
+    int64_t                         m_fencing_token;
+    bool                            m_fenced;
+    bool                            m_watched;
 
 public:
     /** 
@@ -43,50 +326,158 @@ public:
      * @param requestor_id : the lock requestor
      * @param key_expire_time : the key ttl in milliseconds
      * @param locked_time_out : try get the lock time out( in milliseconds)
+     * @param notifier  : wake up by the release notification instead of polling, if not null
+     * @param watchdog  : renew the key ttl while the lock held, if not null
+     * @param fenced    : get the fencing token when locked, the counter key
+     * redis_lock_fence_key( no ttl) is kept for each lock key
      */
     redis_lock(detail::redis_sync_operator* op, 
         const std::string& lock_key, 
         const std::string& requestor_id, 
         int32_t key_expire_time, 
-        int32_t locked_time_out)
+        int32_t locked_time_out,
+        redis_lock_notifier* notifier = nullptr,
+        redis_lock_watchdog* watchdog = nullptr,
+        bool fenced = false)
         : m_redis_op(op)
         , m_lock_key(lock_key)
         , m_lock_requestor_id(requestor_id)
         , m_key_expired_time(key_expire_time)
-        , m_locked_time_out(locked_time_out){
+        , m_locked_time_out(locked_time_out)
+        , m_notifier(notifier)
+        , m_watchdog(watchdog)
+        , m_fencing_token(0)
+        , m_fenced(fenced)
+        , m_watched(false){
     }
 
     ~redis_lock() {
+        stop_watch();
     }
 
     bool    lock() {
-        int32_t timeout = m_locked_time_out;
-        while (timeout >= 0) {
+        if (try_lock()) {
+            return true;
+        }
+
+        std::string channel;
+        if (m_notifier) {
+            channel = redis_lock_release_channel(m_lock_key);
+            m_notifier->add_waiter(channel);
+        }
+
+        bool locked = false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_locked_time_out);
+        for (;;) {
+            // get the generation before try, so the release between try and wait is not missed
+            uint64_t generation = m_notifier ? m_notifier->generation(channel) : 0;
 
             // get lock
-            if (m_redis_op->setnxpx(m_lock_key.c_str(), m_lock_requestor_id, m_key_expired_time)) {
-                return true;
+            if (try_lock()) {
+                locked = true;
+                break;
+            }
+
+            auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remain < 0) {
+                break;
+            }
+
+            if (m_notifier) {
+                // the release may be missed, like the key expired
+                m_notifier->wait(channel, generation, 
+                    (int32_t)std::min<int64_t>(remain, try_lock_interval));
             }
+            else {
+                // sleep for a while
+                std::this_thread::sleep_for(std::chrono::milliseconds(
+                    std::min<int64_t>(remain, try_lock_interval)));
+            }
+        }
 
-            // sleep for a while
-            std::this_thread::sleep_for(std::chrono::milliseconds(try_lock_interval));
-            timeout -= try_lock_interval;
+        if (m_notifier) {
+            m_notifier->remove_waiter(channel);
         }
 
-        return false;
+        return locked;
+    }
+
+    /** 
+     * @brief try get the lock once
+     */
+    bool    try_lock() {
+        if (m_fenced) {
+            if (!try_lock_fenced()) {
+                return false;
+            }
+        }
+        else if (!m_redis_op->setnxpx(m_lock_key.c_str(), m_lock_requestor_id, m_key_expired_time)) {
+            return false;
+        }
+
+        if (m_watchdog) {
+            m_watchdog->watch(m_lock_key, m_lock_requestor_id, m_key_expired_time);
+            m_watched = true;
+        }
+
+        return true;
     }
 
     bool    unlock() {
-        std::string del_lock_script = "if redis.call('get', KEYS[1]) == ARGV[1] then return redis.call('del', KEYS[1]) else return 0 end";
+        stop_watch();
+
+        // only the sha1 is sent by evalsha
+        static const detail::redis_cached_script del_lock_script(
+            "if redis.call('get', KEYS[1]) == ARGV[1] then redis.call('del', KEYS[1]) redis.call('publish', ARGV[2], ARGV[1]) return 1 else return 0 end");
 
         std::vector<std::string> keys;
         std::vector<std::string> args;
 
         keys.push_back(m_lock_key);
         args.push_back(m_lock_requestor_id);
-        auto reply  = m_redis_op->eval(del_lock_script.c_str(), keys, args);
+        args.push_back(redis_lock_release_channel(m_lock_key));
+        auto reply  = m_redis_op->eval(del_lock_script, keys, args);
         return reply && reply->is_integer() && reply->to_integer() == 1;
     }
+
+    /** 
+     * @brief the fencing token of the last lock, increase every time the lock acquired,
+     * pass it to the storage to reject the write of the stale holder. only for the
+     * fenced lock, 0 otherwise
+     */
+    int64_t fencing_token() {
+        return m_fencing_token;
+    }
+
+protected:
+    bool    try_lock_fenced() {
+        // set the key and get the next fencing token atomically
+        static const detail::redis_cached_script lock_script(
+            "if redis.call('set', KEYS[1], ARGV[1], 'NX', 'PX', ARGV[2]) then return redis.call('incr', KEYS[2]) else return 0 end");
+
+        std::vector<std::string> keys;
+        std::vector<std::string> args;
+
+        keys.push_back(m_lock_key);
+        keys.push_back(redis_lock_fence_key(m_lock_key));
+        args.push_back(m_lock_requestor_id);
+        args.push_back(std::to_string(m_key_expired_time));
+        auto reply = m_redis_op->eval(lock_script, keys, args);
+        if (!reply || !reply->is_integer() || reply->to_integer() == 0) {
+            return false;
+        }
+
+        m_fencing_token = reply->to_integer();
+        return true;
+    }
+
+    void    stop_watch() {
+        if (m_watched) {
+            m_watchdog->unwatch(m_lock_key, m_lock_requestor_id);
+            m_watched = false;
+        }
+    }
 };
 
 
@@ -101,9 +492,12 @@ public:
         const std::string& lock_key,
         const std::string& requestor_id,
         int32_t key_expire_time,
-        int32_t locked_time_out)
+        int32_t locked_time_out,
+        redis_lock_notifier* notifier = nullptr,
+        redis_lock_watchdog* watchdog = nullptr,
+        bool fenced = false)
             : m_locked(false)
-            , m_locker(op, lock_key, requestor_id, key_expire_time, locked_time_out){
+            , m_locker(op, lock_key, requestor_id, key_expire_time, locked_time_out, notifier, watchdog, fenced){
 
         m_locked = m_locker.lock();
     }
@@ -118,6 +512,10 @@ public:
     bool    islocked() {
         return m_locked;
     }
+
+    int64_t fencing_token() {
+        return m_locker.fencing_token();
+    }
 };
 
 }
@@ -0,0 +1,305 @@
+﻿/**
+ *
+ * redis_redlock.hpp
+ *
+ * the distribute lock over several independent redis masters( redlock),
+ * the lock is held while the majority of the masters locked
+ *
+ * @author  :   yandaren1220@126.com
+ * @date    :   2019-01-08
+ */
+
+#ifndef __ydk_rediscpp_redis_utils_redis_redlock_hpp
+#define __ydk_rediscpp_redis_utils_redis_redlock_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <set>
+#include <condition_variable>
+#include <redis_cpp/detail/sync/redis_sync_operator.hpp>
+#include <utility/asio_base/thread_pool.hpp>
+#include <utils/redis_lock.hpp>
+
+namespace redis_cpp
+{
+namespace utils {
+
+// redis distribute lock over independent masters
+class redis_redlock
+{
+protected:
+    enum {
+        try_lock_interval = 100,        // the max random delay before retry, in milliseconds
+        clock_drift_factor = 100,       // the clock drift is 1/100 of the key ttl
+        request_time_out_factor = 100,  // wait the masters 1/100 of the key ttl by default
+        min_request_time_out = 10,      // in milliseconds
+    };
+
+    // the results of one round on all the masters
+    struct round_state {
+        std::mutex              mtx;
+        std::condition_variable cv;
+        int32_t                 remaining;
+        std::vector<bool>       results;
+    };
+    typedef std::shared_ptr<round_state> round_state_ptr;
+
+    // the start time( in milliseconds) of the requests running on the executor of each
+    // master, shared by all the redlocks
+    struct inflight_requests {
+        std::mutex                                                  mtx;
+        std::map<detail::base_sync_client*, std::multiset<int64_t>> starts;
+    };
+
+protected:
+    std::vector<detail::base_sync_client*>  m_clients;
+    utility::asio_base::thread_pool*        m_executor;
+    std::string                             m_lock_key;
+    std::string                             m_lock_requestor_id;
+    int32_t                                 m_key_expired_time;
+    int32_t                                 m_locked_time_out;
+    int32_t                                 m_request_time_out;
+    int32_t                                 m_validity_time;
+
+public:
+    /**
+     * @brief
+     * @param clients   : the clients of the independent masters
+     * @param executor  : run the commands of the masters in parallel, should have
+     * at least the same threads as the masters
+     * @param lock_key  : the redis key
+     * @param requestor_id : the lock requestor
+     * @param key_expire_time : the key ttl in milliseconds
+     * @param locked_time_out : try get the lock time out( in milliseconds)
+     * @param request_time_out : wait the replies of the masters in one round( in milliseconds),
+     * small compared to the key ttl so a dead master not eat the validity, 0 means 1/100 of the ttl
+     */
+    redis_redlock(const std::vector<detail::base_sync_client*>& clients,
+        utility::asio_base::thread_pool* executor,
+        const std::string& lock_key,
+        const std::string& requestor_id,
+        int32_t key_expire_time,
+        int32_t locked_time_out,
+        int32_t request_time_out = 0)
+        : m_clients(clients)
+        , m_executor(executor)
+        , m_lock_key(lock_key)
+        , m_lock_requestor_id(requestor_id)
+        , m_key_expired_time(key_expire_time)
+        , m_locked_time_out(locked_time_out)
+        , m_request_time_out(request_time_out > 0 ? request_time_out :
+            std::max<int32_t>(key_expire_time / request_time_out_factor, min_request_time_out))
+        , m_validity_time(0) {
+    }
+
+    ~redis_redlock() {
+    }
+
+    bool    lock() {
+        if (m_clients.empty()) {
+            return false;
+        }
+
+        int32_t quorum = (int32_t)m_clients.size() / 2 + 1;
+        int32_t drift = m_key_expired_time / clock_drift_factor + 2;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_locked_time_out);
+        for (;;) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<bool> results = run_round(true);
+
+            int32_t locked_count = 0;
+            for (auto locked : results) {
+                locked_count += locked ? 1 : 0;
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            int32_t validity = m_key_expired_time - (int32_t)elapsed - drift;
+            if (locked_count >= quorum && validity > 0) {
+                m_validity_time = validity;
+                return true;
+            }
+
+            // release everywhere, include the masters which the reply lost
+            run_round(false);
+
+            auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remain < 0) {
+                break;
+            }
+
+            // random delay, avoid the requestors split the masters again
+            int32_t delay = std::rand() % try_lock_interval + 1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(
+                std::min<int64_t>(remain, delay)));
+        }
+
+        m_validity_time = 0;
+        return false;
+    }
+
+    bool    unlock() {
+        m_validity_time = 0;
+
+        std::vector<bool> results = run_round(false);
+
+        int32_t unlocked_count = 0;
+        for (auto unlocked : results) {
+            unlocked_count += unlocked ? 1 : 0;
+        }
+
+        return unlocked_count >= (int32_t)m_clients.size() / 2 + 1;
+    }
+
+    /**
+     * @brief the time in milliseconds the lock is sure to be held after locked,
+     * the ttl minus the time of locking and the clock drift
+     */
+    int32_t validity_time() {
+        return m_validity_time;
+    }
+
+protected:
+    /**
+     * @brief lock( or unlock) all the masters in parallel, wait at most the request time out
+     * @return the result of each master, false if not replied in time( the late lock
+     * expires with the key ttl, or released by the next round)
+     */
+    std::vector<bool> run_round(bool lock) {
+        round_state_ptr state = std::make_shared<round_state>();
+        state->remaining = (int32_t)m_clients.size();
+        state->results.resize(m_clients.size(), false);
+
+        for (std::size_t i = 0; i < m_clients.size(); ++i) {
+            detail::base_sync_client* client = m_clients[i];
+
+            // the sync request has no time out, not post more requests to the frozen
+            // master to block the executor threads, failed at once until they returned
+            int64_t start_time = 0;
+            if (!begin_request(client, m_request_time_out, start_time)) {
+                std::lock_guard<std::mutex> locker_guard(state->mtx);
+                --state->remaining;
+                continue;
+            }
+
+            std::string lock_key = m_lock_key;
+            std::string requestor_id = m_lock_requestor_id;
+            int32_t expire_time = m_key_expired_time;
+
+            m_executor->io_service().post([state, i, client, lock_key, requestor_id, expire_time, lock, start_time]() {
+                // the same requestor id and compare-and-delete as the single master lock
+                detail::redis_sync_operator op(client);
+                redis_lock locker(&op, lock_key, requestor_id, expire_time, 0);
+                bool ret = lock ? locker.try_lock() : locker.unlock();
+                end_request(client, start_time);
+
+                std::lock_guard<std::mutex> locker_guard(state->mtx);
+                state->results[i] = ret;
+                if (--state->remaining == 0) {
+                    state->cv.notify_one();
+                }
+            });
+        }
+
+        std::unique_lock<std::mutex> locker(state->mtx);
+        state->cv.wait_for(locker, std::chrono::milliseconds(m_request_time_out),
+            [&state]() { return state->remaining == 0; });
+
+        return state->results;
+    }
+
+    static inflight_requests& inflight() {
+        static inflight_requests requests;
+        return requests;
+    }
+
+    static int64_t now_milliseconds() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief false if a request to the master not returned over the request time out
+     */
+    static bool begin_request(detail::base_sync_client* client, int32_t request_time_out, int64_t& start_time) {
+        inflight_requests& requests = inflight();
+        std::lock_guard<std::mutex> locker(requests.mtx);
+
+        start_time = now_milliseconds();
+        std::multiset<int64_t>& starts = requests.starts[client];
+        if (!starts.empty() && *starts.begin() + request_time_out < start_time) {
+            return false;
+        }
+
+        starts.insert(start_time);
+        return true;
+    }
+
+    static void end_request(detail::base_sync_client* client, int64_t start_time) {
+        inflight_requests& requests = inflight();
+        std::lock_guard<std::mutex> locker(requests.mtx);
+
+        auto iter = requests.starts.find(client);
+        if (iter == requests.starts.end()) {
+            return;
+        }
+
+        auto start = iter->second.find(start_time);
+        if (start != iter->second.end()) {
+            iter->second.erase(start);
+        }
+        if (iter->second.empty()) {
+            requests.starts.erase(iter);
+        }
+    }
+};
+
+// redis distribute auto redlock
+class redis_auto_redlock
+{
+protected:
+    bool            m_locked;
+    redis_redlock   m_locker;
+public:
+    redis_auto_redlock(const std::vector<detail::base_sync_client*>& clients,
+        utility::asio_base::thread_pool* executor,
+        const std::string& lock_key,
+        const std::string& requestor_id,
+        int32_t key_expire_time,
+        int32_t locked_time_out,
+        int32_t request_time_out = 0)
+            : m_locked(false)
+            , m_locker(clients, executor, lock_key, requestor_id, key_expire_time, locked_time_out, request_time_out) {
+
+        m_locked = m_locker.lock();
+    }
+
+    ~redis_auto_redlock() {
+        if (m_locked) {
+            m_locker.unlock();
+            m_locked = false;
+        }
+    }
+
+    bool    islocked() {
+        return m_locked;
+    }
+
+    int32_t validity_time() {
+        return m_locker.validity_time();
+    }
+};
+
+}
+}
+
+#endif